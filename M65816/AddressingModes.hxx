@@ -1,10 +1,17 @@
+/**
+ * The addressing modes compute operand_ea, the 24-bit linear address of
+ * the operand. Indexing is done on the full 24 bits, so that a carry out
+ * of the address moves into the next bank; the direct page and stack
+ * relative modes only ever produce bank 0 addresses.
+ */
+
 /**
  * If the CPU is in emulation mode, and the low byte of D is 0x00,
  * then wrap the address at the DP boundary.
  */
 uint16_t wrapDirectPage(uint16_t address)
 {
-    if (!(D & 0xFF) && StackOffset) {
+    if (DirectPageAligned && StackOffset) {
         return (D & 0xFF00) | (address & 0xFF);
     }
     else {
@@ -12,72 +19,76 @@ uint16_t wrapDirectPage(uint16_t address)
     }
 }
 
+// Combine a bank and an address into a linear address
+static constexpr uint32_t linearAddress(const uint8_t bank, const uint16_t address)
+{
+    return (bank << 16) | address;
+}
+
+// Add an index register to a linear address, wrapping at the top of memory
+static constexpr uint32_t indexAddress(const uint32_t ea, const uint16_t index)
+{
+    return (ea + index) & 0xFFFFFF;
+}
+
 void getAddress_a()
 {
-    operand_addr = system->cpuRead(PBR, PC++, INSTR) | (system->cpuRead(PBR, PC++, INSTR) << 8);
-    operand_bank = DBR;
+    operand_ea = linearAddress(DBR, fetchInstructionWord());
 }
 
 void getAddress_al()
 {
-    operand_addr = system->cpuRead(PBR, PC++, INSTR) | (system->cpuRead(PBR, PC++, INSTR) << 8);
-    operand_bank = system->cpuRead(PBR, PC++, INSTR);
+    operand_ea = fetchInstructionLong();
 }
 
 void getAddress_d()
 {
     checkDirectPageAlignment();
 
-    operand_addr = wrapDirectPage(D + system->cpuRead(PBR, PC++, INSTR));
-    operand_bank = 0;
+    operand_ea = wrapDirectPage(D + fetchInstructionByte());
+
+    mapDirectWindow(operand_ea);
 }
 
 void getAddress_dix()
 {
     checkDirectPageAlignment();
 
-    uint16_t tmp = D + system->cpuRead(PBR, PC++, INSTR);
-    uint8_t lo = system->cpuRead(0, wrapDirectPage(tmp), OPADDR);
-    uint8_t hi = system->cpuRead(0, wrapDirectPage(tmp + 1), OPADDR);
+    uint16_t tmp = D + fetchInstructionByte();
+    uint8_t lo = readDirectByte(wrapDirectPage(tmp));
+    uint8_t hi = readDirectByte(wrapDirectPage(tmp + 1));
 
-    operand_addr = lo | (hi << 8);
-    operand_bank = DBR;
+    tmp = lo | (hi << 8);
 
-    tmp = operand_addr;
-    operand_addr += Y;
-
-    if (operand_addr < tmp) operand_bank++;
+    operand_ea = indexAddress(linearAddress(DBR, tmp), Y);
 
     checkDataPageCross(tmp);
 }
 
 void getAddress_dixl()
 {
-    uint16_t tmp = D + system->cpuRead(PBR, PC++, INSTR);
+    uint16_t tmp = D + fetchInstructionByte();
 
     checkDirectPageAlignment();
 
-    operand_addr = system->cpuRead(0, tmp, OPADDR) | (system->cpuRead(0, tmp + 1, OPADDR) << 8);
-    operand_bank = system->cpuRead(0, tmp + 2, OPADDR);
+    uint32_t ptr = readDirectByte(tmp) | (readDirectByte(tmp + 1) << 8);
 
-    tmp = operand_addr;
-    operand_addr += Y;
+    ptr |= readDirectByte(tmp + 2) << 16;
 
-    if (operand_addr < tmp) operand_bank++;
+    operand_ea = indexAddress(ptr, Y);
 }
 
 // (DIRECT,X)
 void getAddress_dxi()
 {
-    uint16_t tmp = D + X + system->cpuRead(PBR, PC++, INSTR);
+    uint16_t tmp = D + X + fetchInstructionByte();
 
     checkDirectPageAlignment();
 
-    uint8_t lo = system->cpuRead(0, wrapDirectPage(tmp) , OPADDR);
-    uint8_t hi = system->cpuRead(0, wrapDirectPage(tmp + 1), OPADDR);
+    uint8_t lo = readDirectByte(wrapDirectPage(tmp));
+    uint8_t hi = readDirectByte(wrapDirectPage(tmp + 1));
 
-    operand_addr = lo | (hi << 8);
-    operand_bank = DBR;
+    operand_ea = linearAddress(DBR, lo | (hi << 8));
 }
 
 // DIRECT,X
@@ -85,10 +96,11 @@ void getAddress_dxx()
 {
     checkDirectPageAlignment();
 
-    uint8_t loc = system->cpuRead(PBR, PC++, INSTR);
+    uint8_t loc = fetchInstructionByte();
+
+    operand_ea = wrapDirectPage(D + loc + X);
 
-    operand_addr = wrapDirectPage(D + loc + X);
-    operand_bank = 0;
+    mapDirectWindow(operand_ea);
 }
 
 // DIRECT,Y
@@ -96,142 +108,107 @@ void getAddress_dxy()
 {
     checkDirectPageAlignment();
 
-    uint8_t loc = system->cpuRead(PBR, PC++, INSTR);
+    uint8_t loc = fetchInstructionByte();
+
+    operand_ea = wrapDirectPage(D + loc + Y);
 
-    operand_addr = wrapDirectPage(D + loc + Y);
-    operand_bank = 0;
+    mapDirectWindow(operand_ea);
 }
 
 void getAddress_axx()
 {
-    operand_addr = system->cpuRead(PBR, PC, INSTR) | (system->cpuRead(PBR, PC + 1, INSTR) << 8);
-    operand_bank = DBR;
+    uint16_t tmp = fetchInstructionWord();
 
-    uint16_t tmp = operand_addr;
-    operand_addr += X;
-
-    if (operand_addr < tmp) operand_bank++;
+    operand_ea = indexAddress(linearAddress(DBR, tmp), X);
 
     checkDataPageCross(tmp);
-
-    PC += 2;
 }
 
 void getAddress_axy()
 {
-    operand_addr = system->cpuRead(PBR, PC, INSTR) | (system->cpuRead(PBR, PC + 1, INSTR) << 8);
-    operand_bank = DBR;
-
-    uint16_t tmp = operand_addr;
-
-    operand_addr += Y;
+    uint16_t tmp = fetchInstructionWord();
 
-    if (operand_addr < tmp) operand_bank++;
+    operand_ea = indexAddress(linearAddress(DBR, tmp), Y);
 
     checkDataPageCross(tmp);
-
-    PC += 2;
 }
 
 void getAddress_alxx()
 {
-    uint32_t address = system->cpuRead(PBR, PC, INSTR)
-                        | (system->cpuRead(PBR, PC + 1, INSTR) << 8)
-                        | (system->cpuRead(PBR, PC + 2, INSTR) << 16);
-
-    address += X;
-
-    operand_addr = address;
-    operand_bank = address >> 16;
-
-    PC += 3;
+    operand_ea = indexAddress(fetchInstructionLong(), X);
 }
 
 void getAddress_pcr()
 {
-    int8_t offset = system->cpuRead(PBR, PC++, INSTR);
+    int8_t offset = fetchInstructionByte();
 
-    operand_addr = PC + offset;
-    operand_bank = PBR;
+    operand_ea = linearAddress(PBR, PC + offset);
 }
 
 void getAddress_pcrl()
 {
-    int16_t offset = system->cpuRead(PBR, PC++, INSTR) | (system->cpuRead(PBR, PC++, INSTR) << 8);
+    int16_t offset = fetchInstructionWord();
 
-    operand_addr = PC + offset;
-    operand_bank = PBR;
+    operand_ea = linearAddress(PBR, PC + offset);
 }
 
 void getAddress_ai()
 {
-    uint16_t tmp = system->cpuRead(PBR, PC, INSTR) | (system->cpuRead(PBR, PC + 1, INSTR) << 8);
-
-    PC += 2;
+    uint16_t tmp = fetchInstructionWord();
 
-    operand_addr = system->cpuRead(0, tmp, OPADDR) | (system->cpuRead(0, tmp + 1, OPADDR) << 8);
-    operand_bank = 0;
+    operand_ea = system->cpuRead(0, tmp, OPADDR) | (system->cpuRead(0, tmp + 1, OPADDR) << 8);
 }
 
 void getAddress_ail()
 {
-    uint16_t tmp = system->cpuRead(PBR, PC, INSTR) | (system->cpuRead(PBR, PC + 1, INSTR) << 8);
-
-    PC += 2;
+    uint16_t tmp = fetchInstructionWord();
 
-    operand_addr = system->cpuRead(0, tmp, OPADDR) | (system->cpuRead(0, tmp + 1, OPADDR) << 8);
-    operand_bank = system->cpuRead(0, tmp + 2, OPADDR);
+    operand_ea = system->cpuRead(0, tmp, OPADDR) | (system->cpuRead(0, tmp + 1, OPADDR) << 8);
+    operand_ea |= system->cpuRead(0, tmp + 2, OPADDR) << 16;
 }
 
 // (DIRECT)
 void getAddress_di()
 {
-    uint16_t tmp = D + system->cpuRead(PBR, PC++, INSTR);
+    uint16_t tmp = D + fetchInstructionByte();
 
     checkDirectPageAlignment();
 
-    uint8_t lo = system->cpuRead(0, tmp, OPADDR);
-    uint8_t hi = system->cpuRead(0, wrapDirectPage(tmp + 1), OPADDR);
+    uint8_t lo = readDirectByte(tmp);
+    uint8_t hi = readDirectByte(wrapDirectPage(tmp + 1));
 
-    operand_addr = lo | (hi << 8);
-    operand_bank = DBR;
+    operand_ea = linearAddress(DBR, lo | (hi << 8));
 }
 
 void getAddress_dil()
 {
-    uint16_t tmp = D + system->cpuRead(PBR, PC++, INSTR);
+    uint16_t tmp = D + fetchInstructionByte();
 
     checkDirectPageAlignment();
 
-    operand_addr = system->cpuRead(0, tmp, OPADDR) | (system->cpuRead(0, tmp + 1, OPADDR) << 8);
-    operand_bank = system->cpuRead(0, tmp + 2, OPADDR);
+    operand_ea = readDirectByte(tmp) | (readDirectByte(tmp + 1) << 8);
+    operand_ea |= readDirectByte(tmp + 2) << 16;
 }
 
 void getAddress_axi()
 {
-    uint16_t tmp = (system->cpuRead(PBR, PC, INSTR) | (system->cpuRead(PBR, PC + 1, INSTR) << 8)) + X;
+    uint16_t tmp = fetchInstructionWord() + X;
 
-    PC += 2;
-
-    operand_addr = system->cpuRead(PBR, tmp, OPADDR) | (system->cpuRead(PBR, tmp + 1, OPADDR) << 8);
-    operand_bank = PBR;
+    operand_ea = linearAddress(PBR, system->cpuRead(PBR, tmp, OPADDR) | (system->cpuRead(PBR, tmp + 1, OPADDR) << 8));
 }
 
 void getAddress_sr()
 {
-    operand_addr = S + system->cpuRead(PBR, PC++, INSTR) + StackOffset;
-    operand_bank = 0;
+    operand_ea = static_cast<uint16_t>(S + fetchInstructionByte() + StackOffset);
+
+    mapStackWindow(operand_ea);
 }
 
 void getAddress_srix()
 {
-    uint16_t tmp = S + system->cpuRead(PBR, PC++, INSTR) + StackOffset;
-
-    operand_addr = system->cpuRead(0, tmp, OPADDR) | (system->cpuRead(0, tmp + 1, OPADDR) << 8);
-    operand_bank = DBR;
+    uint16_t tmp = S + fetchInstructionByte() + StackOffset;
 
-    tmp = operand_addr;
-    operand_addr += Y;
+    tmp = readWindow(stack_window, tmp, OPADDR) | (readWindow(stack_window, static_cast<uint16_t>(tmp + 1), OPADDR) << 8);
 
-    if (operand_addr < tmp) operand_bank++;
+    operand_ea = indexAddress(linearAddress(DBR, tmp), Y);
 }
@@ -0,0 +1,219 @@
+/**
+ * M65816: Portable 65816 Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#include "BlockCache.h"
+
+namespace M65816 {
+
+/**
+ * Returns true if the opcode can change the PC, PBR, or CPU mode, or
+ * otherwise needs to be the last instruction in a block.
+ */
+static bool endsBlock(const unsigned int opcode)
+{
+    switch (opcode) {
+        case 0x00:  // BRK
+        case 0x02:  // COP
+        case 0x10:  // BPL
+        case 0x20:  // JSR a
+        case 0x22:  // JSL al
+        case 0x28:  // PLP
+        case 0x30:  // BMI
+        case 0x40:  // RTI
+        case 0x42:  // WDM
+        case 0x44:  // MVP
+        case 0x4C:  // JMP a
+        case 0x50:  // BVC
+        case 0x54:  // MVN
+        case 0x5C:  // JMP al
+        case 0x60:  // RTS
+        case 0x6B:  // RTL
+        case 0x6C:  // JMP (a)
+        case 0x70:  // BVS
+        case 0x7C:  // JMP (a,x)
+        case 0x80:  // BRA
+        case 0x82:  // BRL
+        case 0x90:  // BCC
+        case 0xB0:  // BCS
+        case 0xC2:  // REP
+        case 0xCB:  // WAI
+        case 0xD0:  // BNE
+        case 0xDB:  // STP
+        case 0xDC:  // JML (a)
+        case 0xE2:  // SEP
+        case 0xF0:  // BEQ
+        case 0xFB:  // XCE
+        case 0xFC:  // JSR (a,x)
+            return true;
+        default:
+            return false;
+    }
+}
+
+BlockCache::BlockCache()
+{
+    blocks = new CodeBlock[kNumBlocks];
+
+    flush();
+}
+
+BlockCache::~BlockCache()
+{
+    delete [] blocks;
+}
+
+void BlockCache::flush()
+{
+    for (unsigned int i = 0 ; i < kNumBlocks ; ++i) {
+        blocks[i].tag = kInvalidTag;
+    }
+}
+
+CodeBlock *BlockCache::lookup(const uint8_t pbr, const uint16_t pc, const unsigned int mode, const unsigned int *cycle_counts, const unsigned int *lengths, const fused_opcode_t *fused)
+{
+    const uint32_t tag = (mode << 24) | (pbr << 16) | pc;
+    CodeBlock& block = blocks[(tag ^ (tag >> 12)) & (kNumBlocks - 1)];
+
+    if ((block.tag == tag) && isValid(block)) {
+        return &block;
+    }
+
+    if (decode(block, pbr, pc, cycle_counts, lengths, fused)) {
+        block.tag = tag;
+
+        return &block;
+    }
+    else {
+        block.tag = kInvalidTag;
+
+        return nullptr;
+    }
+}
+
+/**
+ * Decode as many instructions as will fit starting at pbr:pc, and fuse
+ * any sequences found in the table of superinstructions. The code is read
+ * directly from the page contents so that decoding has no side effects on
+ * I/O or the debugger.
+ */
+bool BlockCache::decode(CodeBlock& block, const uint8_t pbr, const uint16_t pc, const unsigned int *cycle_counts, const unsigned int *lengths, const fused_opcode_t *fused)
+{
+    const unsigned int page_no = system->getReadPage(pbr, pc);
+    const uint8_t *mem = system->getReadPointer(page_no);
+
+    if (!mem) {
+        return false;
+    }
+
+    block.page           = page_no;
+    block.page_version   = system->getPageVersion(page_no);
+    block.map_generation = system->map_generation;
+    block.length         = 0;
+
+    unsigned int offset = pc & 0xFF;
+
+    while (block.length < CodeBlock::kMaxInstructions) {
+        const unsigned int opcode = mem[offset];
+        const unsigned int len    = lengths[opcode];
+
+        // Instructions that straddle a page boundary are left to the
+        // uncached path.
+        if (offset + len > 256) {
+            break;
+        }
+
+        DecodedInstruction& ins = block.instructions[block.length++];
+
+        ins.opcode  = opcode;
+        ins.cycles  = cycle_counts[opcode];
+        ins.length  = len;
+        ins.handler = nullptr;
+
+        for (unsigned int i = 1 ; i < len ; ++i) {
+            ins.operands[i - 1] = mem[offset + i];
+        }
+
+        offset += len;
+
+        if (endsBlock(opcode) || (offset == 256)) {
+            break;
+        }
+    }
+
+    fuse(block, fused);
+
+    return block.length > 0;
+}
+
+/**
+ * Returns the first superinstruction matching the instructions starting at
+ * index i in the block, or nullptr if there isn't one.
+ */
+static const fused_opcode_t *findFused(const CodeBlock& block, const unsigned int i, const fused_opcode_t *fused)
+{
+    for (const fused_opcode_t *f = fused ; f->count ; ++f) {
+        unsigned int n;
+
+        if (i + f->count > block.length) {
+            continue;
+        }
+
+        for (n = 0 ; n < f->count ; ++n) {
+            if (block.instructions[i + n].opcode != f->opcodes[n]) break;
+        }
+
+        if (n == f->count) {
+            return f;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Replace each sequence in the block that has a superinstruction with a
+ * single entry that runs the superinstruction's handler.
+ */
+void BlockCache::fuse(CodeBlock& block, const fused_opcode_t *fused)
+{
+    unsigned int n = 0;
+
+    for (unsigned int i = 0 ; i < block.length ; ++n) {
+        const fused_opcode_t *f = findFused(block, i, fused);
+        DecodedInstruction& ins = block.instructions[n];
+
+        ins = block.instructions[i++];
+
+        if (!f) {
+            continue;
+        }
+
+        // Append the rest of the sequence to the first instruction
+        unsigned int pos = ins.length - 1;
+
+        for (unsigned int k = 1 ; k < f->count ; ++k) {
+            const DecodedInstruction& next = block.instructions[i++];
+
+            ins.operands[pos++] = next.opcode;
+
+            for (unsigned int j = 1 ; j < next.length ; ++j) {
+                ins.operands[pos++] = next.operands[j - 1];
+            }
+
+            ins.cycles += next.cycles;
+            ins.length += next.length;
+        }
+
+        ins.handler = f->handler;
+    }
+
+    block.length = n;
+}
+
+} // namespace M65816
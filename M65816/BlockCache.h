@@ -0,0 +1,121 @@
+/**
+ * M65816: Portable 65816 Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef BLOCKCACHE_H
+#define BLOCKCACHE_H
+
+#include <cstdint>
+
+#include "types.h"
+#include "emulator/System.h"
+
+namespace M65816 {
+
+/**
+ * A single predecoded instruction: the opcode, the operand bytes that
+ * follow it in the instruction stream, and its base cycle count in the
+ * CPU mode the block was decoded for.
+ *
+ * A sequence of instructions with a superinstruction is fused into one
+ * entry, in which case the length, cycles, and operands cover the whole
+ * sequence.
+ */
+struct DecodedInstruction {
+    static constexpr unsigned int kMaxOperandBytes = 8;
+
+    unsigned int opcode;
+    unsigned int cycles;
+    unsigned int length;
+
+    std::uint8_t operands[kMaxOperandBytes];
+
+    // The superinstruction's handler for a fused entry; nullptr means the
+    // instruction is dispatched through LogicEngineBase::executeOpcode().
+    opcode_handler_t handler;
+};
+
+/**
+ * A run of straight-line code starting at PBR:PC. A block never crosses
+ * a page boundary and ends at the first instruction that can transfer
+ * control or change the CPU mode.
+ */
+struct CodeBlock {
+    static constexpr unsigned int kMaxInstructions = 16;
+
+    // (mode << 24) | (PBR << 16) | PC, or kInvalidTag if the slot is empty
+    std::uint32_t tag;
+
+    // Memory page the code was read from, and that page's version
+    // number at the time it was decoded.
+    unsigned int page;
+    unsigned int page_version;
+
+    // Memory map generation at which the page mapping was last verified
+    unsigned int map_generation;
+
+    unsigned int length;
+
+    DecodedInstruction instructions[kMaxInstructions];
+};
+
+/**
+ * The BlockCache holds predecoded blocks of instructions keyed by
+ * (PBR, PC, CPU mode), so that code which is executed repeatedly is
+ * only fetched from memory and decoded once.
+ *
+ * Blocks are revalidated against the System's page version numbers
+ * (bumped on every write) and memory map generation (bumped on every
+ * remap), so self-modifying code and bank switching are handled
+ * transparently.
+ */
+class BlockCache {
+    public:
+        static constexpr std::uint32_t kInvalidTag = 0xFFFFFFFF;
+
+        BlockCache();
+        ~BlockCache();
+
+        void attach(System *theSystem) { system = theSystem; }
+
+        // Discard all cached blocks
+        void flush();
+
+        // Return the block for the given address and mode, decoding it if
+        // necessary. Returns nullptr if the code can't be cached (eg. it
+        // is running from the I/O page).
+        CodeBlock *lookup(const std::uint8_t, const std::uint16_t, const unsigned int, const unsigned int *, const unsigned int *, const fused_opcode_t *);
+
+        // Returns true if a block still reflects the contents of memory
+        inline bool isValid(CodeBlock& block)
+        {
+            if (block.map_generation != system->map_generation) {
+                if (system->getReadPage((block.tag >> 16) & 0xFF, block.tag & 0xFFFF) != block.page) {
+                    return false;
+                }
+
+                block.map_generation = system->map_generation;
+            }
+
+            return system->getPageVersion(block.page) == block.page_version;
+        }
+
+    private:
+        static constexpr unsigned int kNumBlocks = 4096;
+
+        System *system = nullptr;
+
+        CodeBlock *blocks;
+
+        bool decode(CodeBlock&, const std::uint8_t, const std::uint16_t, const unsigned int *, const unsigned int *, const fused_opcode_t *);
+        void fuse(CodeBlock&, const fused_opcode_t *);
+};
+
+} // namespace M65816
+
+#endif // BLOCKCACHE_H
@@ -0,0 +1,74 @@
+/**
+ * M65816: Portable 65816 Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "Coverage.h"
+
+namespace M65816 {
+
+static void writeWord(std::ostream& out, const uint16_t v)
+{
+    out.put(v & 0xFF);
+    out.put(v >> 8);
+}
+
+static void writeLong(std::ostream& out, const uint32_t v)
+{
+    writeWord(out, v & 0xFFFF);
+    writeWord(out, v >> 16);
+}
+
+void Coverage::enable(const bool split)
+{
+    by_mode = split;
+
+    for (unsigned int i = 0 ; i < (by_mode? kNumModes : 1) ; ++i) {
+        bitmaps[i].reset(new uint8_t[kBitmapBytes]);
+
+        std::memset(bitmaps[i].get(), 0, kBitmapBytes);
+    }
+
+    enabled = true;
+}
+
+void Coverage::write(std::ostream& out) const
+{
+    const unsigned int num_bitmaps = by_mode? kNumModes : 1;
+
+    out.write("XCOV", 4);
+    out.put(kFileVersion);
+    out.put(num_bitmaps);
+    writeWord(out, 0);
+
+    for (unsigned int i = 0 ; i < num_bitmaps ; ++i) {
+        const uint8_t *bits = bitmaps[i].get();
+        uint32_t num_pages = 0;
+
+        auto isEmpty = [](const uint8_t *page) { return std::all_of(page, page + kPageBytes, [](uint8_t b) { return !b; }); };
+
+        for (unsigned int page = 0 ; page < 65536 ; ++page) {
+            if (!isEmpty(bits + page * kPageBytes)) ++num_pages;
+        }
+
+        writeLong(out, num_pages);
+
+        for (unsigned int page = 0 ; page < 65536 ; ++page) {
+            const uint8_t *page_bits = bits + page * kPageBytes;
+
+            if (isEmpty(page_bits)) continue;
+
+            writeWord(out, page);
+            out.write(reinterpret_cast<const char *>(page_bits), kPageBytes);
+        }
+    }
+}
+
+} // namespace M65816
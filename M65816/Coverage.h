@@ -0,0 +1,74 @@
+/**
+ * M65816: Portable 65816 Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+namespace M65816 {
+
+/**
+ * Coverage keeps a bitmap with one bit per 24-bit address, which is set
+ * for every byte of every instruction executed. Optionally there is a
+ * separate bitmap for each CPU mode, indexed the same way as the base
+ * Processor modes (0 = m0x0, 1 = m0x1, 2 = m1x0, 3 = m1x1, 4 = emulation).
+ *
+ * The file written by write() is little-endian, and consists of:
+ *
+ *   char     magic[4]        "XCOV"
+ *   uint8_t  version         kFileVersion
+ *   uint8_t  num_bitmaps     1, or kNumModes if split by mode
+ *   uint16_t reserved
+ *
+ * followed by, for each bitmap:
+ *
+ *   uint32_t num_pages
+ *   num_pages x { uint16_t page; uint8_t bits[32]; }
+ *
+ * where page is the 24-bit address >> 8, and only pages with at least one
+ * bit set are stored. utils/covmap.cc reads these files.
+ */
+class Coverage {
+    public:
+        static constexpr unsigned int kNumModes    = 5;
+        static constexpr unsigned int kBitmapBytes = (1 << 24) / 8;
+        static constexpr unsigned int kPageBytes   = 256 / 8;
+        static constexpr std::uint8_t kFileVersion = 1;
+
+        bool enabled = false;
+
+        // Allocate the bitmaps and start recording
+        void enable(const bool);
+
+        // Mark the bytes of an instruction at bank/pc as executed
+        void mark(const std::uint8_t bank, const std::uint16_t pc, const unsigned int length, const unsigned int mode)
+        {
+            std::uint8_t *bits = bitmaps[by_mode? mode : 0].get();
+
+            for (unsigned int i = 0 ; i < length ; ++i) {
+                const std::uint32_t ea = (bank << 16) | static_cast<std::uint16_t>(pc + i);
+
+                bits[ea >> 3] |= 1 << (ea & 7);
+            }
+        }
+
+        void write(std::ostream&) const;
+
+    private:
+        bool by_mode = false;
+
+        std::unique_ptr<std::uint8_t[]> bitmaps[kNumModes];
+};
+
+} // namespace M65816
+
+#endif // COVERAGE_H
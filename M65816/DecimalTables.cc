@@ -0,0 +1,87 @@
+/**
+ * M65816: Portable 65816 Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#include "DecimalTables.h"
+
+namespace M65816 {
+
+std::uint16_t decimal_adc_table[kDecimalTableSize];
+std::uint16_t decimal_sbc_table[kDecimalTableSize];
+
+/**
+ * Add two bytes digit by digit. Invalid BCD digits are handled the same
+ * way the nibble-at-a-time code always has.
+ */
+static std::uint16_t decimalAdd(const int a, const int b, int carry)
+{
+    int result = 0;
+
+    for (int i = 0 ; i < 2 ; ++i) {
+        int digit = ((a >> (4 * i)) & 0x0F) + ((b >> (4 * i)) & 0x0F) + carry;
+
+        if (digit >= 0x0A) {
+            digit = (digit + 0x06) & 0x0F;
+            carry = 1;
+        }
+        else {
+            carry = 0;
+        }
+
+        result |= digit << (4 * i);
+    }
+
+    return result
+        | (carry? kDecimalCarry : 0)
+        | (((a ^ result) & (b ^ result) & 0x80)? kDecimalOverflow : 0);
+}
+
+static std::uint16_t decimalSubtract(const int a, const int b, int carry)
+{
+    int result = 0;
+
+    for (int i = 0 ; i < 2 ; ++i) {
+        int digit = ((a >> (4 * i)) & 0x0F) - ((b >> (4 * i)) & 0x0F) + carry - 1;
+
+        if (digit < 0) {
+            digit = (digit - 0x06) & 0x0F;
+            carry = 0;
+        }
+        else {
+            carry = 1;
+        }
+
+        result |= digit << (4 * i);
+    }
+
+    return result
+        | (carry? kDecimalCarry : 0)
+        | (((a ^ result) & (~b ^ result) & 0x80)? kDecimalOverflow : 0);
+}
+
+void initDecimalTables()
+{
+    static bool initialized = false;
+
+    if (initialized) return;
+
+    for (int carry = 0 ; carry < 2 ; ++carry) {
+        for (int a = 0 ; a < 256 ; ++a) {
+            for (int b = 0 ; b < 256 ; ++b) {
+                const unsigned int index = (carry << 16) | (a << 8) | b;
+
+                decimal_adc_table[index] = decimalAdd(a, b, carry);
+                decimal_sbc_table[index] = decimalSubtract(a, b, carry);
+            }
+        }
+    }
+
+    initialized = true;
+}
+
+} // namespace M65816
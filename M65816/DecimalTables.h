@@ -0,0 +1,36 @@
+/**
+ * M65816: Portable 65816 Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef DECIMALTABLES_H
+#define DECIMALTABLES_H
+
+#include <cstdint>
+
+namespace M65816 {
+
+/**
+ * Lookup tables for decimal mode ADC and SBC on a single byte, indexed by
+ * (carry << 16) | (a << 8) | b. Each entry holds the result in the low
+ * byte plus the carry and overflow flags. 16-bit operations chain two
+ * lookups, feeding the carry out of the low byte into the high byte.
+ */
+constexpr unsigned int kDecimalTableSize = 0x20000;
+
+constexpr std::uint16_t kDecimalCarry    = 0x0100;
+constexpr std::uint16_t kDecimalOverflow = 0x0200;
+
+extern std::uint16_t decimal_adc_table[kDecimalTableSize];
+extern std::uint16_t decimal_sbc_table[kDecimalTableSize];
+
+// Fill in the tables. Safe to call more than once.
+void initDecimalTables();
+
+} // namespace M65816
+
+#endif // DECIMALTABLES_H
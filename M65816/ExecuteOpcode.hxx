@@ -1,2110 +1,2686 @@
-void executeOpcode(unsigned int opcode)
+/**
+ * Each opcode is implemented as its own member function, so that it can
+ * be dispatched through executeOpcode(), the threaded interpreter's jump
+ * table, or a superinstruction. Opcodes above 0xFF are the internal
+ * pseudo-opcodes used for interrupt processing.
+ */
+
+/* BRK s */
+void opcode_00()
 {
-    switch (opcode) {
-        case 0x00:  /* BRK s */
-            ++PC;
+    ++PC;
 
-            if (StackOffset) {
-                stackPush(PC);
-                stackPush(uint8_t(SR | 0x10));  // set B bit on stack
-            }
-            else {
-                stackPush(PBR);
-                stackPush(PC);
-                stackPush(SR);
-            }
-
-            SR.D = false;
-            SR.I = true;
+    if (StackOffset) {
+        stackPush(PC);
+        stackPush(uint8_t(SR | 0x10));  // set B bit on stack
+    }
+    else {
+        stackPush(PBR);
+        stackPush(PC);
+        stackPush(SR);
+    }
 
-            cpu->loadVector(StackOffset? 0xFFFE : 0xFFE6);
+    SR.D = false;
+    SR.I = true;
 
-            break;
+    loadVector(StackOffset? 0xFFFE : 0xFFE6);
+}
 
-        case 0x01:  /* ORA (d,x) */
-            getAddress_dxi();
-            fetchOperand(operand.m);
+/* ORA (d,x) */
+void opcode_01()
+{
+    getAddress_dxi();
+    fetchOperand(operand.m);
 
-            op_ORA();
+    op_ORA();
+}
 
-            break;
+/* COP s */
+void opcode_02()
+{
+    ++PC;
 
-        case 0x02:  /* COP s */
-            ++PC;
+    if (!StackOffset) {
+        stackPush(PBR);
+    }
 
-            if (!StackOffset) {
-                stackPush(PBR);
-            }
+    stackPush(PC);
+    stackPush(SR);
 
-            stackPush(PC);
-            stackPush(SR);
+    SR.D = false;
+    SR.I = true;
 
-            SR.D = false;
-            SR.I = true;
+    loadVector(StackOffset? 0xFFF4 : 0xFFE4);
+}
 
-            cpu->loadVector(StackOffset? 0xFFF4 : 0xFFE4);
+/* ORA d,s */
+void opcode_03()
+{
+    getAddress_sr();
 
-            break;
+    fetchOperand(operand.m);
+    op_ORA();
+}
 
-        case 0x03:  /* ORA d,s */
-            getAddress_sr();
+/* TSB d */
+void opcode_04()
+{
+    getAddress_d();
 
-            fetchOperand(operand.m);
-            op_ORA();
+    fetchOperand(operand.m);
+    op_TSB();
+    storeOperand(operand.m);
+}
 
-            break;
+/* ORA d */
+void opcode_05()
+{
+    getAddress_d();
 
-        case 0x04:  /* TSB d */
-            getAddress_d();
+    fetchOperand(operand.m);
+    op_ORA();
+}
 
-            fetchOperand(operand.m);
-            op_TSB();
-            storeOperand(operand.m);
+/* ASL d */
+void opcode_06()
+{
+    getAddress_d();
 
-            break;
+    fetchOperand(operand.m);
+    op_ASL();
+    storeOperand(operand.m);
+}
 
-        case 0x05:  /* ORA d */
-            getAddress_d();
+/* ORA [d] */
+void opcode_07()
+{
+    getAddress_dil();
 
-            fetchOperand(operand.m);
-            op_ORA();
+    fetchOperand(operand.m);
+    op_ORA();
+}
 
-            break;
+/* PHP s */
+void opcode_08()
+{
+    stackPush(SR);
+}
 
-        case 0x06:  /* ASL d */
-            getAddress_d();
+/* ORA # */
+void opcode_09()
+{
+    fetchImmediateOperand(operand.m);
+    op_ORA();
+}
 
-            fetchOperand(operand.m);
-            op_ASL();
-            storeOperand(operand.m);
+/* ASL A */
+void opcode_0A()
+{
+    operand.m = A;
+    op_ASL();
+    A = operand.m;
+}
 
-            break;
+/* PHD s */
+void opcode_0B()
+{
+    stackPush(D);
+}
 
-        case 0x07:  /* ORA [d] */
-            getAddress_dil();
+/* TSB a */
+void opcode_0C()
+{
+    getAddress_a();
 
-            fetchOperand(operand.m);
-            op_ORA();
+    fetchOperand(operand.m);
+    op_TSB();
+    storeOperand(operand.m);
+}
 
-            break;
+/* ORA a */
+void opcode_0D()
+{
+    getAddress_a();
 
-        case 0x08:  /* PHP s */
-            stackPush(SR);
+    fetchOperand(operand.m);
+    op_ORA();
+}
 
-            break;
+/* ASL a */
+void opcode_0E()
+{
+    getAddress_a();
 
-        case 0x09:  /* ORA # */
-            fetchImmediateOperand(operand.m);
-            op_ORA();
+    fetchOperand(operand.m);
+    op_ASL();
+    storeOperand(operand.m);
+}
 
-            break;
+/* ORA al */
+void opcode_0F()
+{
+    getAddress_al();
 
-        case 0x0A:  /* ASL A */
-            operand.m = A;
-            op_ASL();
-            A = operand.m;
+    fetchOperand(operand.m);
+    op_ORA();
+}
 
-            break;
+/* BPL r */
+void opcode_10()
+{
+    getAddress_pcr();
 
-        case 0x0B:  /* PHD s */
-            stackPush(D);
+    if (!SR.N()) {
+        checkProgramPageCross();
 
-            break;
+        branchTo(operandAddress());
 
-        case 0x0C:  /* TSB a */
-            getAddress_a();
+        ++cpu->num_cycles;
+    }
+}
 
-            fetchOperand(operand.m);
-            op_TSB();
-            storeOperand(operand.m);
+/* ORA (d),y */
+void opcode_11()
+{
+    getAddress_dix();
 
-            break;
+    fetchOperand(operand.m);
+    op_ORA();
+}
 
-        case 0x0D:  /* ORA a */
-            getAddress_a();
+/* ORA (d) */
+void opcode_12()
+{
+    getAddress_di();
 
-            fetchOperand(operand.m);
-            op_ORA();
+    fetchOperand(operand.m);
+    op_ORA();
+}
 
-            break;
+/* ORA (d,s),y */
+void opcode_13()
+{
+    getAddress_srix();
 
-        case 0x0E:  /* ASL a */
-            getAddress_a();
+    fetchOperand(operand.m);
+    op_ORA();
+}
 
-            fetchOperand(operand.m);
-            op_ASL();
-            storeOperand(operand.m);
+/* TRB d */
+void opcode_14()
+{
+    getAddress_d();
 
-            break;
+    fetchOperand(operand.m);
+    op_TRB();
+    storeOperand(operand.m);
+}
 
-        case 0x0F:  /* ORA al */
-            getAddress_al();
+/* ORA d,x */
+void opcode_15()
+{
+    getAddress_dxx();
 
-            fetchOperand(operand.m);
-            op_ORA();
+    fetchOperand(operand.m);
+    op_ORA();
+}
 
-            break;
+/* ASL d,x */
+void opcode_16()
+{
+    getAddress_dxx();
 
-        case 0x10:  /* BPL r */
-            getAddress_pcr();
+    fetchOperand(operand.m);
+    op_ASL();
+    storeOperand(operand.m);
+}
 
-            if (!SR.N) {
-                checkProgramPageCross();
+/* ORA [d],y */
+void opcode_17()
+{
+    getAddress_dixl();
 
-                jumpTo(operand_addr);
+    fetchOperand(operand.m);
+    op_ORA();
+}
 
-                ++cpu->num_cycles;
-            }
+/* CLC i */
+void opcode_18()
+{
+    SR.C = false;
+}
 
-            break;
+/* ORA a,y */
+void opcode_19()
+{
+    getAddress_axy();
 
-        case 0x11:  /* ORA (d),y */
-            getAddress_dix();
+    fetchOperand(operand.m);
+    op_ORA();
+}
 
-            fetchOperand(operand.m);
-            op_ORA();
+/* INC A */
+void opcode_1A()
+{
+    operand.m = A;
+    op_INC();
+    A = operand.m;
+}
 
-            break;
+/* TCS i */
+void opcode_1B()
+{
+    if (StackOffset) {
+        S = A;
+    }
+    else {
+        // native mode ignores M bit
+        S = accumulatorWord();
+    }
+}
 
-        case 0x12:  /* ORA (d) */
-            getAddress_di();
+/* TRB a */
+void opcode_1C()
+{
+    getAddress_a();
+    fetchOperand(operand.m);
 
-            fetchOperand(operand.m);
-            op_ORA();
+    op_TRB();
+    storeOperand(operand.m);
+}
 
-            break;
+/* ORA a,x */
+void opcode_1D()
+{
+    getAddress_axx();
+    fetchOperand(operand.m);
 
-        case 0x13:  /* ORA (d,s),y */
-            getAddress_srix();
+    op_ORA();
+}
 
-            fetchOperand(operand.m);
-            op_ORA();
+/* ASL a,x */
+void opcode_1E()
+{
+    getAddress_axx();
 
-            break;
+    fetchOperand(operand.m);
+    op_ASL();
+    storeOperand(operand.m);
+}
 
-        case 0x14:  /* TRB d */
-            getAddress_d();
+/* ORA al,x */
+void opcode_1F()
+{
+    getAddress_alxx();
+    fetchOperand(operand.m);
 
-            fetchOperand(operand.m);
-            op_TRB();
-            storeOperand(operand.m);
+    op_ORA();
+}
 
-            break;
+/* JSR a */
+void opcode_20()
+{
+    getAddress_a();
 
-        case 0x15:  /* ORA d,x */
-            getAddress_dxx();
+    if ((operandAddress() == System::kMLIEntry) && trapMLICall()) return;
 
-            fetchOperand(operand.m);
-            op_ORA();
+    --PC;
 
-            break;
+    const uint32_t from = linearAddress(PBR, PC - 2);
 
-        case 0x16:  /* ASL d,x */
-            getAddress_dxx();
+    stackPush(PC);
+    jumpTo(operandAddress());
 
-            fetchOperand(operand.m);
-            op_ASL();
-            storeOperand(operand.m);
+    profileCall(from);
+}
 
-            break;
+/* AND (d,x) */
+void opcode_21()
+{
+    getAddress_dxi();
+    fetchOperand(operand.m);
 
-        case 0x17:  /* ORA [d],y */
-            getAddress_dixl();
+    op_AND();
+}
 
-            fetchOperand(operand.m);
-            op_ORA();
+/* JSL al */
+void opcode_22()
+{
+    getAddress_al();
 
-            break;
+    if ((operand_ea == System::kToolDispatcher) && trapToolCall()) return;
+    if ((operand_ea == System::kGSOSInline) && trapGSOSCall(false)) return;
+    if ((operand_ea == System::kGSOSStack) && trapGSOSCall(true)) return;
 
-        case 0x18:  /* CLC i */
-            SR.C = false;
+    --PC;
 
-            break;
+    const uint32_t from = linearAddress(PBR, PC - 3);
 
-        case 0x19:  /* ORA a,y */
-            getAddress_axy();
+    stackPush(PBR);
+    stackPush(PC);
 
-            fetchOperand(operand.m);
-            op_ORA();
+    jumpTo(operandBank(), operandAddress());
 
-            break;
+    profileCall(from);
+}
 
-        case 0x1A:  /* INC A */
-            operand.m = A;
-            op_INC();
-            A = operand.m;
+/* AND d,s */
+void opcode_23()
+{
+    getAddress_sr();
+    fetchOperand(operand.m);
 
-            break;
+    op_AND();
+}
 
-        case 0x1B:  /* TCS i */
-            if (StackOffset) {
-                S = A;
-            }
-            else {
-                // native mode ignores M bit
-                cpu->S.W = cpu->A.W;
-            }
+/* BIT d */
+void opcode_24()
+{
+    getAddress_d();
+    fetchOperand(operand.m);
 
-            break;
+    op_BIT();
+}
 
-        case 0x1C:  /* TRB a */
-            getAddress_a();
-            fetchOperand(operand.m);
+/* AND d */
+void opcode_25()
+{
+    getAddress_d();
+    fetchOperand(operand.m);
 
-            op_TRB();
-            storeOperand(operand.m);
+    op_AND();
+}
 
-            break;
+/* ROL d */
+void opcode_26()
+{
+    getAddress_d();
 
-        case 0x1D:  /* ORA a,x */
-            getAddress_axx();
-            fetchOperand(operand.m);
+    fetchOperand(operand.m);
+    op_ROL();
+    storeOperand(operand.m);
+}
 
-            op_ORA();
+/* AND [d] */
+void opcode_27()
+{
+    getAddress_dil();
+    fetchOperand(operand.m);
 
-            break;
+    op_AND();
+}
 
-        case 0x1E:  /* ASL a,x */
-            getAddress_axx();
+/* PLP s */
+void opcode_28()
+{
+    uint8_t v;
 
-            fetchOperand(operand.m);
-            op_ASL();
-            storeOperand(operand.m);
+    stackPull(v);
 
-            break;
+    SR = v;
 
-        case 0x1F:  /* ORA al,x */
-            getAddress_alxx();
-            fetchOperand(operand.m);
+    checkRegisterMode();
+    checkPendingIRQ();
+}
 
-            op_ORA();
+/* AND # */
+void opcode_29()
+{
+    fetchImmediateOperand(operand.m);
 
-            break;
+    op_AND();
+}
 
-        case 0x20:  /* JSR a */
-            getAddress_a();
+/* ROL A */
+void opcode_2A()
+{
+    operand.m = A;
+    op_ROL();
+    A = operand.m;
+}
 
-            --PC;
+/* PLD s */
+void opcode_2B()
+{
+    stackPull(D);
 
-            stackPush(PC);
-            jumpTo(operand_addr);
+    checkIfNegative(D);
+    checkIfZero(D);
 
-            break;
+    checkDirectPageMode();
+}
 
-        case 0x21:  /* AND (d,x) */
-            getAddress_dxi();
-            fetchOperand(operand.m);
+/* BIT a */
+void opcode_2C()
+{
+    getAddress_a();
+    fetchOperand(operand.m);
 
-            op_AND();
+    op_BIT();
+}
 
-            break;
+/* AND a */
+void opcode_2D()
+{
+    getAddress_a();
+    fetchOperand(operand.m);
 
-        case 0x22:  /* JSL al */
-            getAddress_al();
+    op_AND();
+}
 
-            --PC;
+/* ROL a */
+void opcode_2E()
+{
+    getAddress_a();
 
-            stackPush(PBR);
-            stackPush(PC);
+    fetchOperand(operand.m);
+    op_ROL();
+    storeOperand(operand.m);
+}
 
-            jumpTo(operand_bank, operand_addr);
+/* AND al */
+void opcode_2F()
+{
+    getAddress_al();
+    fetchOperand(operand.m);
 
-            break;
+    op_AND();
+}
 
-        case 0x23:  /* AND d,s */
-            getAddress_sr();
-            fetchOperand(operand.m);
+/* BMI r */
+void opcode_30()
+{
+    getAddress_pcr();
 
-            op_AND();
+    if (SR.N()) {
+        checkProgramPageCross();
 
-            break;
+        branchTo(operandAddress());
 
-        case 0x24:  /* BIT d */
-            getAddress_d();
-            fetchOperand(operand.m);
+        ++cpu->num_cycles;
+    }
+}
 
-            op_BIT();
+/* AND (d),y */
+void opcode_31()
+{
+    getAddress_dix();
+    fetchOperand(operand.m);
 
-            break;
+    op_AND();
+}
 
-        case 0x25:  /* AND d */
-            getAddress_d();
-            fetchOperand(operand.m);
+/* AND (d) */
+void opcode_32()
+{
+    getAddress_di();
+    fetchOperand(operand.m);
 
-            op_AND();
+    op_AND();
+}
 
-            break;
+/* AND (d,s),y */
+void opcode_33()
+{
+    getAddress_srix();
+    fetchOperand(operand.m);
 
-        case 0x26:  /* ROL d */
-            getAddress_d();
+    op_AND();
+}
 
-            fetchOperand(operand.m);
-            op_ROL();
-            storeOperand(operand.m);
+/* BIT d,x */
+void opcode_34()
+{
+    getAddress_dxx();
+    fetchOperand(operand.m);
 
-            break;
+    op_BIT();
+}
 
-        case 0x27:  /* AND [d] */
-            getAddress_dil();
-            fetchOperand(operand.m);
+/* AND d,x */
+void opcode_35()
+{
+    getAddress_dxx();
+    fetchOperand(operand.m);
 
-            op_AND();
+    op_AND();
+}
 
-            break;
+/* ROL d,x */
+void opcode_36()
+{
+    getAddress_dxx();
 
-        case 0x28:  /* PLP s */
-            {
-                uint8_t v;
+    fetchOperand(operand.m);
+    op_ROL();
+    storeOperand(operand.m);
+}
 
-                stackPull(v);
+/* AND [d],y */
+void opcode_37()
+{
+    getAddress_dixl();
+    fetchOperand(operand.m);
 
-                SR = v;
+    op_AND();
+}
 
-                cpu->modeSwitch();
-            }
+/* SEC i */
+void opcode_38()
+{
+    SR.C = true;
+}
 
-            break;
+/* AND a,y */
+void opcode_39()
+{
+    getAddress_axy();
+    fetchOperand(operand.m);
 
-        case 0x29:  /* AND # */
-            fetchImmediateOperand(operand.m);
+    op_AND();
+}
 
-            op_AND();
+/* DEC A */
+void opcode_3A()
+{
+    operand.m = A;
+    op_DEC();
+    A = operand.m;
+}
 
-            break;
+/* TSC i */
+void opcode_3B()
+{
+    // ignore M bit
+    setAccumulatorWord(stackWord());
 
-        case 0x2A:  /* ROL A */
-            operand.m = A;
-            op_ROL();
-            A = operand.m;
+    if (StackOffset) {
+        checkIfNegative(A);
+        checkIfZero(A);
+    }
+    else {
+        checkIfNegative(stackWord());
+        checkIfZero(stackWord());
+    }
+}
 
-            break;
+/* BIT a,x */
+void opcode_3C()
+{
+    getAddress_axx();
+    fetchOperand(operand.m);
 
-        case 0x2B:  /* PLD s */
-            stackPull(D);
+    op_BIT();
+}
 
-            checkIfNegative(D);
-            checkIfZero(D);
+/* AND a,x */
+void opcode_3D()
+{
+    getAddress_axx();
+    fetchOperand(operand.m);
 
-            break;
+    op_AND();
+}
 
-        case 0x2C:  /* BIT a */
-            getAddress_a();
-            fetchOperand(operand.m);
+/* ROL a,x */
+void opcode_3E()
+{
+    getAddress_axx();
 
-            op_BIT();
+    fetchOperand(operand.m);
+    op_ROL();
+    storeOperand(operand.m);
+}
 
-            break;
+/* AND al,x */
+void opcode_3F()
+{
+    getAddress_alxx();
+    fetchOperand(operand.m);
 
-        case 0x2D:  /* AND a */
-            getAddress_a();
-            fetchOperand(operand.m);
+    op_AND();
+}
 
-            op_AND();
+/* RTI */
+void opcode_40()
+{
+    const uint32_t from = linearAddress(PBR, PC - 1);
+    uint8_t v;
 
-            break;
+    stackPull(v);
 
-        case 0x2E:  /* ROL a */
-            getAddress_a();
+    SR = v;
 
-            fetchOperand(operand.m);
-            op_ROL();
-            storeOperand(operand.m);
+    checkRegisterMode();
+    checkPendingIRQ();
 
-            break;
+    stackPull(PC);
 
-        case 0x2F:  /* AND al */
-            getAddress_al();
-            fetchOperand(operand.m);
+    // cannot use StackOffset check here because we may have changed
+    // out of the mode this version of the template is compiled for.
+    if (!SR.E) {
+        stackPull(PBR);
+    }
 
-            op_AND();
+    profileReturn(from);
+}
 
-            break;
+/* EOR (d,x) */
+void opcode_41()
+{
+    getAddress_dxi();
+    fetchOperand(operand.m);
 
-        case 0x30:  /* BMI r */
-            getAddress_pcr();
+    op_EOR();
+}
 
-            if (SR.N) {
-                checkProgramPageCross();
+/* WDM */
+void opcode_42()
+{
+    fetchImmediateOperand(operand.b);
 
-                jumpTo(operand_addr);
+    // WDM handlers work on the Processor's copy of the registers
+    storeRegisters();
+    system->handleWdm(operand.b);
+    loadRegisters();
 
-                ++cpu->num_cycles;
-            }
+    checkDirectPageMode();
+    checkBankMode();
+}
 
-            break;
+/* EOR d,s */
+void opcode_43()
+{
+    getAddress_sr();
+    fetchOperand(operand.m);
 
-        case 0x31:  /* AND (d),y */
-            getAddress_dix();
-            fetchOperand(operand.m);
+    op_EOR();
+}
 
-            op_AND();
+/* MVP xyc */
+void opcode_44()
+{
+    op_MVP();
+}
 
-            break;
+/* EOR d */
+void opcode_45()
+{
+    getAddress_d();
+    fetchOperand(operand.m);
 
-        case 0x32:  /* AND (d) */
-            getAddress_di();
-            fetchOperand(operand.m);
+    op_EOR();
+}
 
-            op_AND();
+/* LSR d */
+void opcode_46()
+{
+    getAddress_d();
+    fetchOperand(operand.m);
 
-            break;
+    op_LSR();
+    storeOperand(operand.m);
+}
 
-        case 0x33:  /* AND (d,s),y */
-            getAddress_srix();
-            fetchOperand(operand.m);
+/* EOR [d] */
+void opcode_47()
+{
+    getAddress_dil();
+    fetchOperand(operand.m);
 
-            op_AND();
+    op_EOR();
+}
 
-            break;
+/* PHA */
+void opcode_48()
+{
+    stackPush(A);
+}
 
-        case 0x34:  /* BIT d,x */
-            getAddress_dxx();
-            fetchOperand(operand.m);
+/* EOR # */
+void opcode_49()
+{
+    fetchImmediateOperand(operand.m);
 
-            op_BIT();
+    op_EOR();
+}
 
-            break;
+/* LSR A */
+void opcode_4A()
+{
+    operand.m = A;
+    op_LSR();
+    A = operand.m;
+}
 
-        case 0x35:  /* AND d,x */
-            getAddress_dxx();
-            fetchOperand(operand.m);
+/* PHK */
+void opcode_4B()
+{
+    stackPush(PBR);
+}
 
-            op_AND();
+/* JMP a */
+void opcode_4C()
+{
+    getAddress_a();
 
-            break;
+    jumpTo(operandAddress());
+}
 
-        case 0x36:  /* ROL d,x */
-            getAddress_dxx();
+/* EOR a */
+void opcode_4D()
+{
+    getAddress_a();
+    fetchOperand(operand.m);
 
-            fetchOperand(operand.m);
-            op_ROL();
-            storeOperand(operand.m);
+    op_EOR();
+}
 
-            break;
+/* LSR a */
+void opcode_4E()
+{
+    getAddress_a();
+    fetchOperand(operand.m);
 
-        case 0x37:  /* AND [d],y */
-            getAddress_dixl();
-            fetchOperand(operand.m);
+    op_LSR();
+    storeOperand(operand.m);
+}
 
-            op_AND();
+/* EOR al */
+void opcode_4F()
+{
+    getAddress_al();
+    fetchOperand(operand.m);
 
-            break;
+    op_EOR();
+}
 
-        case 0x38:  /* SEC i */
-            SR.C = true;
+/* BVC r */
+void opcode_50()
+{
+    getAddress_pcr();
 
-            break;
+    if (!SR.V) {
+        checkProgramPageCross();
 
-        case 0x39:  /* AND a,y */
-            getAddress_axy();
-            fetchOperand(operand.m);
+        branchTo(operandAddress());
 
-            op_AND();
+        ++cpu->num_cycles;
+    }
+}
 
-            break;
+/* EOR (d),y */
+void opcode_51()
+{
+    getAddress_dix();
+    fetchOperand(operand.m);
 
-        case 0x3A:  /* DEC A */
-            operand.m = A;
-            op_DEC();
-            A = operand.m;
+    op_EOR();
+}
 
-            break;
+/* EOR (d) */
+void opcode_52()
+{
+    getAddress_di();
+    fetchOperand(operand.m);
 
-        case 0x3B:  /* TSC i */
-            // ignore M bit
-            cpu->A.W = cpu->S.W;
+    op_EOR();
+}
 
-            if (StackOffset) {
-                checkIfNegative(A);
-                checkIfZero(A);
-            }
-            else {
-                checkIfNegative(cpu->A.W);
-                checkIfZero(cpu->A.W);
-            }
+/* EOR (d,s),y */
+void opcode_53()
+{
+    getAddress_srix();
+    fetchOperand(operand.m);
 
-            break;
+    op_EOR();
+}
 
-        case 0x3C:  /* BIT a,x */
-            getAddress_axx();
-            fetchOperand(operand.m);
+/* MVN xyc */
+void opcode_54()
+{
+    op_MVN();
+}
 
-            op_BIT();
+/* EOR d,x */
+void opcode_55()
+{
+    getAddress_dxx();
+    fetchOperand(operand.m);
 
-            break;
+    op_EOR();
+}
 
-        case 0x3D:  /* AND a,x */
-            getAddress_axx();
-            fetchOperand(operand.m);
+/* LSR d,x */
+void opcode_56()
+{
+    getAddress_dxx();
+    fetchOperand(operand.m);
 
-            op_AND();
+    op_LSR();
+    storeOperand(operand.m);
+}
 
-            break;
+/* EOR [d],y */
+void opcode_57()
+{
+    getAddress_dixl();
+    fetchOperand(operand.m);
 
-        case 0x3E:  /* ROL a,x */
-            getAddress_axx();
+    op_EOR();
+}
 
-            fetchOperand(operand.m);
-            op_ROL();
-            storeOperand(operand.m);
+/* CLI i */
+void opcode_58()
+{
+    SR.I = 0;
 
-            break;
+    checkPendingIRQ();
+}
 
-        case 0x3F:  /* AND al,x */
-            getAddress_alxx();
-            fetchOperand(operand.m);
+/* EOR a,y */
+void opcode_59()
+{
+    getAddress_axy();
+    fetchOperand(operand.m);
 
-            op_AND();
+    op_EOR();
+}
 
-            break;
-
-        case 0x40:  /* RTI */
-            {
-                uint8_t v;
-
-                stackPull(v);
-
-                SR = v;
-
-                cpu->modeSwitch();
-
-                stackPull(PC);
-
-                // cannot use StackOffset check here because we may have changed
-                // out of the mode this version of the template is compiled for.
-                if (!SR.E) {
-                    stackPull(PBR);
-                }
-            }
-
-            break;
-
-        case 0x41:  /* EOR (d,x) */
-            getAddress_dxi();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x42:  /* WDM */
-            fetchImmediateOperand(operand.b);
-
-            system->handleWdm(operand.b);
-
-            break;
-
-        case 0x43:  /* EOR d,s */
-            getAddress_sr();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x44:  /* MVP xyc */
-            op_MVP();
-
-            break;
-
-        case 0x45:  /* EOR d */
-            getAddress_d();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x46:  /* LSR d */
-            getAddress_d();
-            fetchOperand(operand.m);
-
-            op_LSR();
-            storeOperand(operand.m);
-
-            break;
-
-        case 0x47:  /* EOR [d] */
-            getAddress_dil();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x48:  /* PHA */
-            stackPush(A);
-
-            break;
-
-        case 0x49:  /* EOR # */
-            fetchImmediateOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x4A:  /* LSR A */
-            operand.m = A;
-            op_LSR();
-            A = operand.m;
-
-            break;
-
-        case 0x4B:  /* PHK */
-            stackPush(PBR);
-
-            break;
-
-        case 0x4C:  /* JMP a */
-            getAddress_a();
-
-            jumpTo(operand_addr);
-
-            break;
-
-        case 0x4D:  /* EOR a */
-            getAddress_a();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x4E:  /* LSR a */
-            getAddress_a();
-            fetchOperand(operand.m);
-
-            op_LSR();
-            storeOperand(operand.m);
-
-            break;
-
-        case 0x4F:  /* EOR al */
-            getAddress_al();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x50:  /* BVC r */
-            getAddress_pcr();
-
-            if (!SR.V) {
-                checkProgramPageCross();
-
-                jumpTo(operand_addr);
-
-                ++cpu->num_cycles;
-            }
-
-            break;
-
-        case 0x51:  /* EOR (d),y */
-            getAddress_dix();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x52:  /* EOR (d) */
-            getAddress_di();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x53:  /* EOR (d,s),y */
-            getAddress_srix();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x54:  /* MVN xyc */
-            op_MVN();
-
-            break;
-
-        case 0x55:  /* EOR d,x */
-            getAddress_dxx();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x56:  /* LSR d,x */
-            getAddress_dxx();
-            fetchOperand(operand.m);
-
-            op_LSR();
-            storeOperand(operand.m);
-
-            break;
-
-        case 0x57:  /* EOR [d],y */
-            getAddress_dixl();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x58:  /* CLI i */
-            SR.I = 0;
-
-            break;
-
-        case 0x59:  /* EOR a,y */
-            getAddress_axy();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x5A:  /* PHY s */
-            stackPush(Y);
-
-            break;
-
-        case 0x5B:  /* TCD i */
-            op_TCD();
-
-            break;
-
-        case 0x5C:  /* JMP al */
-            getAddress_al();
-
-            jumpTo(operand_bank, operand_addr);
-
-            break;
-
-        case 0x5D:  /* EOR a,x */
-            getAddress_axx();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x5E:  /* LSR a,x */
-            getAddress_axx();
-            fetchOperand(operand.m);
-
-            op_LSR();
-            storeOperand(operand.m);
-
-            break;
-
-        case 0x5F:  /* EOR al,x */
-            getAddress_alxx();
-            fetchOperand(operand.m);
-
-            op_EOR();
-
-            break;
-
-        case 0x60:  /* RTS s */
-            stackPull(PC);
-
-            ++PC;
-
-            break;
-
-        case 0x61:  /* ADC (d,x) */
-            getAddress_dxi();
-            fetchOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x62:  /* PER s */
-            getAddress_pcrl();
-
-            stackPush(operand_addr);
-
-            break;
-
-        case 0x63:  /* ADC d,s */
-            getAddress_sr();
-
-            fetchOperand(operand.m);
-            op_ADC();
-
-            break;
-
-        case 0x64:  /* STZ d */
-            getAddress_d();
-
-            op_STZ();
-
-            break;
-
-        case 0x65:  /* ADC d */
-            getAddress_d();
-            fetchOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x66:  /* ROR d */
-            getAddress_d();
-
-            fetchOperand(operand.m);
-            op_ROR();
-            storeOperand(operand.m);
-
-            break;
-
-        case 0x67:  /* ADC [d] */
-            getAddress_dil();
-            fetchOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x68:  /* PLA s */
-            stackPull(A);
-            checkIfNegative(A);
-            checkIfZero(A);
-
-            break;
-
-        case 0x69:  /* ADC # */
-            fetchImmediateOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x6A:  /* ROR A */
-            operand.m = A;
-            op_ROR();
-            A = operand.m;
-
-            break;
-
-        case 0x6B:  /* RTL s */
-            stackPull(PC);
-            stackPull(PBR);
-
-            ++PC;
-
-            break;
-
-        case 0x6C:  /* JMP (a) */
-            getAddress_ai();
-
-            jumpTo(operand_addr);
-
-            break;
-
-        case 0x6D:  /* ADC a */
-            getAddress_a();
-            fetchOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x6E:  /* ROR a */
-            getAddress_a();
-
-            fetchOperand(operand.m);
-            op_ROR();
-            storeOperand(operand.m);
-
-            break;
-
-        case 0x6F:  /* ADC al */
-            getAddress_al();
-            fetchOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x70:  /* BVS r */
-            getAddress_pcr();
-
-            if (SR.V) {
-                checkProgramPageCross();
-
-                jumpTo(operand_addr);
-
-                ++cpu->num_cycles;
-            }
-
-            break;
-
-        case 0x71:  /* ADC (d),y */
-            getAddress_dix();
-            fetchOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x72:  /* ADC (d) */
-            getAddress_di();
-            fetchOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x73:  /* ADC (d,s),y */
-            getAddress_srix();
-            fetchOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x74:  /* STZ d,x */
-            getAddress_dxx();
-
-            op_STZ();
-
-            break;
-
-        case 0x75:  /* ADC d,x */
-            getAddress_dxx();
-            fetchOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x76:  /* ROR d,x */
-            getAddress_dxx();
-
-            fetchOperand(operand.m);
-            op_ROR();
-            storeOperand(operand.m);
-
-            break;
-
-        case 0x77:  /* ADC [d],y */
-            getAddress_dixl();
-            fetchOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x78:  /* SEI i */
-            SR.I = true;
-
-            break;
-
-        case 0x79:  /* ADC a,y */
-            getAddress_axy();
-            fetchOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x7A:  /* PLY */
-            stackPull(Y);
-            checkIfNegative(Y);
-            checkIfZero(Y);
-
-            break;
-
-        case 0x7B:  /* TDC i */
-            op_TDC();
-
-            break;
-
-        case 0x7C:  /* JMP (a,x) */
-            getAddress_axi();
-
-            jumpTo(operand_addr);
-
-            break;
-
-        case 0x7D:  /* ADC a,x */
-            getAddress_axx();
-            fetchOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x7E:  /* ROR a,x */
-            getAddress_axx();
-
-            fetchOperand(operand.m);
-            op_ROR();
-            storeOperand(operand.m);
-
-            break;
-
-        case 0x7F:  /* ADC al,x */
-            getAddress_alxx();
-            fetchOperand(operand.m);
-
-            op_ADC();
-
-            break;
-
-        case 0x80:  /* BRA r */
-            getAddress_pcr();
-
-            checkProgramPageCross();
-            jumpTo(operand_addr);
-
-            break;
-
-        case 0x81:  /* STA (d,x) */
-            getAddress_dxi();
-
-            op_STA();
-
-            break;
-
-        case 0x82:  /* BRL rl */
-            getAddress_pcrl();
-
-            jumpTo(operand_bank, operand_addr);
-
-            break;
-
-        case 0x83:  /* STA d,s */
-            getAddress_sr();
-
-            op_STA();
-
-            break;
-
-        case 0x84:  /* STY d */
-            getAddress_d();
-
-            op_STY();
-
-            break;
-
-        case 0x85:  /* STA d */
-            getAddress_d();
-
-            op_STA();
-
-            break;
-
-        case 0x86:  /* STX d */
-            getAddress_d();
-
-            op_STX();
-
-            break;
-
-        case 0x87:  /* STA [d] */
-            getAddress_dil();
-
-            op_STA();
-
-            break;
-
-        case 0x88:  /* DEY i */
-            --Y;
-
-            checkIfNegative(Y);
-            checkIfZero(Y);
-
-            break;
-
-        case 0x89:  /* BIT # */
-            fetchImmediateOperand(operand.m);
-
-            SR.Z = !(operand.m & A);
-
-            break;
-
-        case 0x8A:  /* TXA i */
-            A = static_cast<MemSizeType> (cpu->X);
-
-            checkIfNegative(A);
-            checkIfZero(A);
-
-            break;
-
-        case 0x8B:  /* PHB */
-            stackPush(DBR);
-
-            break;
-
-        case 0x8C:  /* STY a */
-            getAddress_a();
-
-            op_STY();
-
-            break;
-
-        case 0x8D:  /* STA a */
-            getAddress_a();
-
-            op_STA();
-
-            break;
-
-        case 0x8E:  /* STX a */
-            getAddress_a();
-
-            op_STX();
-
-            break;
-
-        case 0x8F:  /* STA al */
-            getAddress_al();
-
-            op_STA();
-
-            break;
+/* PHY s */
+void opcode_5A()
+{
+    stackPush(Y);
+}
 
-        case 0x90:  /* BCC r */
-            getAddress_pcr();
+/* TCD i */
+void opcode_5B()
+{
+    op_TCD();
+}
 
-            if (!SR.C) {
-                checkProgramPageCross();
+/* JMP al */
+void opcode_5C()
+{
+    getAddress_al();
 
-                jumpTo(operand_addr);
+    jumpTo(operandBank(), operandAddress());
+}
 
-                ++cpu->num_cycles;
-            }
+/* EOR a,x */
+void opcode_5D()
+{
+    getAddress_axx();
+    fetchOperand(operand.m);
 
-            break;
+    op_EOR();
+}
 
-        case 0x91:  /* STA (d),y */
-            getAddress_dix();
+/* LSR a,x */
+void opcode_5E()
+{
+    getAddress_axx();
+    fetchOperand(operand.m);
 
-            op_STA();
+    op_LSR();
+    storeOperand(operand.m);
+}
 
-            break;
+/* EOR al,x */
+void opcode_5F()
+{
+    getAddress_alxx();
+    fetchOperand(operand.m);
 
-        case 0x92:  /* STA (d) */
-            getAddress_di();
+    op_EOR();
+}
 
-            op_STA();
+/* RTS s */
+void opcode_60()
+{
+    const uint32_t from = linearAddress(PBR, PC - 1);
 
-            break;
+    stackPull(PC);
 
-        case 0x93:  /* STA (d,s),y */
-            getAddress_srix();
+    ++PC;
 
-            op_STA();
+    profileReturn(from);
+}
 
-            break;
+/* ADC (d,x) */
+void opcode_61()
+{
+    getAddress_dxi();
+    fetchOperand(operand.m);
 
-        case 0x94:  /* STY d,x */
-            getAddress_dxx();
+    op_ADC();
+}
 
-            op_STY();
+/* PER s */
+void opcode_62()
+{
+    getAddress_pcrl();
 
-            break;
+    stackPush(operandAddress());
+}
 
-        case 0x95:  /* STA d,x */
-            getAddress_dxx();
+/* ADC d,s */
+void opcode_63()
+{
+    getAddress_sr();
 
-            op_STA();
+    fetchOperand(operand.m);
+    op_ADC();
+}
 
-            break;
+/* STZ d */
+void opcode_64()
+{
+    getAddress_d();
 
-        case 0x96:  /* STX d,y */
-            getAddress_dxy();
+    op_STZ();
+}
 
-            op_STX();
+/* ADC d */
+void opcode_65()
+{
+    getAddress_d();
+    fetchOperand(operand.m);
 
-            break;
+    op_ADC();
+}
 
-        case 0x97:  /* STA [d],y */
-            getAddress_dixl();
+/* ROR d */
+void opcode_66()
+{
+    getAddress_d();
 
-            op_STA();
+    fetchOperand(operand.m);
+    op_ROR();
+    storeOperand(operand.m);
+}
 
-            break;
+/* ADC [d] */
+void opcode_67()
+{
+    getAddress_dil();
+    fetchOperand(operand.m);
 
-        case 0x98:  /* TYA i */
-            A = static_cast<MemSizeType> (cpu->Y);
+    op_ADC();
+}
 
-            checkIfNegative(A);
-            checkIfZero(A);
+/* PLA s */
+void opcode_68()
+{
+    stackPull(A);
+    checkIfNegative(A);
+    checkIfZero(A);
+}
 
-            break;
+/* ADC # */
+void opcode_69()
+{
+    fetchImmediateOperand(operand.m);
 
-        case 0x99:  /* STA a,y */
-            getAddress_axy();
+    op_ADC();
+}
 
-            op_STA();
+/* ROR A */
+void opcode_6A()
+{
+    operand.m = A;
+    op_ROR();
+    A = operand.m;
+}
 
-            break;
+/* RTL s */
+void opcode_6B()
+{
+    const uint32_t from = linearAddress(PBR, PC - 1);
 
-        case 0x9A:  /* TXS i */
-            S = X;
+    stackPull(PC);
+    stackPull(PBR);
 
-            break;
+    ++PC;
 
-        case 0x9B:  /* TXY i */
-            Y = X;
+    checkBankMode();
+    profileReturn(from);
 
-            checkIfNegative(Y);
-            checkIfZero(Y);
+    if (linearAddress(PBR, PC) == system->tool_return) trapToolReturn();
+}
 
-            break;
+/* JMP (a) */
+void opcode_6C()
+{
+    getAddress_ai();
 
-        case 0x9C:  /* STZ a */
-            getAddress_a();
+    jumpTo(operandAddress());
+}
 
-            op_STZ();
+/* ADC a */
+void opcode_6D()
+{
+    getAddress_a();
+    fetchOperand(operand.m);
 
-            break;
+    op_ADC();
+}
 
-        case 0x9D:  /* STA a,x */
-            getAddress_axx();
+/* ROR a */
+void opcode_6E()
+{
+    getAddress_a();
 
-            op_STA();
+    fetchOperand(operand.m);
+    op_ROR();
+    storeOperand(operand.m);
+}
 
-            break;
+/* ADC al */
+void opcode_6F()
+{
+    getAddress_al();
+    fetchOperand(operand.m);
 
-        case 0x9E:  /* STZ a,x */
-            getAddress_axx();
+    op_ADC();
+}
 
-            op_STZ();
+/* BVS r */
+void opcode_70()
+{
+    getAddress_pcr();
 
-            break;
+    if (SR.V) {
+        checkProgramPageCross();
 
-        case 0x9F:  /* STA al,x */
-            getAddress_alxx();
+        branchTo(operandAddress());
 
-            op_STA();
+        ++cpu->num_cycles;
+    }
+}
 
-            break;
+/* ADC (d),y */
+void opcode_71()
+{
+    getAddress_dix();
+    fetchOperand(operand.m);
 
-        case 0xA0:  /* LDY # */
-            fetchImmediateOperand(operand.x);
+    op_ADC();
+}
 
-            op_LDY();
+/* ADC (d) */
+void opcode_72()
+{
+    getAddress_di();
+    fetchOperand(operand.m);
 
-            break;
+    op_ADC();
+}
 
-        case 0xA1:  /* LDA (d,x) */
-            getAddress_dxi();
-            fetchOperand(operand.m);
+/* ADC (d,s),y */
+void opcode_73()
+{
+    getAddress_srix();
+    fetchOperand(operand.m);
 
-            op_LDA();
+    op_ADC();
+}
 
-            break;
+/* STZ d,x */
+void opcode_74()
+{
+    getAddress_dxx();
 
-        case 0xA2:  /* LDX # */
-            fetchImmediateOperand(operand.x);
+    op_STZ();
+}
 
-            op_LDX();
+/* ADC d,x */
+void opcode_75()
+{
+    getAddress_dxx();
+    fetchOperand(operand.m);
 
-            break;
+    op_ADC();
+}
 
-        case 0xA3:  /* LDA d,s */
-            getAddress_sr();
-            fetchOperand(operand.m);
+/* ROR d,x */
+void opcode_76()
+{
+    getAddress_dxx();
 
-            op_LDA();
+    fetchOperand(operand.m);
+    op_ROR();
+    storeOperand(operand.m);
+}
 
-            break;
+/* ADC [d],y */
+void opcode_77()
+{
+    getAddress_dixl();
+    fetchOperand(operand.m);
 
-        case 0xA4:  /* LDY d */
-            getAddress_d();
-            fetchOperand(operand.x);
+    op_ADC();
+}
 
-            op_LDY();
+/* SEI i */
+void opcode_78()
+{
+    SR.I = true;
+}
 
-            break;
+/* ADC a,y */
+void opcode_79()
+{
+    getAddress_axy();
+    fetchOperand(operand.m);
 
-        case 0xA5:  /* LDA d */
-            getAddress_d();
-            fetchOperand(operand.m);
+    op_ADC();
+}
 
-            op_LDA();
+/* PLY */
+void opcode_7A()
+{
+    stackPull(Y);
+    checkIfNegative(Y);
+    checkIfZero(Y);
+}
 
-            break;
+/* TDC i */
+void opcode_7B()
+{
+    op_TDC();
+}
 
-        case 0xA6:  /* LDX d */
-            getAddress_d();
-            fetchOperand(operand.x);
+/* JMP (a,x) */
+void opcode_7C()
+{
+    getAddress_axi();
 
-            op_LDX();
+    jumpTo(operandAddress());
+}
 
-            break;
+/* ADC a,x */
+void opcode_7D()
+{
+    getAddress_axx();
+    fetchOperand(operand.m);
 
-        case 0xA7:  /* LDA [d] */
-            getAddress_dil();
-            fetchOperand(operand.m);
+    op_ADC();
+}
 
-            op_LDA();
+/* ROR a,x */
+void opcode_7E()
+{
+    getAddress_axx();
 
-            break;
+    fetchOperand(operand.m);
+    op_ROR();
+    storeOperand(operand.m);
+}
 
-        case 0xA8:  /* TAY i */
-            // transfer all bits when x=0, even if m=1
-            Y = static_cast<IndexSizeType> (cpu->A);
+/* ADC al,x */
+void opcode_7F()
+{
+    getAddress_alxx();
+    fetchOperand(operand.m);
 
-            checkIfNegative(Y);
-            checkIfZero(Y);
+    op_ADC();
+}
 
-            break;
+/* BRA r */
+void opcode_80()
+{
+    getAddress_pcr();
 
-        case 0xA9:  /* LDA # */
-            fetchImmediateOperand(operand.m);
+    checkProgramPageCross();
+    branchTo(operandAddress());
+}
 
-            op_LDA();
+/* STA (d,x) */
+void opcode_81()
+{
+    getAddress_dxi();
 
-            break;
+    op_STA();
+}
 
-        case 0xAA:  /* TAX i */
-            // transfer all bits when x=0, even if m=1
-            X = static_cast<IndexSizeType> (cpu->A);
+/* BRL rl */
+void opcode_82()
+{
+    getAddress_pcrl();
 
-            checkIfNegative(X);
-            checkIfZero(X);
+    jumpTo(operandBank(), operandAddress());
+}
 
-            break;
+/* STA d,s */
+void opcode_83()
+{
+    getAddress_sr();
 
-        case 0xAB:  /* PLB s */
-            stackPull(DBR);
+    op_STA();
+}
 
-            checkIfNegative(DBR);
-            checkIfZero(DBR);
+/* STY d */
+void opcode_84()
+{
+    getAddress_d();
 
-            break;
+    op_STY();
+}
 
-        case 0xAC:  /* LDY a */
-            getAddress_a();
-            fetchOperand(operand.x);
+/* STA d */
+void opcode_85()
+{
+    getAddress_d();
 
-            op_LDY();
+    op_STA();
+}
 
-            break;
+/* STX d */
+void opcode_86()
+{
+    getAddress_d();
 
-        case 0xAD:  /* LDA a */
-            getAddress_a();
-            fetchOperand(operand.m);
+    op_STX();
+}
 
-            op_LDA();
+/* STA [d] */
+void opcode_87()
+{
+    getAddress_dil();
 
-            break;
+    op_STA();
+}
 
-        case 0xAE:  /* LDX a */
-            getAddress_a();
-            fetchOperand(operand.x);
+/* DEY i */
+void opcode_88()
+{
+    --Y;
 
-            op_LDX();
+    checkIfNegative(Y);
+    checkIfZero(Y);
+}
 
-            break;
+/* BIT # */
+void opcode_89()
+{
+    fetchImmediateOperand(operand.m);
 
-        case 0xAF:  /* LDA al */
-            getAddress_al();
-            fetchOperand(operand.m);
+    SR.setZResult(operand.m & A);
+}
 
-            op_LDA();
+/* TXA i */
+void opcode_8A()
+{
+    A = static_cast<MemSizeType> (X);
 
-            break;
+    checkIfNegative(A);
+    checkIfZero(A);
+}
 
-        case 0xB0:  /* BCS r */
-            getAddress_pcr();
+/* PHB */
+void opcode_8B()
+{
+    stackPush(DBR);
+}
 
-            if (SR.C) {
-                checkProgramPageCross();
+/* STY a */
+void opcode_8C()
+{
+    getAddress_a();
 
-                jumpTo(operand_addr);
+    op_STY();
+}
 
-                ++cpu->num_cycles;
-            }
+/* STA a */
+void opcode_8D()
+{
+    getAddress_a();
 
-            break;
+    op_STA();
+}
 
-        case 0xB1:  /* LDA (d),y */
-            getAddress_dix();
-            fetchOperand(operand.m);
+/* STX a */
+void opcode_8E()
+{
+    getAddress_a();
 
-            op_LDA();
+    op_STX();
+}
 
-            break;
+/* STA al */
+void opcode_8F()
+{
+    getAddress_al();
 
-        case 0xB2:  /* LDA (d) */
-            getAddress_di();
-            fetchOperand(operand.m);
+    op_STA();
+}
 
-            op_LDA();
+/* BCC r */
+void opcode_90()
+{
+    getAddress_pcr();
 
-            break;
+    if (!SR.C) {
+        checkProgramPageCross();
 
-        case 0xB3:  /* LDA (d,s),y */
-            getAddress_srix();
-            fetchOperand(operand.m);
+        branchTo(operandAddress());
 
-            op_LDA();
+        ++cpu->num_cycles;
+    }
+}
 
-            break;
+/* STA (d),y */
+void opcode_91()
+{
+    getAddress_dix();
 
-        case 0xB4:  /* LDY d,x */
-            getAddress_dxx();
-            fetchOperand(operand.x);
+    op_STA();
+}
 
-            op_LDY();
+/* STA (d) */
+void opcode_92()
+{
+    getAddress_di();
 
-            break;
+    op_STA();
+}
 
-        case 0xB5:  /* LDA d,x */
-            getAddress_dxx();
-            fetchOperand(operand.m);
+/* STA (d,s),y */
+void opcode_93()
+{
+    getAddress_srix();
 
-            op_LDA();
+    op_STA();
+}
 
-            break;
+/* STY d,x */
+void opcode_94()
+{
+    getAddress_dxx();
 
-        case 0xB6:  /* LDX d,y */
-            getAddress_dxy();
-            fetchOperand(operand.x);
+    op_STY();
+}
 
-            op_LDX();
+/* STA d,x */
+void opcode_95()
+{
+    getAddress_dxx();
 
-            break;
+    op_STA();
+}
 
-        case 0xB7:  /* LDA [d],y */
-            getAddress_dixl();
-            fetchOperand(operand.m);
+/* STX d,y */
+void opcode_96()
+{
+    getAddress_dxy();
 
-            op_LDA();
+    op_STX();
+}
 
-            break;
+/* STA [d],y */
+void opcode_97()
+{
+    getAddress_dixl();
 
-        case 0xB8:  /* CLV i */
-            SR.V = false;
+    op_STA();
+}
 
-            break;
+/* TYA i */
+void opcode_98()
+{
+    A = static_cast<MemSizeType> (Y);
 
-        case 0xB9:  /* LDA a,y */
-            getAddress_axy();
-            fetchOperand(operand.m);
+    checkIfNegative(A);
+    checkIfZero(A);
+}
 
-            op_LDA();
+/* STA a,y */
+void opcode_99()
+{
+    getAddress_axy();
 
-            break;
+    op_STA();
+}
 
-        case 0xBA:  /* TSX i */
-            X = S;
+/* TXS i */
+void opcode_9A()
+{
+    S = X;
+}
 
-            checkIfNegative(X);
-            checkIfZero(X);
+/* TXY i */
+void opcode_9B()
+{
+    Y = X;
 
-            break;
+    checkIfNegative(Y);
+    checkIfZero(Y);
+}
 
-        case 0xBB:  /* TYX i */
-            X = Y;
+/* STZ a */
+void opcode_9C()
+{
+    getAddress_a();
 
-            checkIfNegative(X);
-            checkIfZero(X);
+    op_STZ();
+}
 
-            break;
+/* STA a,x */
+void opcode_9D()
+{
+    getAddress_axx();
 
-        case 0xBC:  /* LDY a,x */
-            getAddress_axx();
-            fetchOperand(operand.x);
+    op_STA();
+}
 
-            op_LDY();
+/* STZ a,x */
+void opcode_9E()
+{
+    getAddress_axx();
 
-            break;
+    op_STZ();
+}
 
-        case 0xBD:  /* LDA a,x */
-            getAddress_axx();
-            fetchOperand(operand.m);
+/* STA al,x */
+void opcode_9F()
+{
+    getAddress_alxx();
 
-            op_LDA();
+    op_STA();
+}
 
-            break;
+/* LDY # */
+void opcode_A0()
+{
+    fetchImmediateOperand(operand.x);
 
-        case 0xBE:  /* LDX a,y */
-            getAddress_axy();
-            fetchOperand(operand.x);
+    op_LDY();
+}
 
-            op_LDX();
+/* LDA (d,x) */
+void opcode_A1()
+{
+    getAddress_dxi();
+    fetchOperand(operand.m);
 
-            break;
+    op_LDA();
+}
 
-        case 0xBF:  /* LDA al,x */
-            getAddress_alxx();
-            fetchOperand(operand.m);
+/* LDX # */
+void opcode_A2()
+{
+    fetchImmediateOperand(operand.x);
 
-            op_LDA();
+    op_LDX();
+}
 
-            break;
+/* LDA d,s */
+void opcode_A3()
+{
+    getAddress_sr();
+    fetchOperand(operand.m);
 
-        case 0xC0:  /* CPY # */
-            fetchImmediateOperand(operand.x);
-            op_CPY();
+    op_LDA();
+}
 
-            break;
+/* LDY d */
+void opcode_A4()
+{
+    getAddress_d();
+    fetchOperand(operand.x);
 
-        case 0xC1:  /* CMP (d,x) */
-            getAddress_dxi();
+    op_LDY();
+}
 
-            fetchOperand(operand.m);
-            op_CMP();
+/* LDA d */
+void opcode_A5()
+{
+    getAddress_d();
+    fetchOperand(operand.m);
 
-            break;
+    op_LDA();
+}
 
-        case 0xC2:  /* REP # */
-            fetchImmediateOperand(operand.b);
-            SR &= ~operand.b;
+/* LDX d */
+void opcode_A6()
+{
+    getAddress_d();
+    fetchOperand(operand.x);
 
-            cpu->modeSwitch();
+    op_LDX();
+}
 
-            break;
+/* LDA [d] */
+void opcode_A7()
+{
+    getAddress_dil();
+    fetchOperand(operand.m);
 
-        case 0xC3:  /* CMP d,s */
-            getAddress_sr();
+    op_LDA();
+}
 
-            fetchOperand(operand.m);
-            op_CMP();
+/* TAY i */
+void opcode_A8()
+{
+    // transfer all bits when x=0, even if m=1
+    Y = static_cast<IndexSizeType> (accumulatorWord());
 
-            break;
+    checkIfNegative(Y);
+    checkIfZero(Y);
+}
 
-        case 0xC4:  /* CPY d */
-            getAddress_d();
+/* LDA # */
+void opcode_A9()
+{
+    fetchImmediateOperand(operand.m);
 
-            fetchOperand(operand.x);
-            op_CPY();
+    op_LDA();
+}
 
-            break;
+/* TAX i */
+void opcode_AA()
+{
+    // transfer all bits when x=0, even if m=1
+    X = static_cast<IndexSizeType> (accumulatorWord());
 
-        case 0xC5:  /* CMP d */
-            getAddress_d();
+    checkIfNegative(X);
+    checkIfZero(X);
+}
 
-            fetchOperand(operand.m);
-            op_CMP();
+/* PLB s */
+void opcode_AB()
+{
+    stackPull(DBR);
 
-            break;
+    checkIfNegative(DBR);
+    checkIfZero(DBR);
 
-        case 0xC6:  /* DEC d */
-            getAddress_d();
-            fetchOperand(operand.m);
+    checkBankMode();
+}
 
-            op_DEC();
-            storeOperand(operand.m);
+/* LDY a */
+void opcode_AC()
+{
+    getAddress_a();
+    fetchOperand(operand.x);
 
-            break;
+    op_LDY();
+}
 
-        case 0xC7:  /* CMP [d] */
-            getAddress_dil();
+/* LDA a */
+void opcode_AD()
+{
+    getAddress_a();
+    fetchOperand(operand.m);
 
-            fetchOperand(operand.m);
-            op_CMP();
+    op_LDA();
+}
 
-            break;
+/* LDX a */
+void opcode_AE()
+{
+    getAddress_a();
+    fetchOperand(operand.x);
 
-        case 0xC8:  /* INY */
-            ++Y;
+    op_LDX();
+}
 
-            checkIfNegative(Y);
-            checkIfZero(Y);
+/* LDA al */
+void opcode_AF()
+{
+    getAddress_al();
+    fetchOperand(operand.m);
 
-            break;
+    op_LDA();
+}
 
-        case 0xC9:  /* CMP # */
-            fetchImmediateOperand(operand.m);
-            op_CMP();
+/* BCS r */
+void opcode_B0()
+{
+    getAddress_pcr();
 
-            break;
+    if (SR.C) {
+        checkProgramPageCross();
 
-        case 0xCA:  /* DEX i */
-            --X;
+        branchTo(operandAddress());
 
-            checkIfNegative(X);
-            checkIfZero(X);
+        ++cpu->num_cycles;
+    }
+}
 
-            break;
+/* LDA (d),y */
+void opcode_B1()
+{
+    getAddress_dix();
+    fetchOperand(operand.m);
 
-        case 0xCB:  /* WAI */
-            cpu->waiting = true;
+    op_LDA();
+}
 
-            break;
+/* LDA (d) */
+void opcode_B2()
+{
+    getAddress_di();
+    fetchOperand(operand.m);
 
-        case 0xCC:  /* CPY a */
-            getAddress_a();
+    op_LDA();
+}
 
-            fetchOperand(operand.x);
-            op_CPY();
+/* LDA (d,s),y */
+void opcode_B3()
+{
+    getAddress_srix();
+    fetchOperand(operand.m);
 
-            break;
+    op_LDA();
+}
 
-        case 0xCD:  /* CMP a */
-            getAddress_a();
+/* LDY d,x */
+void opcode_B4()
+{
+    getAddress_dxx();
+    fetchOperand(operand.x);
 
-            fetchOperand(operand.m);
-            op_CMP();
+    op_LDY();
+}
 
-            break;
+/* LDA d,x */
+void opcode_B5()
+{
+    getAddress_dxx();
+    fetchOperand(operand.m);
 
-        case 0xCE:  /* DEC a */
-            getAddress_a();
-            fetchOperand(operand.m);
+    op_LDA();
+}
 
-            op_DEC();
-            storeOperand(operand.m);
+/* LDX d,y */
+void opcode_B6()
+{
+    getAddress_dxy();
+    fetchOperand(operand.x);
 
-            break;
+    op_LDX();
+}
 
-        case 0xCF:  /* CMP al */
-            getAddress_al();
+/* LDA [d],y */
+void opcode_B7()
+{
+    getAddress_dixl();
+    fetchOperand(operand.m);
 
-            fetchOperand(operand.m);
-            op_CMP();
+    op_LDA();
+}
 
-            break;
+/* CLV i */
+void opcode_B8()
+{
+    SR.V = false;
+}
 
-        case 0xD0:  /* BNE r */
-            getAddress_pcr();
+/* LDA a,y */
+void opcode_B9()
+{
+    getAddress_axy();
+    fetchOperand(operand.m);
 
-            if (!SR.Z) {
-                checkProgramPageCross();
+    op_LDA();
+}
 
-                jumpTo(operand_addr);
+/* TSX i */
+void opcode_BA()
+{
+    X = S;
 
-                ++cpu->num_cycles;
-            }
+    checkIfNegative(X);
+    checkIfZero(X);
+}
 
-            break;
+/* TYX i */
+void opcode_BB()
+{
+    X = Y;
 
-        case 0xD1:  /* CMP (d),y */
-            getAddress_dix();
+    checkIfNegative(X);
+    checkIfZero(X);
+}
 
-            fetchOperand(operand.m);
-            op_CMP();
+/* LDY a,x */
+void opcode_BC()
+{
+    getAddress_axx();
+    fetchOperand(operand.x);
 
-            break;
+    op_LDY();
+}
 
-        case 0xD2:  /* CMP (d) */
-            getAddress_di();
+/* LDA a,x */
+void opcode_BD()
+{
+    getAddress_axx();
+    fetchOperand(operand.m);
 
-            fetchOperand(operand.m);
-            op_CMP();
+    op_LDA();
+}
 
-            break;
+/* LDX a,y */
+void opcode_BE()
+{
+    getAddress_axy();
+    fetchOperand(operand.x);
 
-        case 0xD3:  /* CMP (d,s),y */
-            getAddress_srix();
+    op_LDX();
+}
 
-            fetchOperand(operand.m);
-            op_CMP();
+/* LDA al,x */
+void opcode_BF()
+{
+    getAddress_alxx();
+    fetchOperand(operand.m);
 
-            break;
+    op_LDA();
+}
 
-        case 0xD4:  /* PEI d */
-            getAddress_d();
-            fetchOperand(operand.w);
+/* CPY # */
+void opcode_C0()
+{
+    fetchImmediateOperand(operand.x);
+    op_CPY();
+}
 
-            stackPush(operand.w);
+/* CMP (d,x) */
+void opcode_C1()
+{
+    getAddress_dxi();
 
-            break;
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-        case 0xD5:  /* CMP d,x */
-            getAddress_dxx();
+/* REP # */
+void opcode_C2()
+{
+    fetchImmediateOperand(operand.b);
+    SR &= ~operand.b;
 
-            fetchOperand(operand.m);
-            op_CMP();
+    checkRegisterMode();
+    checkPendingIRQ();
+}
 
-            break;
+/* CMP d,s */
+void opcode_C3()
+{
+    getAddress_sr();
 
-        case 0xD6:  /* DEC d,x */
-            getAddress_dxx();
-            fetchOperand(operand.m);
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-            op_DEC();
-            storeOperand(operand.m);
+/* CPY d */
+void opcode_C4()
+{
+    getAddress_d();
 
-            break;
+    fetchOperand(operand.x);
+    op_CPY();
+}
 
-        case 0xD7:  /* CMP [d],y */
-            getAddress_dixl();
+/* CMP d */
+void opcode_C5()
+{
+    getAddress_d();
 
-            fetchOperand(operand.m);
-            op_CMP();
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-            break;
+/* DEC d */
+void opcode_C6()
+{
+    getAddress_d();
+    fetchOperand(operand.m);
 
-        case 0xD8:  /* CLD i */
-            SR.D = false;
+    op_DEC();
+    storeOperand(operand.m);
+}
 
-            break;
+/* CMP [d] */
+void opcode_C7()
+{
+    getAddress_dil();
 
-        case 0xD9:  /* CMP a,y */
-            getAddress_axy();
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-            fetchOperand(operand.m);
-            op_CMP();
+/* INY */
+void opcode_C8()
+{
+    ++Y;
 
-            break;
+    checkIfNegative(Y);
+    checkIfZero(Y);
+}
 
-        case 0xDA:  /* PHX */
-            stackPush(X);
+/* CMP # */
+void opcode_C9()
+{
+    fetchImmediateOperand(operand.m);
+    op_CMP();
+}
 
-            break;
+/* DEX i */
+void opcode_CA()
+{
+    --X;
 
-        case 0xDB:  /* STP */
-            cpu->stopped = true;
+    checkIfNegative(X);
+    checkIfZero(X);
+}
 
-            break;
+/* WAI */
+void opcode_CB()
+{
+    cpu->waiting = true;
 
-        case 0xDC:  /* JML (a) */
-            getAddress_ail();
+    cpu->endSlice();
+}
 
-            jumpTo(operand_bank, operand_addr);
+/* CPY a */
+void opcode_CC()
+{
+    getAddress_a();
 
-            break;
+    fetchOperand(operand.x);
+    op_CPY();
+}
 
-        case 0xDD:  /* CMP a,x */
-            getAddress_axx();
+/* CMP a */
+void opcode_CD()
+{
+    getAddress_a();
 
-            fetchOperand(operand.m);
-            op_CMP();
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-            break;
+/* DEC a */
+void opcode_CE()
+{
+    getAddress_a();
+    fetchOperand(operand.m);
 
-        case 0xDE:  /* DEC a,x */
-            getAddress_axx();
-            fetchOperand(operand.m);
+    op_DEC();
+    storeOperand(operand.m);
+}
 
-            op_DEC();
-            storeOperand(operand.m);
+/* CMP al */
+void opcode_CF()
+{
+    getAddress_al();
 
-            break;
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-        case 0xDF:  /* CMP al,x */
-            getAddress_alxx();
+/* BNE r */
+void opcode_D0()
+{
+    getAddress_pcr();
 
-            fetchOperand(operand.m);
-            op_CMP();
+    if (!SR.Z()) {
+        checkProgramPageCross();
 
-            break;
+        branchTo(operandAddress());
 
-        case 0xE0:  /* CPX # */
-            fetchImmediateOperand(operand.x);
-            op_CPX();
+        ++cpu->num_cycles;
+    }
+}
 
-            break;
+/* CMP (d),y */
+void opcode_D1()
+{
+    getAddress_dix();
 
-        case 0xE1: /* SBC (d,x) */
-            getAddress_dxi();
-            fetchOperand(operand.m);
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-            op_SBC();
+/* CMP (d) */
+void opcode_D2()
+{
+    getAddress_di();
 
-            break;
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-        case 0xE2:  /* SEP # */
-            fetchImmediateOperand(operand.b);
-            SR |= operand.b;
+/* CMP (d,s),y */
+void opcode_D3()
+{
+    getAddress_srix();
 
-            cpu->modeSwitch();
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-            break;
+/* PEI d */
+void opcode_D4()
+{
+    getAddress_d();
+    fetchOperand(operand.w);
 
-        case 0xE3:  /* SBC d,s */
-            getAddress_sr();
-            fetchOperand(operand.m);
+    stackPush(operand.w);
+}
 
-            op_SBC();
+/* CMP d,x */
+void opcode_D5()
+{
+    getAddress_dxx();
 
-            break;
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-        case 0xE4:  /* CPX d */
-            getAddress_d();
+/* DEC d,x */
+void opcode_D6()
+{
+    getAddress_dxx();
+    fetchOperand(operand.m);
 
-            fetchOperand(operand.x);
-            op_CPX();
+    op_DEC();
+    storeOperand(operand.m);
+}
 
-            break;
+/* CMP [d],y */
+void opcode_D7()
+{
+    getAddress_dixl();
 
-        case 0xE5:  /* SBC d */
-            getAddress_d();
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-            fetchOperand(operand.m);
-            op_SBC();
+/* CLD i */
+void opcode_D8()
+{
+    SR.D = false;
+}
 
-            break;
+/* CMP a,y */
+void opcode_D9()
+{
+    getAddress_axy();
 
-        case 0xE6:  /* INC d */
-            getAddress_d();
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-            fetchOperand(operand.m);
-            op_INC();
-            storeOperand(operand.m);
+/* PHX */
+void opcode_DA()
+{
+    stackPush(X);
+}
 
-            break;
+/* STP */
+void opcode_DB()
+{
+    cpu->stopped = true;
 
-        case 0xE7:  /* SBC [d] */
-            getAddress_di();
+    cpu->endSlice();
+}
 
-            fetchOperand(operand.m);
-            op_SBC();
+/* JML (a) */
+void opcode_DC()
+{
+    getAddress_ail();
 
-            break;
+    jumpTo(operandBank(), operandAddress());
+}
 
-        case 0xE8:  /* INX */
-            ++X;
+/* CMP a,x */
+void opcode_DD()
+{
+    getAddress_axx();
 
-            checkIfNegative(X);
-            checkIfZero(X);
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-            break;
+/* DEC a,x */
+void opcode_DE()
+{
+    getAddress_axx();
+    fetchOperand(operand.m);
 
-        case 0xE9:  /* SBC # */
-            fetchImmediateOperand(operand.m);
+    op_DEC();
+    storeOperand(operand.m);
+}
 
-            op_SBC();
+/* CMP al,x */
+void opcode_DF()
+{
+    getAddress_alxx();
 
-            break;
+    fetchOperand(operand.m);
+    op_CMP();
+}
 
-        case 0xEA:
-            break;
+/* CPX # */
+void opcode_E0()
+{
+    fetchImmediateOperand(operand.x);
+    op_CPX();
+}
 
-        case 0xEB:  /* XBA i */
-            operand.b = cpu->A.B.H;
-            cpu->A.B.H = cpu->A.B.L;
-            cpu->A.B.L = operand.b;
+/* SBC (d,x) */
+void opcode_E1()
+{
+    getAddress_dxi();
+    fetchOperand(operand.m);
 
-            checkIfNegative(cpu->A.B.L);
-            checkIfZero(cpu->A.B.L);
+    op_SBC();
+}
 
-            break;
+/* SEP # */
+void opcode_E2()
+{
+    fetchImmediateOperand(operand.b);
+    SR |= operand.b;
 
-        case 0xEC:  /* CPX a */
-            getAddress_a();
+    checkRegisterMode();
+}
 
-            fetchOperand(operand.x);
-            op_CPX();
+/* SBC d,s */
+void opcode_E3()
+{
+    getAddress_sr();
+    fetchOperand(operand.m);
 
-            break;
+    op_SBC();
+}
 
-        case 0xED: /* SBC a */
-            getAddress_a();
+/* CPX d */
+void opcode_E4()
+{
+    getAddress_d();
 
-            fetchOperand(operand.m);
-            op_SBC();
+    fetchOperand(operand.x);
+    op_CPX();
+}
 
-            break;
+/* SBC d */
+void opcode_E5()
+{
+    getAddress_d();
 
-        case 0xEE:  /* INC a */
-            getAddress_a();
+    fetchOperand(operand.m);
+    op_SBC();
+}
 
-            fetchOperand(operand.m);
-            op_INC();
-            storeOperand(operand.m);
+/* INC d */
+void opcode_E6()
+{
+    getAddress_d();
 
-            break;
+    fetchOperand(operand.m);
+    op_INC();
+    storeOperand(operand.m);
+}
 
-        case 0xEF:  /* SBC al */
-            getAddress_al();
+/* SBC [d] */
+void opcode_E7()
+{
+    getAddress_di();
 
-            fetchOperand(operand.m);
-            op_SBC();
+    fetchOperand(operand.m);
+    op_SBC();
+}
 
-            break;
+/* INX */
+void opcode_E8()
+{
+    ++X;
 
-        case 0xF0:  /* BEQ r */
-            getAddress_pcr();
+    checkIfNegative(X);
+    checkIfZero(X);
+}
 
-            if (SR.Z) {
-                checkProgramPageCross();
+/* SBC # */
+void opcode_E9()
+{
+    fetchImmediateOperand(operand.m);
 
-                jumpTo(operand_addr);
+    op_SBC();
+}
 
-                ++cpu->num_cycles;
-            }
+/* NOP i */
+void opcode_EA()
+{
+}
 
-            break;
+/* XBA i */
+void opcode_EB()
+{
+    const uint16_t w = accumulatorWord();
 
-        case 0xF1:  /* SBC (d),y */
-            getAddress_dix();
+    operand.b = w >> 8;
 
-            fetchOperand(operand.m);
-            op_SBC();
+    setAccumulatorWord((w << 8) | operand.b);
 
-            break;
+    checkIfNegative(operand.b);
+    checkIfZero(operand.b);
+}
 
-        case 0xF2:  /* SBC (d) */
-            getAddress_di();
+/* CPX a */
+void opcode_EC()
+{
+    getAddress_a();
 
-            fetchOperand(operand.m);
-            op_SBC();
+    fetchOperand(operand.x);
+    op_CPX();
+}
 
-            break;
+/* SBC a */
+void opcode_ED()
+{
+    getAddress_a();
 
-        case 0xF3:  /* SBC (d,s),y */
-            getAddress_srix();
+    fetchOperand(operand.m);
+    op_SBC();
+}
 
-            fetchOperand(operand.m);
-            op_SBC();
+/* INC a */
+void opcode_EE()
+{
+    getAddress_a();
 
-            break;
+    fetchOperand(operand.m);
+    op_INC();
+    storeOperand(operand.m);
+}
 
-        case 0xF4:  /* PEA s */
-            fetchImmediateOperand(operand.w);
-            stackPush(operand.w);
+/* SBC al */
+void opcode_EF()
+{
+    getAddress_al();
 
-            break;
+    fetchOperand(operand.m);
+    op_SBC();
+}
 
-        case 0xF5:  /* SBC d,x */
-            getAddress_dxx();
+/* BEQ r */
+void opcode_F0()
+{
+    getAddress_pcr();
 
-            fetchOperand(operand.m);
-            op_SBC();
+    if (SR.Z()) {
+        checkProgramPageCross();
 
-            break;
+        branchTo(operandAddress());
 
-        case 0xF6:  /* INC d,x */
-            getAddress_dxx();
+        ++cpu->num_cycles;
+    }
+}
 
-            fetchOperand(operand.m);
-            op_INC();
-            storeOperand(operand.m);
+/* SBC (d),y */
+void opcode_F1()
+{
+    getAddress_dix();
 
-            break;
+    fetchOperand(operand.m);
+    op_SBC();
+}
 
-        case 0xF7:  /* SBC [d],y */
-            getAddress_dixl();
+/* SBC (d) */
+void opcode_F2()
+{
+    getAddress_di();
 
-            fetchOperand(operand.m);
-            op_SBC();
+    fetchOperand(operand.m);
+    op_SBC();
+}
 
-            break;
+/* SBC (d,s),y */
+void opcode_F3()
+{
+    getAddress_srix();
 
-        case 0xF8:  /* SED i */
-            SR.D = true;
+    fetchOperand(operand.m);
+    op_SBC();
+}
 
-            break;
+/* PEA s */
+void opcode_F4()
+{
+    fetchImmediateOperand(operand.w);
+    stackPush(operand.w);
+}
 
-        case 0xF9:  /* SBC a,y */
-            getAddress_axy();
+/* SBC d,x */
+void opcode_F5()
+{
+    getAddress_dxx();
 
-            fetchOperand(operand.m);
-            op_SBC();
+    fetchOperand(operand.m);
+    op_SBC();
+}
 
-            break;
+/* INC d,x */
+void opcode_F6()
+{
+    getAddress_dxx();
 
-        case 0xFA:  /* PLX s */
-            stackPull(X);
-            checkIfNegative(X);
-            checkIfZero(X);
+    fetchOperand(operand.m);
+    op_INC();
+    storeOperand(operand.m);
+}
 
-            break;
+/* SBC [d],y */
+void opcode_F7()
+{
+    getAddress_dixl();
 
-        case 0xFB:   /* XCE i */
-            operand.b = SR.E;
-            SR.E = SR.C;
-            SR.C = operand.b;
+    fetchOperand(operand.m);
+    op_SBC();
+}
 
-            cpu->modeSwitch();
+/* SED i */
+void opcode_F8()
+{
+    SR.D = true;
+}
 
-            break;
+/* SBC a,y */
+void opcode_F9()
+{
+    getAddress_axy();
 
-        case 0xFC:  /* JSR (a,x) */
-            getAddress_axi();
+    fetchOperand(operand.m);
+    op_SBC();
+}
 
-            --PC;
+/* PLX s */
+void opcode_FA()
+{
+    stackPull(X);
+    checkIfNegative(X);
+    checkIfZero(X);
+}
 
-            stackPush(PC);
-            jumpTo(operand_addr);
+/* XCE i */
+void opcode_FB()
+{
+    operand.b = SR.E;
+    SR.E = SR.C;
+    SR.C = operand.b;
 
-            break;
+    checkRegisterMode();
+}
 
-        case 0xFD:  /* SBC a,x */
-            getAddress_axx();
-            fetchOperand(operand.m);
+/* JSR (a,x) */
+void opcode_FC()
+{
+    getAddress_axi();
 
-            op_SBC();
+    --PC;
 
-            break;
+    const uint32_t from = linearAddress(PBR, PC - 2);
 
-        case 0xFE:  /* INC a,x */
-            getAddress_axx();
-            fetchOperand(operand.m);
+    stackPush(PC);
+    jumpTo(operandAddress());
 
-            op_INC();
+    profileCall(from);
+}
 
-            storeOperand(operand.m);
+/* SBC a,x */
+void opcode_FD()
+{
+    getAddress_axx();
+    fetchOperand(operand.m);
 
-            break;
+    op_SBC();
+}
 
-        case 0xFF:  /* SBC al,x */
-            getAddress_alxx();
-            fetchOperand(operand.m);
+/* INC a,x */
+void opcode_FE()
+{
+    getAddress_axx();
+    fetchOperand(operand.m);
 
-            op_SBC();
+    op_INC();
 
-            break;
+    storeOperand(operand.m);
+}
 
-        case 0x100: /* irq */
-            cpu->waiting = false;
+/* SBC al,x */
+void opcode_FF()
+{
+    getAddress_alxx();
+    fetchOperand(operand.m);
 
-            if (StackOffset) {
-                stackPush(PC);
-                stackPush((uint8_t) (SR & ~0x10));
-            }
-            else {
-                stackPush(PBR);
-                stackPush(PC);
-                stackPush(SR);
-            }
+    op_SBC();
+}
 
-            SR.D = false;
-            SR.I = true;
+/* irq */
+void opcode_100()
+{
+    cpu->waiting = false;
 
-            cpu->loadVector(StackOffset? 0xFFFE : 0xFFEE);
+    if (StackOffset) {
+        stackPush(PC);
+        stackPush((uint8_t) (SR & ~0x10));
+    }
+    else {
+        stackPush(PBR);
+        stackPush(PC);
+        stackPush(SR);
+    }
 
-            break;
+    SR.D = false;
+    SR.I = true;
 
-        case 0x101: /* nmi */
-            cpu->nmi_pending = cpu->waiting = false;
+    loadVector(StackOffset? 0xFFFE : 0xFFEE);
+}
 
-            if (!StackOffset) {
-                stackPush(PBR);
-            }
+/* nmi */
+void opcode_101()
+{
+    cpu->nmi_pending = cpu->waiting = false;
 
-            stackPush(PC);
-            stackPush(SR);
+    if (!StackOffset) {
+        stackPush(PBR);
+    }
 
-            SR.D = false;
-            SR.I = true;
+    stackPush(PC);
+    stackPush(SR);
 
-            cpu->loadVector(StackOffset? 0xFFFA : 0xFFEA);
+    SR.D = false;
+    SR.I = true;
 
-            break;
+    loadVector(StackOffset? 0xFFFA : 0xFFEA);
+}
 
-        case 0x102: /* abort */
-            cpu->abort_pending = cpu->waiting = false;
+/* abort */
+void opcode_102()
+{
+    cpu->abort_pending = cpu->waiting = false;
 
-            if (!StackOffset) {
-                stackPush(PBR);
-            }
+    if (!StackOffset) {
+        stackPush(PBR);
+    }
 
-            stackPush(PC);
-            stackPush(SR);
+    stackPush(PC);
+    stackPush(SR);
 
-            SR.D = false;
-            SR.I = true;
+    SR.D = false;
+    SR.I = true;
 
-            cpu->loadVector(StackOffset? 0xFFF8 : 0xFFE8);
+    loadVector(StackOffset? 0xFFF8 : 0xFFE8);
+}
 
-            break;
+void executeOpcode(unsigned int opcode)
+{
+    switch (opcode) {
+        case 0x00: opcode_00(); break;
+        case 0x01: opcode_01(); break;
+        case 0x02: opcode_02(); break;
+        case 0x03: opcode_03(); break;
+        case 0x04: opcode_04(); break;
+        case 0x05: opcode_05(); break;
+        case 0x06: opcode_06(); break;
+        case 0x07: opcode_07(); break;
+        case 0x08: opcode_08(); break;
+        case 0x09: opcode_09(); break;
+        case 0x0A: opcode_0A(); break;
+        case 0x0B: opcode_0B(); break;
+        case 0x0C: opcode_0C(); break;
+        case 0x0D: opcode_0D(); break;
+        case 0x0E: opcode_0E(); break;
+        case 0x0F: opcode_0F(); break;
+        case 0x10: opcode_10(); break;
+        case 0x11: opcode_11(); break;
+        case 0x12: opcode_12(); break;
+        case 0x13: opcode_13(); break;
+        case 0x14: opcode_14(); break;
+        case 0x15: opcode_15(); break;
+        case 0x16: opcode_16(); break;
+        case 0x17: opcode_17(); break;
+        case 0x18: opcode_18(); break;
+        case 0x19: opcode_19(); break;
+        case 0x1A: opcode_1A(); break;
+        case 0x1B: opcode_1B(); break;
+        case 0x1C: opcode_1C(); break;
+        case 0x1D: opcode_1D(); break;
+        case 0x1E: opcode_1E(); break;
+        case 0x1F: opcode_1F(); break;
+        case 0x20: opcode_20(); break;
+        case 0x21: opcode_21(); break;
+        case 0x22: opcode_22(); break;
+        case 0x23: opcode_23(); break;
+        case 0x24: opcode_24(); break;
+        case 0x25: opcode_25(); break;
+        case 0x26: opcode_26(); break;
+        case 0x27: opcode_27(); break;
+        case 0x28: opcode_28(); break;
+        case 0x29: opcode_29(); break;
+        case 0x2A: opcode_2A(); break;
+        case 0x2B: opcode_2B(); break;
+        case 0x2C: opcode_2C(); break;
+        case 0x2D: opcode_2D(); break;
+        case 0x2E: opcode_2E(); break;
+        case 0x2F: opcode_2F(); break;
+        case 0x30: opcode_30(); break;
+        case 0x31: opcode_31(); break;
+        case 0x32: opcode_32(); break;
+        case 0x33: opcode_33(); break;
+        case 0x34: opcode_34(); break;
+        case 0x35: opcode_35(); break;
+        case 0x36: opcode_36(); break;
+        case 0x37: opcode_37(); break;
+        case 0x38: opcode_38(); break;
+        case 0x39: opcode_39(); break;
+        case 0x3A: opcode_3A(); break;
+        case 0x3B: opcode_3B(); break;
+        case 0x3C: opcode_3C(); break;
+        case 0x3D: opcode_3D(); break;
+        case 0x3E: opcode_3E(); break;
+        case 0x3F: opcode_3F(); break;
+        case 0x40: opcode_40(); break;
+        case 0x41: opcode_41(); break;
+        case 0x42: opcode_42(); break;
+        case 0x43: opcode_43(); break;
+        case 0x44: opcode_44(); break;
+        case 0x45: opcode_45(); break;
+        case 0x46: opcode_46(); break;
+        case 0x47: opcode_47(); break;
+        case 0x48: opcode_48(); break;
+        case 0x49: opcode_49(); break;
+        case 0x4A: opcode_4A(); break;
+        case 0x4B: opcode_4B(); break;
+        case 0x4C: opcode_4C(); break;
+        case 0x4D: opcode_4D(); break;
+        case 0x4E: opcode_4E(); break;
+        case 0x4F: opcode_4F(); break;
+        case 0x50: opcode_50(); break;
+        case 0x51: opcode_51(); break;
+        case 0x52: opcode_52(); break;
+        case 0x53: opcode_53(); break;
+        case 0x54: opcode_54(); break;
+        case 0x55: opcode_55(); break;
+        case 0x56: opcode_56(); break;
+        case 0x57: opcode_57(); break;
+        case 0x58: opcode_58(); break;
+        case 0x59: opcode_59(); break;
+        case 0x5A: opcode_5A(); break;
+        case 0x5B: opcode_5B(); break;
+        case 0x5C: opcode_5C(); break;
+        case 0x5D: opcode_5D(); break;
+        case 0x5E: opcode_5E(); break;
+        case 0x5F: opcode_5F(); break;
+        case 0x60: opcode_60(); break;
+        case 0x61: opcode_61(); break;
+        case 0x62: opcode_62(); break;
+        case 0x63: opcode_63(); break;
+        case 0x64: opcode_64(); break;
+        case 0x65: opcode_65(); break;
+        case 0x66: opcode_66(); break;
+        case 0x67: opcode_67(); break;
+        case 0x68: opcode_68(); break;
+        case 0x69: opcode_69(); break;
+        case 0x6A: opcode_6A(); break;
+        case 0x6B: opcode_6B(); break;
+        case 0x6C: opcode_6C(); break;
+        case 0x6D: opcode_6D(); break;
+        case 0x6E: opcode_6E(); break;
+        case 0x6F: opcode_6F(); break;
+        case 0x70: opcode_70(); break;
+        case 0x71: opcode_71(); break;
+        case 0x72: opcode_72(); break;
+        case 0x73: opcode_73(); break;
+        case 0x74: opcode_74(); break;
+        case 0x75: opcode_75(); break;
+        case 0x76: opcode_76(); break;
+        case 0x77: opcode_77(); break;
+        case 0x78: opcode_78(); break;
+        case 0x79: opcode_79(); break;
+        case 0x7A: opcode_7A(); break;
+        case 0x7B: opcode_7B(); break;
+        case 0x7C: opcode_7C(); break;
+        case 0x7D: opcode_7D(); break;
+        case 0x7E: opcode_7E(); break;
+        case 0x7F: opcode_7F(); break;
+        case 0x80: opcode_80(); break;
+        case 0x81: opcode_81(); break;
+        case 0x82: opcode_82(); break;
+        case 0x83: opcode_83(); break;
+        case 0x84: opcode_84(); break;
+        case 0x85: opcode_85(); break;
+        case 0x86: opcode_86(); break;
+        case 0x87: opcode_87(); break;
+        case 0x88: opcode_88(); break;
+        case 0x89: opcode_89(); break;
+        case 0x8A: opcode_8A(); break;
+        case 0x8B: opcode_8B(); break;
+        case 0x8C: opcode_8C(); break;
+        case 0x8D: opcode_8D(); break;
+        case 0x8E: opcode_8E(); break;
+        case 0x8F: opcode_8F(); break;
+        case 0x90: opcode_90(); break;
+        case 0x91: opcode_91(); break;
+        case 0x92: opcode_92(); break;
+        case 0x93: opcode_93(); break;
+        case 0x94: opcode_94(); break;
+        case 0x95: opcode_95(); break;
+        case 0x96: opcode_96(); break;
+        case 0x97: opcode_97(); break;
+        case 0x98: opcode_98(); break;
+        case 0x99: opcode_99(); break;
+        case 0x9A: opcode_9A(); break;
+        case 0x9B: opcode_9B(); break;
+        case 0x9C: opcode_9C(); break;
+        case 0x9D: opcode_9D(); break;
+        case 0x9E: opcode_9E(); break;
+        case 0x9F: opcode_9F(); break;
+        case 0xA0: opcode_A0(); break;
+        case 0xA1: opcode_A1(); break;
+        case 0xA2: opcode_A2(); break;
+        case 0xA3: opcode_A3(); break;
+        case 0xA4: opcode_A4(); break;
+        case 0xA5: opcode_A5(); break;
+        case 0xA6: opcode_A6(); break;
+        case 0xA7: opcode_A7(); break;
+        case 0xA8: opcode_A8(); break;
+        case 0xA9: opcode_A9(); break;
+        case 0xAA: opcode_AA(); break;
+        case 0xAB: opcode_AB(); break;
+        case 0xAC: opcode_AC(); break;
+        case 0xAD: opcode_AD(); break;
+        case 0xAE: opcode_AE(); break;
+        case 0xAF: opcode_AF(); break;
+        case 0xB0: opcode_B0(); break;
+        case 0xB1: opcode_B1(); break;
+        case 0xB2: opcode_B2(); break;
+        case 0xB3: opcode_B3(); break;
+        case 0xB4: opcode_B4(); break;
+        case 0xB5: opcode_B5(); break;
+        case 0xB6: opcode_B6(); break;
+        case 0xB7: opcode_B7(); break;
+        case 0xB8: opcode_B8(); break;
+        case 0xB9: opcode_B9(); break;
+        case 0xBA: opcode_BA(); break;
+        case 0xBB: opcode_BB(); break;
+        case 0xBC: opcode_BC(); break;
+        case 0xBD: opcode_BD(); break;
+        case 0xBE: opcode_BE(); break;
+        case 0xBF: opcode_BF(); break;
+        case 0xC0: opcode_C0(); break;
+        case 0xC1: opcode_C1(); break;
+        case 0xC2: opcode_C2(); break;
+        case 0xC3: opcode_C3(); break;
+        case 0xC4: opcode_C4(); break;
+        case 0xC5: opcode_C5(); break;
+        case 0xC6: opcode_C6(); break;
+        case 0xC7: opcode_C7(); break;
+        case 0xC8: opcode_C8(); break;
+        case 0xC9: opcode_C9(); break;
+        case 0xCA: opcode_CA(); break;
+        case 0xCB: opcode_CB(); break;
+        case 0xCC: opcode_CC(); break;
+        case 0xCD: opcode_CD(); break;
+        case 0xCE: opcode_CE(); break;
+        case 0xCF: opcode_CF(); break;
+        case 0xD0: opcode_D0(); break;
+        case 0xD1: opcode_D1(); break;
+        case 0xD2: opcode_D2(); break;
+        case 0xD3: opcode_D3(); break;
+        case 0xD4: opcode_D4(); break;
+        case 0xD5: opcode_D5(); break;
+        case 0xD6: opcode_D6(); break;
+        case 0xD7: opcode_D7(); break;
+        case 0xD8: opcode_D8(); break;
+        case 0xD9: opcode_D9(); break;
+        case 0xDA: opcode_DA(); break;
+        case 0xDB: opcode_DB(); break;
+        case 0xDC: opcode_DC(); break;
+        case 0xDD: opcode_DD(); break;
+        case 0xDE: opcode_DE(); break;
+        case 0xDF: opcode_DF(); break;
+        case 0xE0: opcode_E0(); break;
+        case 0xE1: opcode_E1(); break;
+        case 0xE2: opcode_E2(); break;
+        case 0xE3: opcode_E3(); break;
+        case 0xE4: opcode_E4(); break;
+        case 0xE5: opcode_E5(); break;
+        case 0xE6: opcode_E6(); break;
+        case 0xE7: opcode_E7(); break;
+        case 0xE8: opcode_E8(); break;
+        case 0xE9: opcode_E9(); break;
+        case 0xEA: opcode_EA(); break;
+        case 0xEB: opcode_EB(); break;
+        case 0xEC: opcode_EC(); break;
+        case 0xED: opcode_ED(); break;
+        case 0xEE: opcode_EE(); break;
+        case 0xEF: opcode_EF(); break;
+        case 0xF0: opcode_F0(); break;
+        case 0xF1: opcode_F1(); break;
+        case 0xF2: opcode_F2(); break;
+        case 0xF3: opcode_F3(); break;
+        case 0xF4: opcode_F4(); break;
+        case 0xF5: opcode_F5(); break;
+        case 0xF6: opcode_F6(); break;
+        case 0xF7: opcode_F7(); break;
+        case 0xF8: opcode_F8(); break;
+        case 0xF9: opcode_F9(); break;
+        case 0xFA: opcode_FA(); break;
+        case 0xFB: opcode_FB(); break;
+        case 0xFC: opcode_FC(); break;
+        case 0xFD: opcode_FD(); break;
+        case 0xFE: opcode_FE(); break;
+        case 0xFF: opcode_FF(); break;
+        case 0x100: opcode_100(); break;
+        case 0x101: opcode_101(); break;
+        case 0x102: opcode_102(); break;
 
         default:
             break;
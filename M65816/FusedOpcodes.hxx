@@ -0,0 +1,115 @@
+/**
+ * Superinstructions. Each of these executes a short, common sequence of
+ * instructions in a cached block with a single dispatch. When the
+ * block cache fuses a sequence it appends the later instructions' opcode
+ * and operand bytes to the first instruction's operands, so between steps
+ * we only have to skip over the next opcode byte.
+ *
+ * Only sequences whose leading instructions can't write memory or change
+ * the PC or CPU mode are fused, so the block can't be invalidated part way
+ * through, and the cycle count for the group is just the sum of the base
+ * cycle counts plus whatever penalties the individual handlers add. The
+ * one exception is a load from the I/O page, which can remap memory or
+ * end the slice; fuse2() checks for that between its two steps.
+ */
+
+inline void nextFusedOpcode()
+{
+    ++PC;
+    ++cpu->fetch_ptr;
+}
+
+template <void (LogicEngine::*First)(), void (LogicEngine::*Second)()>
+static void fuse2(LogicEngineBase *engine)
+{
+    LogicEngine *e = static_cast<LogicEngine *>(engine);
+    const unsigned int generation = e->system->map_generation;
+
+    (e->*First)();
+
+    // If the first step read a soft switch that remapped memory, or ended
+    // the slice, stop short of the second. PC is left on its opcode, so
+    // runBlock() drops out of the block and the main loop executes it.
+    if ((e->system->map_generation != generation) || !e->cpu->slice_limit) {
+        e->cpu->num_cycles -= e->cpu->cycle_counts[*e->cpu->fetch_ptr];
+
+        return;
+    }
+
+    e->nextFusedOpcode();
+    (e->*Second)();
+}
+
+template <void (LogicEngine::*First)(), void (LogicEngine::*Second)(), void (LogicEngine::*Third)()>
+static void fuse3(LogicEngineBase *engine)
+{
+    LogicEngine *e = static_cast<LogicEngine *>(engine);
+
+    (e->*First)();
+    e->nextFusedOpcode();
+    (e->*Second)();
+    e->nextFusedOpcode();
+    (e->*Third)();
+}
+
+/**
+ * Returns this engine's table of superinstructions, terminated by an entry
+ * with a count of zero. Longer sequences come first so they take priority.
+ */
+static const fused_opcode_t *fusedTable()
+{
+    static const fused_opcode_t table[] = {
+        // INX; CPX #; BNE and INY; CPY #; BNE
+        { 3, { 0xE8, 0xE0, 0xD0 }, &fuse3<&LogicEngine::opcode_E8, &LogicEngine::opcode_E0, &LogicEngine::opcode_D0> },
+        { 3, { 0xC8, 0xC0, 0xD0 }, &fuse3<&LogicEngine::opcode_C8, &LogicEngine::opcode_C0, &LogicEngine::opcode_D0> },
+
+        // DEX; BNE and DEY; BNE
+        { 2, { 0xCA, 0xD0 }, &fuse2<&LogicEngine::opcode_CA, &LogicEngine::opcode_D0> },
+        { 2, { 0x88, 0xD0 }, &fuse2<&LogicEngine::opcode_88, &LogicEngine::opcode_D0> },
+
+        // CLC; ADC
+        { 2, { 0x18, 0x69 }, &fuse2<&LogicEngine::opcode_18, &LogicEngine::opcode_69> },
+        { 2, { 0x18, 0x65 }, &fuse2<&LogicEngine::opcode_18, &LogicEngine::opcode_65> },
+        { 2, { 0x18, 0x6D }, &fuse2<&LogicEngine::opcode_18, &LogicEngine::opcode_6D> },
+        { 2, { 0x18, 0x7D }, &fuse2<&LogicEngine::opcode_18, &LogicEngine::opcode_7D> },
+        { 2, { 0x18, 0x79 }, &fuse2<&LogicEngine::opcode_18, &LogicEngine::opcode_79> },
+
+        // SEC; SBC
+        { 2, { 0x38, 0xE9 }, &fuse2<&LogicEngine::opcode_38, &LogicEngine::opcode_E9> },
+        { 2, { 0x38, 0xE5 }, &fuse2<&LogicEngine::opcode_38, &LogicEngine::opcode_E5> },
+        { 2, { 0x38, 0xED }, &fuse2<&LogicEngine::opcode_38, &LogicEngine::opcode_ED> },
+        { 2, { 0x38, 0xFD }, &fuse2<&LogicEngine::opcode_38, &LogicEngine::opcode_FD> },
+        { 2, { 0x38, 0xF9 }, &fuse2<&LogicEngine::opcode_38, &LogicEngine::opcode_F9> },
+
+        // LDA; STA
+        { 2, { 0xA9, 0x85 }, &fuse2<&LogicEngine::opcode_A9, &LogicEngine::opcode_85> },
+        { 2, { 0xA9, 0x8D }, &fuse2<&LogicEngine::opcode_A9, &LogicEngine::opcode_8D> },
+        { 2, { 0xA9, 0x95 }, &fuse2<&LogicEngine::opcode_A9, &LogicEngine::opcode_95> },
+        { 2, { 0xA9, 0x9D }, &fuse2<&LogicEngine::opcode_A9, &LogicEngine::opcode_9D> },
+        { 2, { 0xA9, 0x99 }, &fuse2<&LogicEngine::opcode_A9, &LogicEngine::opcode_99> },
+        { 2, { 0xA5, 0x85 }, &fuse2<&LogicEngine::opcode_A5, &LogicEngine::opcode_85> },
+        { 2, { 0xA5, 0x8D }, &fuse2<&LogicEngine::opcode_A5, &LogicEngine::opcode_8D> },
+        { 2, { 0xA5, 0x95 }, &fuse2<&LogicEngine::opcode_A5, &LogicEngine::opcode_95> },
+        { 2, { 0xA5, 0x9D }, &fuse2<&LogicEngine::opcode_A5, &LogicEngine::opcode_9D> },
+        { 2, { 0xA5, 0x99 }, &fuse2<&LogicEngine::opcode_A5, &LogicEngine::opcode_99> },
+        { 2, { 0xAD, 0x85 }, &fuse2<&LogicEngine::opcode_AD, &LogicEngine::opcode_85> },
+        { 2, { 0xAD, 0x8D }, &fuse2<&LogicEngine::opcode_AD, &LogicEngine::opcode_8D> },
+        { 2, { 0xAD, 0x95 }, &fuse2<&LogicEngine::opcode_AD, &LogicEngine::opcode_95> },
+        { 2, { 0xAD, 0x9D }, &fuse2<&LogicEngine::opcode_AD, &LogicEngine::opcode_9D> },
+        { 2, { 0xAD, 0x99 }, &fuse2<&LogicEngine::opcode_AD, &LogicEngine::opcode_99> },
+        { 2, { 0xBD, 0x85 }, &fuse2<&LogicEngine::opcode_BD, &LogicEngine::opcode_85> },
+        { 2, { 0xBD, 0x8D }, &fuse2<&LogicEngine::opcode_BD, &LogicEngine::opcode_8D> },
+        { 2, { 0xBD, 0x95 }, &fuse2<&LogicEngine::opcode_BD, &LogicEngine::opcode_95> },
+        { 2, { 0xBD, 0x9D }, &fuse2<&LogicEngine::opcode_BD, &LogicEngine::opcode_9D> },
+        { 2, { 0xBD, 0x99 }, &fuse2<&LogicEngine::opcode_BD, &LogicEngine::opcode_99> },
+        { 2, { 0xB9, 0x85 }, &fuse2<&LogicEngine::opcode_B9, &LogicEngine::opcode_85> },
+        { 2, { 0xB9, 0x8D }, &fuse2<&LogicEngine::opcode_B9, &LogicEngine::opcode_8D> },
+        { 2, { 0xB9, 0x95 }, &fuse2<&LogicEngine::opcode_B9, &LogicEngine::opcode_95> },
+        { 2, { 0xB9, 0x9D }, &fuse2<&LogicEngine::opcode_B9, &LogicEngine::opcode_9D> },
+        { 2, { 0xB9, 0x99 }, &fuse2<&LogicEngine::opcode_B9, &LogicEngine::opcode_99> },
+
+        { 0, { 0, 0, 0 }, nullptr }
+    };
+
+    return table;
+}
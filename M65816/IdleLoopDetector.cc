@@ -0,0 +1,43 @@
+/**
+ * M65816: Portable 65816 Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#include "IdleLoopDetector.h"
+
+namespace M65816 {
+
+bool IdleLoopDetector::backwardBranch(const uint8_t pbr, const uint16_t target, const uint16_t pc, const LoopRegisters& regs)
+{
+    const uint32_t tag = (pbr << 16) | target;
+
+    // Did the iteration just completed have no side effects?
+    const bool quiet = !system->cpu_writes && !system->volatile_io_reads && system->poll_reads;
+    const uint32_t polls = system->poll_signature;
+
+    system->cpu_writes = system->volatile_io_reads = system->poll_reads = 0;
+    system->poll_signature = 0;
+
+    if ((uint16_t) (pc - target) > kMaxLoopLength) {
+        loop_tag = kNoLoop;
+
+        return false;
+    }
+
+    if ((tag != loop_tag) || !quiet || (regs != registers) || (polls != poll_signature)) {
+        loop_tag       = tag;
+        registers      = regs;
+        poll_signature = polls;
+        iterations     = 0;
+
+        return false;
+    }
+
+    return ++iterations >= kMinIterations;
+}
+
+} // namespace M65816
@@ -0,0 +1,91 @@
+/**
+ * M65816: Portable 65816 Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef IDLELOOPDETECTOR_H
+#define IDLELOOPDETECTOR_H
+
+#include <cstdint>
+
+#include "emulator/common.h"
+#include "emulator/System.h"
+
+namespace M65816 {
+
+/**
+ * The register state of the processor at the end of a loop iteration.
+ */
+struct LoopRegisters {
+    std::uint16_t A, X, Y, S, D;
+    std::uint8_t  DBR, P;
+    bool E;
+
+    bool operator== (const LoopRegisters& o) const
+    {
+        return (A == o.A) && (X == o.X) && (Y == o.Y) && (S == o.S) && (D == o.D)
+            && (DBR == o.DBR) && (P == o.P) && (E == o.E);
+    }
+
+    bool operator!= (const LoopRegisters& o) const { return !operator==(o); }
+};
+
+/**
+ * The IdleLoopDetector recognises short loops that do nothing but poll
+ * status registers, such as waiting for VBL or for a key to be pressed.
+ *
+ * It is fed every taken backward branch. A loop is considered idle once
+ * consecutive iterations write nothing, read no I/O locations other than
+ * the pollable ones registered by devices, read the same values from those
+ * locations, and leave the registers in the same state. Such a loop will
+ * keep doing exactly the same thing until one of the polled values changes,
+ * which can only happen between scanlines, so the processor can skip
+ * straight to the end of its current slice.
+ */
+class IdleLoopDetector {
+    public:
+        // Longest loop, in bytes, that will be considered
+        static constexpr unsigned int kMaxLoopLength = 32;
+
+        // Number of identical iterations needed before a loop is skipped
+        static constexpr unsigned int kMinIterations = 2;
+
+        bool enabled = false;
+
+        // Number of times a loop has been fast-forwarded
+        unsigned long skips = 0;
+
+        // Total number of cycles skipped
+        cycles_t cycles_skipped = 0;
+
+        void attach(System *theSystem) { system = theSystem; }
+
+        // Forget the loop currently being tracked
+        void reset() { loop_tag = kNoLoop; }
+
+        // Called on a taken backward branch from pc to target. Returns true
+        // if the loop has been identified as an idle loop.
+        bool backwardBranch(const std::uint8_t, const std::uint16_t, const std::uint16_t, const LoopRegisters&);
+
+    private:
+        static constexpr std::uint32_t kNoLoop = 0xFFFFFFFF;
+
+        System *system = nullptr;
+
+        // (PBR << 16) | target of the loop being tracked
+        std::uint32_t loop_tag = kNoLoop;
+
+        // State at the end of the previous iteration
+        LoopRegisters registers;
+        std::uint32_t poll_signature;
+
+        unsigned int iterations;
+};
+
+} // namespace M65816
+
+#endif // IDLELOOPDETECTOR_H
@@ -13,9 +13,35 @@ class LogicEngineBase {
         ~LogicEngineBase() = default;
 
         virtual void executeOpcode(const unsigned int) = 0;
+        virtual unsigned int runThreaded(const unsigned int) = 0;
+
+        virtual unsigned int run(const unsigned int) = 0;
+        virtual void interrupt(const unsigned int) = 0;
+
+        virtual void loadRegisters() = 0;
+        virtual void storeRegisters() = 0;
+
+        /**
+         * The engine's superinstructions; see FusedOpcodes.hxx.
+         */
+        const fused_opcode_t *fused = nullptr;
 };
 
-template <typename MemSizeType, typename IndexSizeType, typename StackSizeType, const uint16_t StackOffset>
+/**
+ * DirectPageAligned is true for the engines used while the low byte of D
+ * is zero, which lets the direct page alignment checks be resolved at
+ * compile time.
+ *
+ * BankZero is true for the 65C02 engines, used in emulation mode while
+ * PBR and DBR are both zero. These access bank 0 through a flat table of
+ * page windows, and go straight to the I/O page for the $C0xx soft
+ * switches; accesses outside bank 0 (long addressing) still take the
+ * general path.
+ *
+ * Processor::modeSwitch() keeps the current engine in step with D, PBR,
+ * and DBR.
+ */
+template <typename MemSizeType, typename IndexSizeType, typename StackSizeType, const uint16_t StackOffset, const bool DirectPageAligned, const bool BankZero>
 class LogicEngine : public LogicEngineBase {
     private:
         Processor *cpu;
@@ -30,9 +56,9 @@ class LogicEngine : public LogicEngineBase {
         const unsigned int m_max = sizeof(MemSizeType) == 2? 0xFFFF : 0xFF;
 
         /**
-         * Number of nibbles in MemSizeType. Used by the BCD routines
+         * Index of this engine's CPU mode in the Coverage bitmaps
          */
-        const unsigned int m_nibbles = sizeof(MemSizeType) * 2;
+        static constexpr unsigned int kCoverageMode = StackOffset? 4 : ((sizeof(MemSizeType) == 1) << 1) | (sizeof(IndexSizeType) == 1);
 
         /**
         * Should be 0 for native mode or 0x0100 for emulation mode.
@@ -42,27 +68,47 @@ class LogicEngine : public LogicEngineBase {
         const uint16_t stack_offset = StackOffset;
 
         /**
-         * References to the CPU registers in the parent object, for faster
-         * access. In addition the A, X, Y, and S registers are adjusted for
-         * the specific CPU mode we are trying to emulate.
+         * The engine's working copy of the CPU registers. These are loaded
+         * from the parent object at the start of each run and stored back
+         * at the end (see RunLoop.hxx), so that the opcode handlers access
+         * plain members instead of going through references into the
+         * Processor. The A, X, Y, and S registers are sized for the
+         * specific CPU mode we are trying to emulate.
          */
 
-        StatusRegister& SR;
-        uint16_t&       D;
-        StackSizeType&  S;
-        uint16_t&       PC;
-        uint8_t&        PBR;
-        uint8_t&        DBR;
+        StatusRegister SR;
+        uint16_t       D;
+        StackSizeType  S;
+        uint16_t       PC;
+        uint8_t        PBR;
+        uint8_t        DBR;
+
+        MemSizeType   A;
+        IndexSizeType X;
+        IndexSizeType Y;
 
-        MemSizeType&   A;
-        IndexSizeType& X;
-        IndexSizeType& Y;
+        // The hidden high byte of the accumulator when it is 8 bits wide
+        uint8_t B;
 
         /**
-         * The address and bank of the operand address
+         * Cached views of the pages most recently used for instruction
+         * fetches, direct page accesses, and stack accesses.
          */
-        uint16_t operand_addr;
-        uint8_t  operand_bank;
+        PageWindow code_window;
+        PageWindow direct_window;
+        PageWindow stack_window;
+
+        // One window per page of bank 0; only used by the 65C02 engines
+        PageWindow bank_zero[256];
+
+        /**
+         * The effective address of the operand, as a 24-bit linear
+         * address (bank << 16 | address).
+         */
+        uint32_t operand_ea;
+
+        uint16_t operandAddress() const { return operand_ea; }
+        uint8_t  operandBank() const    { return operand_ea >> 16; }
 
         /**
          * The operand union allows working with an operand
@@ -80,10 +126,16 @@ class LogicEngine : public LogicEngineBase {
 #include "Operations.hxx"
 
     public:
-        LogicEngine(Processor *parent) : cpu(parent), system(parent->system), SR(parent->SR), D(parent->D), S(parent->S), PC(parent->PC), PBR(parent->PBR), DBR(parent->DBR), A(parent->A), X(parent->X), Y(parent->Y) { }
+        LogicEngine(Processor *parent) : cpu(parent), system(parent->system)
+        {
+            fused = fusedTable();
+        }
         ~LogicEngine() = default;
 
 
 #include "ExecuteOpcode.hxx"
+#include "ThreadedDispatch.hxx"
+#include "RunLoop.hxx"
+#include "FusedOpcodes.hxx"
 
 };
@@ -1,22 +1,140 @@
 inline void stackPush(const uint8_t& v)
 {
-    system->cpuWrite(0, S-- + StackOffset, v, STACK);
+    writeWindow(stack_window, S-- + StackOffset, v, STACK);
 }
 
 inline void stackPush(const uint16_t& v)
 {
-    system->cpuWrite(0, S-- + StackOffset, v >> 8, STACK);
-    system->cpuWrite(0, S-- + StackOffset, v, STACK);
+    writeWindow(stack_window, S-- + StackOffset, v >> 8, STACK);
+    writeWindow(stack_window, S-- + StackOffset, v, STACK);
 }
 
 inline void stackPull(uint8_t& v)
 {
-    v = system->cpuRead(0, ++S + StackOffset, STACK);
+    v = readWindow(stack_window, ++S + StackOffset, STACK);
 }
 
 inline void stackPull(uint16_t& v)
 {
-    v = system->cpuRead(0, ++S + StackOffset, STACK) | (system->cpuRead(0, ++S + StackOffset, STACK) << 8);
+    uint8_t lo = readWindow(stack_window, ++S + StackOffset, STACK);
+    uint8_t hi = readWindow(stack_window, ++S + StackOffset, STACK);
+
+    v = lo | (hi << 8);
+}
+
+// The full 16-bit C accumulator, regardless of the M bit
+inline uint16_t accumulatorWord()
+{
+    return sizeof(MemSizeType) == 2? A : (B << 8) | A;
+}
+
+inline void setAccumulatorWord(const uint16_t v)
+{
+    if (sizeof(MemSizeType) == 2) {
+        A = v;
+    }
+    else {
+        A = v & 0xFF;
+        B = v >> 8;
+    }
+}
+
+// The full 16-bit stack pointer
+inline uint16_t stackWord()
+{
+    return S + StackOffset;
+}
+
+// Let the profiler see a call from the instruction at from, once the
+// return address has been pushed and the new PC loaded
+inline void profileCall(const uint32_t from)
+{
+    if (cpu->profiler.enabled) {
+        cpu->profiler.call(from, linearAddress(PBR, PC), stackWord());
+    }
+}
+
+// Let the profiler see a return from the instruction at from, once the
+// return address has been pulled
+inline void profileReturn(const uint32_t from)
+{
+    if (cpu->profiler.enabled) {
+        cpu->profiler.ret(from, linearAddress(PBR, PC), stackWord());
+    }
+}
+
+// Offer a JSL to the tool dispatcher to the handler for its tool set, if
+// there is one. Returns true if the handler did the whole call, in which
+// case execution just carries on after the JSL.
+bool trapToolCall()
+{
+    // Tool calls are only made in native mode with 16-bit registers
+    if (StackOffset || (sizeof(IndexSizeType) == 1) || !system->hasToolHandler(X & 0xFF)) {
+        return false;
+    }
+
+    // Tool handlers work on the Processor's copy of the registers
+    storeRegisters();
+    const bool handled = system->handleToolCall(X, linearAddress(PBR, PC));
+    loadRegisters();
+
+    if (handled) cpu->requestModeSwitch();
+
+    return handled;
+}
+
+// Let a tool handler see the return from a tool call it is watching
+void trapToolReturn()
+{
+    storeRegisters();
+    system->handleToolReturn(stackWord());
+    loadRegisters();
+}
+
+// Give the MLI handler a chance to do a ProDOS 8 MLI call, if there is
+// one. Returns true if it did, in which case PC is already past the
+// call's parameters.
+bool trapMLICall()
+{
+    if (PBR || !system->hasMLIHandler()) return false;
+
+    storeRegisters();
+    const bool handled = system->handleMLICall(PC);
+    loadRegisters();
+
+    if (handled) cpu->requestModeSwitch();
+
+    return handled;
+}
+
+// Give the GS/OS handler a chance to do a GS/OS call, if there is one.
+// Returns true if it did, in which case execution just carries on after
+// the call.
+bool trapGSOSCall(const bool stack_call)
+{
+    if (StackOffset || !system->hasGSOSHandler()) return false;
+
+    storeRegisters();
+    const bool handled = system->handleGSOSCall(stack_call, linearAddress(PBR, PC));
+    loadRegisters();
+
+    if (handled) cpu->requestModeSwitch();
+
+    return handled;
+}
+
+// Load the contents of a vector into the PC and PBR
+inline void loadVector(const uint16_t va)
+{
+    const uint32_t from = linearAddress(PBR, PC);
+
+    PC  = system->cpuRead(0, va, VECTOR) | (system->cpuRead(0, va + 1, VECTOR) << 8);
+    PBR = 0;
+
+    checkBankMode();
+
+    // Interrupts show up in the profile as calls from the interrupted code
+    profileCall(from);
 }
 
 inline void jumpTo(const uint16_t& addr)
@@ -24,70 +142,434 @@ inline void jumpTo(const uint16_t& addr)
     PC = addr;
 }
 
+// Take a relative branch, letting the idle loop detector see it if
+// it's a backward one.
+inline void branchTo(const uint16_t& addr)
+{
+    if ((addr < PC) && cpu->idle_loops.enabled) {
+        cpu->backwardBranch(PBR, addr, PC, { accumulatorWord(), X, Y, stackWord(), D, DBR, SR, SR.E });
+    }
+
+    PC = addr;
+}
+
 inline void jumpTo(const uint8_t& bank, const uint16_t& addr)
 {
     PBR = bank;
     PC  = addr;
+
+    checkBankMode();
 }
 
 inline void checkDataPageCross(const uint16_t& check)
 {
-    if ((StackOffset > 0) && ((check & 0xFF00) != (operand_addr & 0xFF00))) {
+    if ((StackOffset > 0) && ((check & 0xFF00) != (operand_ea & 0xFF00))) {
         cpu->num_cycles++;
     }
 }
 
 inline void checkProgramPageCross()
 {
-    if ((StackOffset > 0) && ((PC & 0xFF00) != (operand_addr & 0xFF00))) {
+    if ((StackOffset > 0) && ((PC & 0xFF00) != (operand_ea & 0xFF00))) {
         cpu->num_cycles++;
     }
 }
 
 inline void checkDirectPageAlignment()
 {
-    if (D & 0xFF) {
+    if (!DirectPageAligned) {
         cpu->num_cycles++;
     }
 }
 
+// Switch engines if E, M or X no longer match the ones this engine was
+// built for.
+inline void checkRegisterMode()
+{
+    if ((SR.E != (StackOffset != 0)) || (SR.M != (sizeof(MemSizeType) == 1)) || (SR.X != (sizeof(IndexSizeType) == 1))) {
+        cpu->requestModeSwitch();
+    }
+}
+
+// End the slice if I has just been cleared with an IRQ waiting, so that
+// it's taken before the next instruction.
+inline void checkPendingIRQ()
+{
+    if (!SR.I && cpu->irq_pending) cpu->endSlice();
+}
+
+// Switch to the other set of engines if D has moved on to or off of a
+// page boundary.
+inline void checkDirectPageMode()
+{
+    if (DirectPageAligned != !(D & 0xFF)) {
+        cpu->requestModeSwitch();
+    }
+}
+
+// In emulation mode, switch between the 65C02 and general engines if
+// PBR or DBR has changed between zero and nonzero.
+inline void checkBankMode()
+{
+    if (StackOffset && (BankZero != (!PBR && !DBR))) {
+        cpu->requestModeSwitch();
+    }
+}
+
+// True while the debugger is tracing, when it has to see every
+// instruction fetch and so nothing may bypass cpuRead()/cpuWrite()
+inline bool debuggerTracing() const
+{
+#ifdef ENABLE_DEBUGGER
+    return system->debugger && system->debugger->isTracing();
+#else
+    return false;
+#endif
+}
+
+/**
+ * Point a page window at the page containing a linear address. Returns false
+ * if the page can't be read directly (I/O or unmapped memory, or while the
+ * debugger is tracing and needs to see every fetch), in which case
+ * accesses have to go through cpuRead()/cpuWrite().
+ */
+bool fillWindow(PageWindow& window, const uint32_t ea)
+{
+    window.invalidate();
+
+    if (debuggerTracing()) return false;
+
+    window.read = system->getReadPointer(system->getReadPage(ea));
+
+    if (!window.read) return false;
+
+    window.write_page = system->getWritePage(ea);
+    window.write      = system->getWritePointer(window.write_page);
+    window.key        = ea >> 8;
+    window.generation = system->map_generation;
+
+    return true;
+}
+
+inline bool windowCovers(const PageWindow& window, const uint32_t ea)
+{
+    return (window.key == (ea >> 8)) && (window.generation == system->map_generation);
+}
+
+/**
+ * Read a byte through a page window, moving the window to the byte's
+ * page first if necessary.
+ */
+inline uint8_t readWindow(PageWindow& window, const uint32_t ea, const mem_access_t type)
+{
+    if (BankZero && (ea < 0x10000)) return readBankZero(ea, type);
+
+    if (!windowCovers(window, ea) && !fillWindow(window, ea)) {
+        return system->cpuRead(ea >> 16, ea, type);
+    }
+
+    return window.read[ea & 0xFF];
+}
+
+/**
+ * Write a byte through a page window, moving the window to the byte's
+ * page first if necessary.
+ */
+inline void writeWindow(PageWindow& window, const uint32_t ea, const uint8_t v, const mem_access_t type)
+{
+    if (BankZero && (ea < 0x10000)) return writeBankZero(ea, v, type);
+
+    if ((windowCovers(window, ea) || fillWindow(window, ea)) && window.write) {
+        window.write[ea & 0xFF] = v;
+
+        system->touchPage(window.write_page);
+    }
+    else {
+        system->cpuWrite(ea >> 16, ea, v, type);
+    }
+}
+
+/**
+ * Read or write a byte of bank 0 in one of the 65C02 engines, through
+ * the bank_zero window for its page. Accesses to the I/O page go straight
+ * to the device unless the debugger is tracing.
+ */
+inline uint8_t readBankZero(const uint16_t address, const mem_access_t type)
+{
+    PageWindow& window = bank_zero[address >> 8];
+
+    if (windowCovers(window, address) || fillWindow(window, address)) {
+        return window.read[address & 0xFF];
+    }
+
+    if (debuggerTracing()) return system->cpuRead(0, address, type);
+
+    if (system->isIOPage(system->getReadPage(address))) {
+        return system->cpuIoRead(address & 0xFF);
+    }
+    else {
+        return system->cpuRead(0, address, type);
+    }
+}
+
+inline void writeBankZero(const uint16_t address, const uint8_t v, const mem_access_t type)
+{
+    PageWindow& window = bank_zero[address >> 8];
+
+    if ((windowCovers(window, address) || fillWindow(window, address)) && window.write) {
+        window.write[address & 0xFF] = v;
+
+        system->touchPage(window.write_page);
+
+        return;
+    }
+
+    if (debuggerTracing()) return system->cpuWrite(0, address, v, type);
+
+    if (system->isIOPage(system->getWritePage(address))) {
+        system->cpuIoWrite(address & 0xFF, v);
+    }
+    else {
+        system->cpuWrite(0, address, v, type);
+    }
+}
+
+/**
+ * Read a byte of code from PBR:address through the instruction fetch
+ * window.
+ */
+inline uint8_t readCodeByte(const uint16_t address)
+{
+    return readWindow(code_window, linearAddress(PBR, address), INSTR);
+}
+
+/**
+ * Read a byte of bank 0 through the direct page window. Used for the
+ * pointers of the direct page indirect addressing modes.
+ */
+inline uint8_t readDirectByte(const uint16_t address)
+{
+    return readWindow(direct_window, address, OPADDR);
+}
+
+/**
+ * Move the direct page or stack window to cover a bank 0 operand address.
+ * Operand fetches and stores (see fetchOperand()) use either window if it
+ * covers the operand, but never move them.
+ */
+inline void mapDirectWindow(const uint16_t address)
+{
+    if (BankZero) return;
+
+    if (!windowCovers(direct_window, address)) fillWindow(direct_window, address);
+}
+
+inline void mapStackWindow(const uint16_t address)
+{
+    if (BankZero) return;
+
+    if (!windowCovers(stack_window, address)) fillWindow(stack_window, address);
+}
+
+/**
+ * Fetch the next byte of the instruction stream. If the processor is
+ * executing a predecoded block the byte comes from the block cache,
+ * otherwise it is read from memory.
+ */
+inline uint8_t fetchInstructionByte()
+{
+    if (cpu->fetch_ptr) {
+        ++PC;
+
+        return *cpu->fetch_ptr++;
+    }
+    else {
+        return readCodeByte(PC++);
+    }
+}
+
+inline uint16_t fetchInstructionWord()
+{
+    uint8_t lo = fetchInstructionByte();
+    uint8_t hi = fetchInstructionByte();
+
+    return lo | (hi << 8);
+}
+
+inline uint32_t fetchInstructionLong()
+{
+    uint16_t lo = fetchInstructionWord();
+    uint8_t  hi = fetchInstructionByte();
+
+    return lo | (hi << 16);
+}
+
 inline void fetchImmediateOperand(uint8_t &op)
 {
-    op = system->cpuRead(PBR, PC++, INSTR);
+    op = fetchInstructionByte();
 }
 
 inline void fetchImmediateOperand(uint16_t &op)
 {
-    op = system->cpuRead(PBR, PC++, INSTR) | (system->cpuRead(PBR, PC++, INSTR) << 8);
+    op = fetchInstructionWord();
+}
+
+/**
+ * Read or write a single byte of operand data, going through the direct
+ * page or stack window if one of them covers the address.
+ */
+inline uint8_t readOperandByte(const uint32_t ea)
+{
+    if (BankZero && (ea < 0x10000)) {
+        return readBankZero(ea, OPERAND);
+    }
+    else if (windowCovers(direct_window, ea)) {
+        return direct_window.read[ea & 0xFF];
+    }
+    else if (windowCovers(stack_window, ea)) {
+        return stack_window.read[ea & 0xFF];
+    }
+    else {
+        return system->cpuRead(ea >> 16, ea, OPERAND);
+    }
+}
+
+inline void writeOperandByte(const uint32_t ea, const uint8_t v, const mem_access_t type)
+{
+    if (BankZero && (ea < 0x10000)) {
+        writeBankZero(ea, v, type);
+    }
+    else if (windowCovers(direct_window, ea) && direct_window.write) {
+        direct_window.write[ea & 0xFF] = v;
+
+        system->touchPage(direct_window.write_page);
+    }
+    else if (windowCovers(stack_window, ea) && stack_window.write) {
+        stack_window.write[ea & 0xFF] = v;
+
+        system->touchPage(stack_window.write_page);
+    }
+    else {
+        system->cpuWrite(ea >> 16, ea, v, type);
+    }
+}
+
+/**
+ * Returns a host pointer to a linear address if it is in ordinary memory
+ * that can be read directly, or nullptr if the read has to go through
+ * cpuRead().
+ */
+inline const uint8_t *operandReadPointer(const uint32_t ea)
+{
+    if (windowCovers(direct_window, ea)) {
+        return direct_window.read + (ea & 0xFF);
+    }
+    else if (windowCovers(stack_window, ea)) {
+        return stack_window.read + (ea & 0xFF);
+    }
+
+    if (debuggerTracing()) return nullptr;
+
+    const uint8_t *mem = system->getReadPointer(system->getReadPage(ea));
+
+    return mem? mem + (ea & 0xFF) : nullptr;
+}
+
+/**
+ * Returns a host pointer to a linear address if it is in ordinary memory
+ * that can be written directly, or nullptr if the write has to go through
+ * cpuWrite(). On success page_no is set to the physical page written to.
+ */
+inline uint8_t *operandWritePointer(const uint32_t ea, unsigned int& page_no)
+{
+    if (windowCovers(direct_window, ea) && direct_window.write) {
+        page_no = direct_window.write_page;
+
+        return direct_window.write + (ea & 0xFF);
+    }
+    else if (windowCovers(stack_window, ea) && stack_window.write) {
+        page_no = stack_window.write_page;
+
+        return stack_window.write + (ea & 0xFF);
+    }
+
+    if (debuggerTracing()) return nullptr;
+
+    page_no = system->getWritePage(ea);
+
+    uint8_t *mem = system->getWritePointer(page_no);
+
+    return mem? mem + (ea & 0xFF) : nullptr;
+}
+
+// The address of the second byte of a 16-bit operand, which stays in the
+// same bank as the first.
+static constexpr uint32_t nextOperandByte(const uint32_t ea)
+{
+    return (ea & 0xFF0000) | ((ea + 1) & 0xFFFF);
+}
+
+/**
+ * Read or write a 16-bit operand. When both bytes are on the same page of
+ * ordinary memory the page is only looked up once and the word is accessed
+ * in one go; at the end of a page, or for I/O, shadowed, or read-only
+ * memory, it is done a byte at a time.
+ */
+inline uint16_t readOperandWord(const uint32_t ea)
+{
+    if ((ea & 0xFF) != 0xFF) {
+        if (const uint8_t *p = operandReadPointer(ea)) {
+            return p[0] | (p[1] << 8);
+        }
+    }
+
+    return readOperandByte(ea) | (readOperandByte(nextOperandByte(ea)) << 8);
+}
+
+inline void writeOperandWord(const uint32_t ea, const uint16_t v, const mem_access_t type)
+{
+    unsigned int page_no;
+
+    if ((ea & 0xFF) != 0xFF) {
+        if (uint8_t *p = operandWritePointer(ea, page_no)) {
+            p[0] = v;
+            p[1] = v >> 8;
+
+            system->touchPage(page_no);
+
+            return;
+        }
+    }
+
+    writeOperandByte(ea, v, type);
+    writeOperandByte(nextOperandByte(ea), v >> 8, type);
 }
 
 inline void fetchOperand(uint8_t &op)
 {
-    op = system->cpuRead(operand_bank, operand_addr, OPERAND);
+    op = readOperandByte(operand_ea);
 }
 
 inline void fetchOperand(uint16_t &op)
 {
-    op = system->cpuRead(operand_bank, operand_addr, OPERAND)
-         | (system->cpuRead(operand_bank, operand_addr + 1, OPERAND) << 8);
+    op = readOperandWord(operand_ea);
 }
 
 inline void storeOperand(uint8_t &op)
 {
-    system->cpuWrite(operand_bank, operand_addr, op, OPERAND);
+    writeOperandByte(operand_ea, op, OPERAND);
 }
 
 inline void storeOperand(uint16_t &op)
 {
-    system->cpuWrite(operand_bank, operand_addr, op, OPERAND);
-    system->cpuWrite(operand_bank, operand_addr + 1, op >> 8, OPERAND);
+    writeOperandWord(operand_ea, op, OPERAND);
 }
 
-inline void checkIfNegative(const uint8_t &v) { SR.N = v & 0x80; }
-inline void checkIfNegative(const uint16_t &v) { SR.N = v & 0x8000; }
+inline void checkIfNegative(const uint8_t &v) { SR.setNResult(v); }
+inline void checkIfNegative(const uint16_t &v) { SR.setNResult(v); }
 
-inline void checkIfZero(const uint8_t &v) { SR.Z = (v == 0); }
-inline void checkIfZero(const uint16_t &v) { SR.Z = (v == 0); }
+inline void checkIfZero(const uint8_t &v) { SR.setZResult(v); }
+inline void checkIfZero(const uint16_t &v) { SR.setZResult(v); }
 
 inline void op_AND()
 {
@@ -99,8 +581,8 @@ inline void op_AND()
 
 inline void op_BIT()
 {
-    SR.Z = !(operand.m & A);
-    SR.N = operand.m & n_bit;
+    SR.setZResult(operand.m & A);
+    checkIfNegative(operand.m);
     SR.V = operand.m & v_bit;
 }
 
@@ -122,14 +604,14 @@ inline void op_ORA()
 
 inline void op_TRB()
 {
-    SR.Z = !(operand.m & A);
+    SR.setZResult(operand.m & A);
 
     operand.m &= ~A;
 }
 
 inline void op_TSB()
 {
-    SR.Z = !(operand.m & A);
+    SR.setZResult(operand.m & A);
 
     operand.m |= A;
 }
@@ -232,46 +714,109 @@ inline void op_CPY()
 
 // Block moves
 
-void op_MVP()
+/**
+ * Maximum number of bytes moved by one execution of MVN/MVP on the fast
+ * path. Interrupts are only taken between executions, so this bounds the
+ * interrupt latency (and the slice overrun) to kMaxMoveChunk * 7 cycles.
+ */
+static constexpr unsigned int kMaxMoveChunk = 32;
+
+/**
+ * Perform as much of an MVN (dir = 1) or MVP (dir = -1) as possible
+ * directly on host memory, stopping at the end of the move, either page
+ * boundary, or kMaxMoveChunk bytes. Returns the number of bytes moved, or
+ * zero if the current byte has to go through cpuRead()/cpuWrite() (I/O,
+ * shadowed and ROM pages, or while the debugger is tracing).
+ */
+unsigned int blockMoveFast(const uint8_t src_bank, const int dir)
 {
-    uint8_t src_bank = system->cpuRead(PBR, PC + 1, INSTR);
+    if (debuggerTracing()) return 0;
+
+    const uint16_t src = X;
+    const uint16_t dst = Y;
+    const unsigned int dst_page = system->getWritePage(DBR, dst);
 
-    DBR = system->cpuRead(PBR, PC, INSTR);
+    const uint8_t *rp = system->getReadPointer(system->getReadPage(src_bank, src));
+    uint8_t *wp = system->getWritePointer(dst_page);
 
-    if (cpu->A.W != 0xFFFF) {
-        system->cpuWrite(DBR, cpu->Y.W, system->cpuRead(src_bank, cpu->X.W, DATA), DATA);
+    if (!rp || !wp) return 0;
 
-        --cpu->A.W;
-        --cpu->X.W;
-        --cpu->Y.W;
+    rp += src & 0xFF;
+    wp += dst & 0xFF;
 
-        --PC;
+    unsigned int len = std::min<unsigned int>(accumulatorWord() + 1, kMaxMoveChunk);
+
+    if (dir > 0) {
+        len = std::min({ len, 0x100u - (src & 0xFF), 0x100u - (dst & 0xFF) });
+
+        // A forward byte-by-byte copy replicates the source when the
+        // destination overlaps it from above; memmove() would not.
+        if ((wp <= rp) || (wp >= rp + len)) {
+            std::memmove(wp, rp, len);
+        }
+        else {
+            for (unsigned int i = 0 ; i < len ; ++i) wp[i] = rp[i];
+        }
     }
     else {
-        PC += 2;
+        len = std::min({ len, (src & 0xFFu) + 1, (dst & 0xFFu) + 1 });
+
+        if ((wp >= rp) || (wp + len <= rp)) {
+            std::memmove(wp - (len - 1), rp - (len - 1), len);
+        }
+        else {
+            for (unsigned int i = 0 ; i < len ; ++i) *(wp - i) = *(rp - i);
+        }
     }
+
+    system->touchPage(dst_page);
+
+    return len;
 }
 
-void op_MVN()
+/**
+ * Common code for MVN and MVP. Each execution moves at least one byte
+ * and then backs PC up to repeat the instruction until A wraps to $FFFF,
+ * so the move can be interrupted between executions just as on a real
+ * 65816. Seven cycles are charged per byte moved.
+ */
+void blockMove(const int dir)
 {
-    uint8_t src_bank = system->cpuRead(PBR, PC + 1, INSTR);
+    DBR = fetchInstructionByte();
 
-    DBR = system->cpuRead(PBR, PC, INSTR);
+    checkBankMode();
 
-    if (cpu->A.W != 0xFFFF) {
-        system->cpuWrite(DBR, cpu->Y.W, system->cpuRead(src_bank, cpu->X.W, DATA), DATA);
+    uint8_t src_bank = fetchInstructionByte();
+    unsigned int len = blockMoveFast(src_bank, dir);
 
-        --cpu->A.W;
-        ++cpu->X.W;
-        ++cpu->Y.W;
+    if (len == 0) {
+        system->cpuWrite(DBR, Y, system->cpuRead(src_bank, X, DATA), DATA);
 
-        --PC;
+        len = 1;
     }
-    else {
-        PC += 2;
+
+    setAccumulatorWord(accumulatorWord() - len);
+
+    X += dir * (int) len;
+    Y += dir * (int) len;
+
+    cpu->num_cycles += 7 * len;
+
+    if (accumulatorWord() != 0xFFFF) {
+        PC -= 3;
     }
 }
 
+void op_MVP()
+{
+    blockMove(-1);
+}
+
+void op_MVN()
+{
+    blockMove(1);
+}
+
 // Loads and stores
 
 inline void op_LDA()
@@ -300,37 +845,41 @@ inline void op_LDY()
 
 inline void op_STA()
 {
-    system->cpuWrite(operand_bank, operand_addr, A, DATA);
-
     if (sizeof(MemSizeType) == 2) {
-        system->cpuWrite(operand_bank, operand_addr + 1, A >> 8, DATA);
+        writeOperandWord(operand_ea, A, DATA);
+    }
+    else {
+        writeOperandByte(operand_ea, A, DATA);
     }
 }
 
 inline void op_STX()
 {
-    system->cpuWrite(operand_bank, operand_addr, X, DATA);
-
     if (sizeof(IndexSizeType) == 2) {
-        system->cpuWrite(operand_bank, operand_addr + 1, X >> 8, DATA);
+        writeOperandWord(operand_ea, X, DATA);
+    }
+    else {
+        writeOperandByte(operand_ea, X, DATA);
     }
 }
 
 inline void op_STY()
 {
-    system->cpuWrite(operand_bank, operand_addr, Y, DATA);
-
     if (sizeof(IndexSizeType) == 2) {
-        system->cpuWrite(operand_bank, operand_addr + 1, Y >> 8, DATA);
+        writeOperandWord(operand_ea, Y, DATA);
+    }
+    else {
+        writeOperandByte(operand_ea, Y, DATA);
     }
 }
 
 inline void op_STZ()
 {
-    system->cpuWrite(operand_bank, operand_addr, 0, DATA);
-
     if (sizeof(MemSizeType) == 2) {
-        system->cpuWrite(operand_bank, operand_addr + 1, 0, DATA);
+        writeOperandWord(operand_ea, 0, DATA);
+    }
+    else {
+        writeOperandByte(operand_ea, 0, DATA);
     }
 }
 
@@ -338,59 +887,59 @@ inline void op_STZ()
 
 inline void op_TCD()
 {
-    D = cpu->A.W;
+    D = accumulatorWord();
 
     checkIfNegative(D);
     checkIfZero(D);
+
+    checkDirectPageMode();
 }
 
 inline void op_TDC()
 {
-    cpu->A.W = D;
+    setAccumulatorWord(D);
 
-    checkIfNegative(cpu->A.W);
-    checkIfZero(cpu->A.W);
+    checkIfNegative(D);
+    checkIfZero(D);
 }
 
 // Addition and subtraction
 
-inline void op_ADC()
+// Perform a decimal mode ADC or SBC on A and the operand using one of the
+// lookup tables in DecimalTables.h, setting C and V. A 16-bit operation
+// chains two byte lookups through the carry.
+inline unsigned int decimalArithmetic(const uint16_t *table)
 {
-    unsigned int sum = 0;
-
-    if (SR.D) {
-        int AL, tempA = A, tempB = operand.m, tempC = SR.C;
-
-        sum = 0;
+    const unsigned int lo = table[(SR.C << 16) | ((A & 0xFF) << 8) | (operand.m & 0xFF)];
+    unsigned int flags  = lo;
+    unsigned int result = lo & 0xFF;
 
-        for (unsigned int i = 0 ; i < m_nibbles ; ++i) {
-            AL = (tempA & 0x0F) + (tempB & 0x0F) + tempC;
+    if (sizeof(MemSizeType) == 2) {
+        flags = table[((lo & kDecimalCarry) << 8) | (A & 0xFF00) | (operand.m >> 8)];
 
-            if (AL >= 0x0A) {
-                AL = (AL + 0x06) & 0x0F;
+        result |= (flags & 0xFF) << 8;
+    }
 
-                tempC = 1;
-            }
-            else {
-                tempC = 0;
-            }
+    SR.C = flags & kDecimalCarry;
+    SR.V = flags & kDecimalOverflow;
 
-            sum |= (AL << (4 * i));
+    return result;
+}
 
-            tempA >>= 4;
-            tempB >>= 4;
-        }
+inline void op_ADC()
+{
+    unsigned int sum;
 
-        SR.C = tempC;
+    if (SR.D) {
+        sum = decimalArithmetic(decimal_adc_table);
     }
     else {
         sum = A + operand.m + SR.C;
 
         SR.C = (sum > m_max);
+        SR.V = (A ^ sum) & (operand.m ^ sum) & n_bit;
     }
 
-    SR.V = (A ^ sum) & (operand.m ^ sum) & n_bit;
-
     A = sum;
 
     checkIfNegative(A);
@@ -399,40 +948,19 @@ inline void op_ADC()
 
 inline void op_SBC()
 {
-    int diff = 0;
-    bool borrow = !SR.C;
+    int diff;
 
     if (SR.D) {
-        int AL, tempA = A, tempB = operand.m, tempC = SR.C;
-
-        for (unsigned int i = 0 ; i < m_nibbles ; ++i) {
-            AL = (tempA & 0x0F) - (tempB & 0x0F) + tempC - 1;
-
-            if (AL < 0) {
-                AL = (AL - 0x06) & 0x0F;
-
-                tempC = 0;
-            }
-            else {
-                tempC = 1;
-            }
-
-            diff |= (AL << (4 * i));
-
-            tempA >>= 4;
-            tempB >>= 4;
-        }
-
-        SR.C = tempC;
+        diff = decimalArithmetic(decimal_sbc_table);
     }
     else {
-        diff = A - operand.m - borrow;
+        diff = A - operand.m - !SR.C;
 
-        SR.C = !(diff > m_max);
+        // A borrow leaves diff negative, which as unsigned is above m_max
+        SR.C = !((unsigned int) diff > m_max);
+        SR.V = (A ^ diff) & (~operand.m ^ diff) & n_bit;
     }
 
-    SR.V = (A ^ diff) & (~operand.m ^ diff) & n_bit;
-
     A = diff;
 
     checkIfNegative(A);
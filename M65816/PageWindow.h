@@ -0,0 +1,48 @@
+/**
+ * M65816: Portable 65816 Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef PAGEWINDOW_H
+#define PAGEWINDOW_H
+
+#include <cstdint>
+
+namespace M65816 {
+
+/**
+ * A PageWindow caches host pointers to the contents of one 256-byte page
+ * of the CPU's address space, so that repeated accesses to that page can
+ * skip the memory map lookups done by System::cpuRead()/cpuWrite().
+ *
+ * A window is only valid for the map generation it was filled under; see
+ * the window helpers in Operations.hxx.
+ */
+struct PageWindow {
+    static constexpr unsigned int kNoPage = ~0U;
+
+    // (bank << 8) | page of the CPU address the window covers
+    unsigned int key = kNoPage;
+
+    // System::map_generation at the time the window was filled
+    unsigned int generation = 0;
+
+    // Contents of the page for reading
+    const std::uint8_t *read = nullptr;
+
+    // Contents of the page for writing, or nullptr if writes have to
+    // go through System::cpuWrite(). write_page is the physical page
+    // number, needed to bump its version on a write.
+    std::uint8_t *write = nullptr;
+    unsigned int write_page = 0;
+
+    void invalidate() { key = kNoPage; }
+};
+
+} // namespace M65816
+
+#endif // PAGEWINDOW_H
@@ -7,11 +7,13 @@
  * Commercial use is prohibited without my written permission
  */
 
+#include <algorithm>
 #include <iostream>
 #include <boost/format.hpp>
 
 #include "Processor.h"
 #include "cycle_counts.h"
+#include "instruction_lengths.h"
 
 namespace M65816 {
 
@@ -20,6 +22,8 @@ Processor::Processor()
     nmi_pending   = false;
     abort_pending = false;
     irq_pending   = false;
+
+    initDecimalTables();
 }
 
 Processor::~Processor()
@@ -30,92 +34,187 @@ void Processor::attach(System *theSystem)
 {
     system = theSystem;
 
-    engine_e0m0x0 = new LogicEngine<uint16_t, uint16_t, uint16_t, 0>(this);
-    engine_e0m0x1 = new LogicEngine<uint16_t, uint8_t, uint16_t, 0>(this);
-    engine_e0m1x0 = new LogicEngine<uint8_t, uint16_t, uint16_t, 0>(this);
-    engine_e0m1x1 = new LogicEngine<uint8_t, uint8_t, uint16_t, 0>(this);
-    engine_e1m1x1 = new LogicEngine<uint8_t, uint8_t, uint8_t, 0x0100>(this);
+    block_cache.attach(system);
+    idle_loops.attach(system);
+
+    engine_e0m0x0 = new LogicEngine<uint16_t, uint16_t, uint16_t, 0, false, false>(this);
+    engine_e0m0x1 = new LogicEngine<uint16_t, uint8_t, uint16_t, 0, false, false>(this);
+    engine_e0m1x0 = new LogicEngine<uint8_t, uint16_t, uint16_t, 0, false, false>(this);
+    engine_e0m1x1 = new LogicEngine<uint8_t, uint8_t, uint16_t, 0, false, false>(this);
+    engine_e1m1x1 = new LogicEngine<uint8_t, uint8_t, uint8_t, 0x0100, false, false>(this);
+
+    engine_e0m0x0_aligned = new LogicEngine<uint16_t, uint16_t, uint16_t, 0, true, false>(this);
+    engine_e0m0x1_aligned = new LogicEngine<uint16_t, uint8_t, uint16_t, 0, true, false>(this);
+    engine_e0m1x0_aligned = new LogicEngine<uint8_t, uint16_t, uint16_t, 0, true, false>(this);
+    engine_e0m1x1_aligned = new LogicEngine<uint8_t, uint8_t, uint16_t, 0, true, false>(this);
+    engine_e1m1x1_aligned = new LogicEngine<uint8_t, uint8_t, uint8_t, 0x0100, true, false>(this);
+
+    engine_bank0         = new LogicEngine<uint8_t, uint8_t, uint8_t, 0x0100, false, true>(this);
+    engine_bank0_aligned = new LogicEngine<uint8_t, uint8_t, uint8_t, 0x0100, true, true>(this);
 }
 
 void Processor::modeSwitch()
 {
+    direct_page_aligned = !(D & 0xFF);
+    bank_zero = SR.E && !PBR && !DBR;
+
     if (SR.E) {
         SR.M  = true;
         SR.X  = true;
         S.B.H = 0x01;
 
-        engine = engine_e1m1x1;
+        if (bank_zero) {
+            engine = direct_page_aligned? static_cast<LogicEngineBase *>(engine_bank0_aligned) : engine_bank0;
+            mode = 4 + kBankZeroModes;
+        }
+        else {
+            engine = direct_page_aligned? static_cast<LogicEngineBase *>(engine_e1m1x1_aligned) : engine_e1m1x1;
+            mode = 4;
+        }
+
         cycle_counts = cycle_counts_e1m1x1;
+        instruction_lengths = instruction_lengths_e1m1x1;
     }
     else {
         if (SR.X) { // x = 1
             if (SR.M) { // m=1, x=1
-                engine = engine_e0m1x1;
+                engine = direct_page_aligned? static_cast<LogicEngineBase *>(engine_e0m1x1_aligned) : engine_e0m1x1;
                 cycle_counts = cycle_counts_e0m1x1;
+                instruction_lengths = instruction_lengths_e0m1x1;
+                mode = 3;
             }
             else {      // m=0, x=1
-                engine = engine_e0m0x1;
+                engine = direct_page_aligned? static_cast<LogicEngineBase *>(engine_e0m0x1_aligned) : engine_e0m0x1;
                 cycle_counts = cycle_counts_e0m0x1;
+                instruction_lengths = instruction_lengths_e0m0x1;
+                mode = 1;
             }
         }
         else {  // x = 0
             if (SR.M) { // m=1, x=0
-                engine = engine_e0m1x0;
+                engine = direct_page_aligned? static_cast<LogicEngineBase *>(engine_e0m1x0_aligned) : engine_e0m1x0;
                 cycle_counts = cycle_counts_e0m1x0;
+                instruction_lengths = instruction_lengths_e0m1x0;
+                mode = 2;
             }
             else { // m=0, x=0
-                engine = engine_e0m0x0;
+                engine = direct_page_aligned? static_cast<LogicEngineBase *>(engine_e0m0x0_aligned) : engine_e0m0x0;
                 cycle_counts = cycle_counts_e0m0x0;
+                instruction_lengths = instruction_lengths_e0m0x0;
+                mode = 0;
             }
         }
     }
 
+    if (direct_page_aligned) mode += kAlignedModes;
+
     if (SR.X) X.B.H = Y.B.H = 0;
+
+    endSlice();
 }
 
 unsigned int Processor::runUntil(const unsigned int max_cycles)
 {
-    unsigned int opcode, cycles_done = 0;
+    unsigned int cycles_done = 0;
 
     while (cycles_done < max_cycles) {
+        // D, PBR, or DBR may have been changed from outside the engine
+        // (eg. by the debugger) since the engine was chosen.
+        if (engineIsStale()) modeSwitch();
+
+        // Only a reset restarts a stopped processor
+        if (stopped) {
+            idle(max_cycles - cycles_done);
+
+            return max_cycles;
+        }
+
         if (abort_pending) {
-            engine->executeOpcode(0x102);
+            engine->interrupt(0x102);
 
             return 0;
         }
         else if (nmi_pending) {
-            engine->executeOpcode(0x101);
+            engine->interrupt(0x101);
 
             return 0;
         }
         else if (irq_pending && !SR.I) {
-            engine->executeOpcode(0x100);
+            engine->interrupt(0x100);
 
             return 0;
         }
         else if (waiting) {
+            // With interrupts disabled an IRQ still ends WAI, but execution
+            // resumes with the next instruction instead of taking it.
+            if (!irq_pending) {
+                idle(max_cycles - cycles_done);
+
+                return max_cycles;
+            }
+
+            waiting = false;
+        }
+
+        // Nothing the current loop polls can change before the end of
+        // this slice, so there's no point executing it any further.
+        if (skip_slice) {
+            skip_slice = false;
+
+            ++idle_loops.skips;
+            idle_loops.cycles_skipped += max_cycles - cycles_done;
+
+            idle(max_cycles - cycles_done);
+
             return max_cycles;
         }
 
-        opcode = system->cpuRead(PBR, PC, INSTR);
-        num_cycles = cycle_counts[opcode];
+        unsigned int budget = max_cycles - cycles_done;
 
-        ++PC;
+        // A sampling profiler takes its samples on a cycle timer, so end
+        // the run when the next one is due
+        if (profiler.isSampling()) budget = std::min(budget, profiler.cyclesToSample());
 
-        engine->executeOpcode(opcode);
+        const unsigned int n = engine->run(budget);
 
-        cycles_done += num_cycles;
-        total_cycles += num_cycles;
+        cycles_done  += n;
+        total_cycles += n;
+
+        if (profiler.isSampling()) profiler.tick((PBR << 16) | PC, n);
+
+        if (mode_switch_pending) {
+            mode_switch_pending = false;
+
+            modeSwitch();
+        }
     }
 
     return cycles_done;
 }
 
+void Processor::syncRegisters()
+{
+    if (in_run) {
+        engine->storeRegisters();
+    }
+}
+
+void Processor::setCore(const cpu_core_t new_core)
+{
+    core = new_core;
+
+    block_cache.flush();
+}
+
 void Processor::reset(void)
 {
     stopped = false;
     waiting = false;
 
+    skip_slice = false;
+    idle_loops.reset();
+    profiler.clearStack();
+
     SR.E = true;
     SR.M = true;
     SR.X = true;
@@ -130,6 +229,7 @@ void Processor::reset(void)
     loadVector(0xFFFC);
 
     total_cycles = 0;
+    stall_cycles = 0;
 }
 
 } // namespace M65816
@@ -10,7 +10,16 @@
 #ifndef PROCESSOR_H
 #define PROCESSOR_H
 
+#include <algorithm>
+#include <cstring>
+
 #include "types.h"
+#include "BlockCache.h"
+#include "Coverage.h"
+#include "DecimalTables.h"
+#include "IdleLoopDetector.h"
+#include "PageWindow.h"
+#include "Profiler.h"
 #include "emulator/System.h"
 
 using std::uint8_t;
@@ -19,7 +28,7 @@ using std::uint32_t;
 
 namespace M65816 {
 
-template <typename MemSizeType, typename IndexSizeType, typename StackSizeType, const uint16_t StackOffset>
+template <typename MemSizeType, typename IndexSizeType, typename StackSizeType, const uint16_t StackOffset, const bool DirectPageAligned, const bool BankZero>
 class LogicEngine;
 class LogicEngineBase;
 
@@ -27,16 +36,27 @@ class LogicEngineBase;
  * The StatusRegister class implements the status register as a series
  * of direct-accessible boolean flags, plus overloads to allow constructing
  * from and casting to/from uint8_t.
+ *
+ * The N and Z flags are evaluated lazily: rather than computing them after
+ * every operation we store the result they derive from, and only test it
+ * when something (a branch, PHP, an interrupt, or the debugger) actually
+ * reads the flag.
  */
 class StatusRegister {
+    private:
+        // N is bit 15 of this value; 8-bit results are stored shifted
+        // left by 8 so that their sign bit lines up.
+        uint16_t n_result = 0;
+
+        // Z is set when this value is zero
+        uint16_t z_result = 1;
+
     public:
-        bool N = false;
         bool V = false;
         bool M = true;
         bool X = true;
         bool D = false;
         bool I = true;
-        bool Z = false;
         bool C = false;
 
         bool E = true;
@@ -45,13 +65,26 @@ class StatusRegister {
         StatusRegister(uint8_t v) { operator=(v); }
         ~StatusRegister() = default;
 
+        bool N() const { return n_result & 0x8000; }
+        bool Z() const { return !z_result; }
+
+        void setN(const bool v) { n_result = v? 0x8000 : 0; }
+        void setZ(const bool v) { z_result = !v; }
+
+        // Record the result that the N flag will be derived from
+        void setNResult(const uint8_t v)  { n_result = v << 8; }
+        void setNResult(const uint16_t v) { n_result = v; }
+
+        // Record the result that the Z flag will be derived from
+        void setZResult(const uint16_t v) { z_result = v; }
+
         StatusRegister& operator= (uint8_t v)
         {
-            N = v & 0x80;
+            setN(v & 0x80);
             V = v & 0x40;
             D = v & 0x08;
             I = v & 0x04;
-            Z = v & 0x02;
+            setZ(v & 0x02);
             C = v & 0x01;
 
             if (!E) {
@@ -64,11 +97,11 @@ class StatusRegister {
 
         StatusRegister& operator&= (uint8_t v)
         {
-            if (!(v & 0x80)) N = false;
+            if (!(v & 0x80)) setN(false);
             if (!(v & 0x40)) V = false;
             if (!(v & 0x08)) D = false;
             if (!(v & 0x04)) I = false;
-            if (!(v & 0x02)) Z = false;
+            if (!(v & 0x02)) setZ(false);
             if (!(v & 0x01)) C = false;
 
             if (!E) {
@@ -80,11 +113,11 @@ class StatusRegister {
 
         StatusRegister& operator|= (uint8_t v)
         {
-            if (v & 0x80) N = true;
+            if (v & 0x80) setN(true);
             if (v & 0x40) V = true;
             if (v & 0x08) D = true;
             if (v & 0x04) I = true;
-            if (v & 0x02) Z = true;
+            if (v & 0x02) setZ(true);
             if (v & 0x01) C = true;
 
             if (!E) {
@@ -95,28 +128,93 @@ class StatusRegister {
         }
 
         operator uint8_t() const {
-            return (N << 7)|(V << 6)|(M << 5)|(X << 4)|(D << 3)|(I << 2)|(Z << 1)|C;
+            return (N() << 7)|(V << 6)|(M << 5)|(X << 4)|(D << 3)|(I << 2)|(Z() << 1)|C;
         };
 };
 
 class Processor {
-    friend class LogicEngine<uint16_t, uint16_t, uint16_t, 0>;
-    friend class LogicEngine<uint16_t, uint8_t, uint16_t, 0>;
-    friend class LogicEngine<uint8_t, uint16_t, uint16_t, 0>;
-    friend class LogicEngine<uint8_t, uint8_t, uint16_t, 0>;
-    friend class LogicEngine<uint8_t, uint8_t, uint8_t, 0x0100>;
+    template <typename MemSizeType, typename IndexSizeType, typename StackSizeType, const uint16_t StackOffset, const bool DirectPageAligned, const bool BankZero>
+    friend class LogicEngine;
 
     private:
-        LogicEngine<uint16_t, uint16_t, uint16_t, 0> *engine_e0m0x0;
-        LogicEngine<uint16_t, uint8_t, uint16_t, 0> *engine_e0m0x1;
-        LogicEngine<uint8_t, uint16_t, uint16_t, 0> *engine_e0m1x0;
-        LogicEngine<uint8_t, uint8_t, uint16_t, 0> *engine_e0m1x1;
-        LogicEngine<uint8_t, uint8_t, uint8_t, 0x0100> *engine_e1m1x1;
- 
+        LogicEngine<uint16_t, uint16_t, uint16_t, 0, false, false> *engine_e0m0x0;
+        LogicEngine<uint16_t, uint8_t, uint16_t, 0, false, false> *engine_e0m0x1;
+        LogicEngine<uint8_t, uint16_t, uint16_t, 0, false, false> *engine_e0m1x0;
+        LogicEngine<uint8_t, uint8_t, uint16_t, 0, false, false> *engine_e0m1x1;
+        LogicEngine<uint8_t, uint8_t, uint8_t, 0x0100, false, false> *engine_e1m1x1;
+
+        // The same engines, specialized for a page-aligned direct page
+        LogicEngine<uint16_t, uint16_t, uint16_t, 0, true, false> *engine_e0m0x0_aligned;
+        LogicEngine<uint16_t, uint8_t, uint16_t, 0, true, false> *engine_e0m0x1_aligned;
+        LogicEngine<uint8_t, uint16_t, uint16_t, 0, true, false> *engine_e0m1x0_aligned;
+        LogicEngine<uint8_t, uint8_t, uint16_t, 0, true, false> *engine_e0m1x1_aligned;
+        LogicEngine<uint8_t, uint8_t, uint8_t, 0x0100, true, false> *engine_e1m1x1_aligned;
+
+        // The 65C02 engines, used in emulation mode while PBR and DBR are
+        // both zero (ie. for 8-bit Apple II software)
+        LogicEngine<uint8_t, uint8_t, uint8_t, 0x0100, false, true> *engine_bank0;
+        LogicEngine<uint8_t, uint8_t, uint8_t, 0x0100, true, true> *engine_bank0_aligned;
+
+
         LogicEngineBase *engine = nullptr;
         System *system = nullptr;
 
         const unsigned int *cycle_counts;
+        const unsigned int *instruction_lengths;
+
+        // Index of the current CPU mode (E/M/X combination, plus
+        // kAlignedModes if the direct page is page-aligned and
+        // kBankZeroModes for the 65C02 engines); used to key the block
+        // cache.
+        unsigned int mode;
+
+        static constexpr unsigned int kAlignedModes  = 5;
+        static constexpr unsigned int kBankZeroModes = 10;
+
+        // True if the current engine is one of the _aligned ones
+        bool direct_page_aligned = false;
+
+        // True if the current engine is one of the 65C02 engines
+        bool bank_zero = false;
+
+        // Returns true if the current engine no longer matches the
+        // register state and modeSwitch() needs to be called.
+        bool engineIsStale() const
+        {
+            return (direct_page_aligned != !(D & 0xFF)) || (bank_zero != (SR.E && !PBR && !DBR));
+        }
+
+        BlockCache block_cache;
+
+        cpu_core_t core = INTERPRETER;
+
+        // When executing from the block cache, points to the remaining
+        // operand bytes of the current instruction; otherwise nullptr.
+        const uint8_t *fetch_ptr = nullptr;
+
+        // Cycle budget of the current engine run
+        unsigned int slice_limit = 0;
+
+        // Make the current engine run return to runUntil() after the
+        // current instruction.
+        inline void endSlice() { slice_limit = 0; }
+
+        // Set when the idle loop detector wants the rest of the slice skipped
+        bool skip_slice = false;
+
+        // True while an engine holds the working copy of the registers
+        bool in_run = false;
+
+        // Set by instructions that change the E, M, or X bits. The switch
+        // happens once the current engine has stored the registers back.
+        bool mode_switch_pending = false;
+
+        inline void requestModeSwitch()
+        {
+            mode_switch_pending = true;
+
+            endSlice();
+        }
 
         bool stopped;
         bool waiting;
@@ -158,6 +256,16 @@ class Processor {
         // Total cycle count
         cycles_t total_cycles;
 
+        // How many of total_cycles were spent stalled on slow memory
+        cycles_t stall_cycles;
+
+        // Charge the current instruction for a stall on slow memory
+        inline void stall(const unsigned int cycles)
+        {
+            num_cycles   += cycles;
+            stall_cycles += cycles;
+        }
+
         Processor();
         ~Processor();
 
@@ -172,14 +280,53 @@ class Processor {
         // Reset the CPU
         void reset(void);
 
+        // Select the execution core
+        void setCore(const cpu_core_t);
+
+        // Returns true if the processor has nothing to do until it is
+        // interrupted (WAI) or reset (STP), in which case callers can skip
+        // runUntil() and just account for the time with idle().
+        bool isIdle() const
+        {
+            return stopped || (waiting && !irq_pending && !nmi_pending && !abort_pending);
+        }
+
+        // Let the specified number of cycles pass without executing anything
+        void idle(const unsigned int cycles) { total_cycles += cycles; }
+
+        IdleLoopDetector idle_loops;
+
+        Profiler profiler;
+
+        Coverage coverage;
+
+        // Called by the branch instructions when they jump backwards
+        inline void backwardBranch(const uint8_t pbr, const uint16_t target, const uint16_t pc, const LoopRegisters& regs)
+        {
+            if (idle_loops.backwardBranch(pbr, target, pc, regs)) {
+                skip_slice = true;
+
+                endSlice();
+            }
+        }
+
+        // Make sure the registers in this object are up to date, even if
+        // called from the middle of an instruction (eg. by the debugger).
+        void syncRegisters();
+
         // Raise a non-maskable interrupt
-        void nmi() { nmi_pending = true; }
+        void nmi() { nmi_pending = true; endSlice(); }
 
         // Raise the ABORT signal
-        void abort() { abort_pending = true; }
+        void abort() { abort_pending = true; endSlice(); }
 
         // Set IRQ line state
-        void setIRQ(bool state) { irq_pending = state; }
+        void setIRQ(bool state)
+        {
+            irq_pending = state;
+
+            if (state) endSlice();
+        }
 
         // Load the contents of a vector into the PC and PBR
         inline void loadVector(const uint16_t va)
@@ -188,7 +335,9 @@ class Processor {
             PBR = 0;
         }
 
-        // Called whenever the E, M, or X bits change.
+        // Called whenever the E, M, or X bits change, D moves on to or
+        // off of a page boundary, or (in emulation mode) PBR or DBR
+        // changes between zero and nonzero.
         void modeSwitch();
 };
 
@@ -0,0 +1,180 @@
+/**
+ * M65816: Portable 65816 Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include <boost/format.hpp>
+
+#include "Profiler.h"
+
+namespace M65816 {
+
+using boost::format;
+using std::endl;
+using std::string;
+
+static string addressName(const uint32_t address)
+{
+    return (format("%02X/%04X") % (address >> 16) % (address & 0xFFFF)).str();
+}
+
+static inline uint64_t edgeKey(const uint32_t from, const uint32_t to)
+{
+    return (static_cast<uint64_t>(from) << 24) | to;
+}
+
+/**
+ * Returns the call path tree node for the innermost frame, looking up the
+ * nodes of any frames pushed since the last time.
+ */
+unsigned int Profiler::currentNode()
+{
+    if (stack.empty()) return 0;
+
+    if (stack.back().node != kNoNode) return stack.back().node;
+
+    // Find the innermost frame that has already been looked up
+    unsigned int i = stack.size();
+
+    while (i && (stack[i - 1].node == kNoNode)) --i;
+
+    unsigned int parent = i? stack[i - 1].node : 0;
+
+    for ( ; i < stack.size() ; ++i) {
+        const uint64_t key = (static_cast<uint64_t>(parent) << 24) | stack[i].to;
+        auto iter = children.find(key);
+
+        if (iter == children.end()) {
+            stack[i].node = nodes.size();
+
+            nodes.push_back({ parent, stack[i].to, {} });
+            children[key] = stack[i].node;
+        }
+        else {
+            stack[i].node = iter->second;
+        }
+
+        parent = stack[i].node;
+    }
+
+    return parent;
+}
+
+/**
+ * Take a sample at pc. overrun is the number of cycles that ran past the
+ * point the sample was due; an overrun of more than a whole interval (an
+ * instruction that takes that long, such as a block move) counts for more
+ * than one sample.
+ */
+void Profiler::sample(const uint32_t pc, const unsigned int overrun)
+{
+    const unsigned int samples = 1 + overrun / kSampleInterval;
+
+    count(pc, samples * kSampleInterval);
+
+    if (!stack.empty()) {
+        calls[edgeKey(stack.back().from, stack.back().to)] += samples;
+    }
+
+    until_sample = kSampleInterval - (overrun % kSampleInterval);
+}
+
+void Profiler::call(const uint32_t from, const uint32_t to, const uint16_t sp)
+{
+    if (mode == COUNTING) ++calls[edgeKey(from, to)];
+
+    if (stack.size() == kMaxDepth) return;
+
+    stack.push_back({ from, to, sp, kNoNode });
+}
+
+void Profiler::ret(const uint32_t from, const uint32_t to, const uint16_t sp)
+{
+    if (mode == COUNTING) ++returns[edgeKey(from, to)];
+
+    // Pop every frame whose return address is now above the stack pointer
+    while (!stack.empty() && (stack.back().sp < sp)) {
+        stack.pop_back();
+    }
+}
+
+void Profiler::writeReport(std::ostream& out) const
+{
+    std::vector<std::pair<uint32_t, Counts>> hot;
+    cycles_t total_cycles = 0;
+
+    for (unsigned int bank = 0 ; bank < 256 ; ++bank) {
+        if (!banks[bank]) continue;
+
+        for (unsigned int addr = 0 ; addr < 65536 ; ++addr) {
+            const Counts& counts = banks[bank][addr];
+
+            if (counts.count) {
+                hot.push_back({ (bank << 16) | addr, counts });
+
+                total_cycles += counts.cycles;
+            }
+        }
+    }
+
+    std::sort(hot.begin(), hot.end(), [](const auto& a, const auto& b) { return a.second.cycles > b.second.cycles; });
+
+    out << format("Flat profile (%s), %d cycles\n\n") % (mode == COUNTING? "counted" : "sampled") % total_cycles;
+    out << format("%14s %7s %12s  %s\n") % "cycles" % "%" % (mode == COUNTING? "count" : "samples") % "address";
+
+    for (const auto& [address, counts] : hot) {
+        const float percent = total_cycles? (100.0f * counts.cycles / total_cycles) : 0.0f;
+
+        out << format("%14d %6.2f%% %12d  %s\n") % counts.cycles % percent % counts.count % addressName(address);
+    }
+
+    if (mode == COUNTING) {
+        writeEdges(out, "Calls", calls);
+        writeEdges(out, "Returns", returns);
+    }
+    else {
+        writeEdges(out, "Calls (samples taken inside each call)", calls);
+    }
+}
+
+void Profiler::writeEdges(std::ostream& out, const char *title, const std::unordered_map<uint64_t, uint64_t>& edges) const
+{
+    std::vector<std::pair<uint64_t, uint64_t>> sorted(edges.begin(), edges.end());
+
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    out << endl << title << endl << endl;
+    out << format("%14s  %-7s    %s\n") % "count" % "from" % "to";
+
+    for (const auto& [edge, count] : sorted) {
+        out << format("%14d  %s -> %s\n") % count % addressName(edge >> 24) % addressName(edge & 0xFFFFFF);
+    }
+}
+
+void Profiler::writeCollapsed(std::ostream& out) const
+{
+    for (unsigned int i = 0 ; i < nodes.size() ; ++i) {
+        if (!nodes[i].self.cycles) continue;
+
+        string path;
+
+        for (unsigned int node = i ; node ; node = nodes[node].parent) {
+            path = addressName(nodes[node].address) + (path.empty()? "" : ";") + path;
+        }
+
+        // Code run outside of any call we saw being made
+        if (path.empty()) path = "[top]";
+
+        out << path << " " << nodes[i].self.cycles << endl;
+    }
+}
+
+} // namespace M65816
@@ -0,0 +1,179 @@
+/**
+ * M65816: Portable 65816 Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "emulator/common.h"
+
+namespace M65816 {
+
+/**
+ * Selects whether the profiler samples the PC on a cycle timer, or counts
+ * every instruction executed.
+ */
+enum profiler_mode_t {
+    SAMPLING = 0,
+    COUNTING
+};
+
+/**
+ * The Profiler records how often, and for how many cycles, each 24-bit
+ * PC is seen, along with the subroutine calls and returns between them.
+ *
+ * In SAMPLING mode the processor ends a run every kSampleInterval cycles
+ * and the PC it stopped at is charged with the whole interval, so where
+ * samples land doesn't depend on what else ends runs (mode switches,
+ * interrupts). This costs next to nothing and can be left on all the
+ * time. In COUNTING mode it is given every instruction, which is exact
+ * but forces the processor onto its plain interpreter loop.
+ *
+ * Calls (JSR, JSL, interrupts) and returns (RTS, RTL, RTI) are followed
+ * on a shadow call stack, so that the cycles can also be attributed to
+ * call paths and written out in the collapsed stack format read by
+ * flamegraph tools. Frames are matched up by stack pointer rather than by
+ * pairing calls with returns, so code that discards return addresses or
+ * switches stacks doesn't leave the shadow stack out of step for long.
+ *
+ * Following a call or return only pushes or pops a frame. A frame's place
+ * in the call path tree is looked up the first time cycles are charged
+ * to it, so in SAMPLING mode that only happens at sample points. Call and
+ * return edges are counted as they are taken in COUNTING mode; in
+ * SAMPLING mode the call edge of the innermost frame is counted at each
+ * sample instead, and returns aren't recorded.
+ */
+class Profiler {
+    public:
+        // Deepest call stack that is followed
+        static constexpr unsigned int kMaxDepth = 256;
+
+        // Cycles between samples. Prime, so that it doesn't fall into step
+        // with loops in the guest code.
+        static constexpr unsigned int kSampleInterval = 1009;
+
+        bool enabled = false;
+
+        profiler_mode_t mode = SAMPLING;
+
+        Profiler() { stack.reserve(kMaxDepth); }
+        ~Profiler() = default;
+
+        bool isCounting() const { return enabled && (mode == COUNTING); }
+        bool isSampling() const { return enabled && (mode == SAMPLING); }
+
+        // Charge cycles to the instruction at the specified address
+        void count(const std::uint32_t pc, const unsigned int cycles)
+        {
+            Counts& counts = countsFor(pc);
+
+            ++counts.count;
+            counts.cycles += cycles;
+
+            Counts& self = nodes[currentNode()].self;
+
+            ++self.count;
+            self.cycles += cycles;
+        }
+
+        // Number of cycles that can run before the next sample is due
+        unsigned int cyclesToSample() const { return until_sample; }
+
+        // Called after cycles have run, leaving the PC at pc. Takes a
+        // sample there if one has come due.
+        void tick(const std::uint32_t pc, const unsigned int cycles)
+        {
+            if (cycles < until_sample) {
+                until_sample -= cycles;
+            }
+            else {
+                sample(pc, cycles - until_sample);
+            }
+        }
+
+        // Called after a call from the instruction at from to address to
+        // has pushed its return address, leaving the stack pointer at sp
+        void call(const std::uint32_t, const std::uint32_t, const std::uint16_t);
+
+        // Called after a return from the instruction at from to address
+        // to has pulled its return address, leaving the stack pointer at sp
+        void ret(const std::uint32_t, const std::uint32_t, const std::uint16_t);
+
+        // Forget the current call stack (but not what has been recorded)
+        void clearStack() { stack.clear(); }
+
+        // Write a report of the hottest addresses and call edges
+        void writeReport(std::ostream&) const;
+
+        // Write the cycles spent on each call path in collapsed stack format
+        void writeCollapsed(std::ostream&) const;
+
+    private:
+        struct Counts {
+            std::uint64_t count = 0;
+            cycles_t      cycles = 0;
+        };
+
+        // A node in the tree of call paths seen; node 0 is the root
+        struct Node {
+            unsigned int  parent;
+            std::uint32_t address;
+            Counts        self;
+        };
+
+        // Node number of a frame whose call path hasn't been looked up
+        static constexpr unsigned int kNoNode = ~0U;
+
+        struct Frame {
+            std::uint32_t from;
+            std::uint32_t to;
+            std::uint16_t sp;
+            unsigned int  node;
+        };
+
+        // Per-address counts, allocated a bank at a time as code is seen
+        std::unique_ptr<Counts[]> banks[256];
+
+        std::vector<Node> nodes = { { 0, 0, {} } };
+
+        // (parent node << 24) | address to child node
+        std::unordered_map<std::uint64_t, unsigned int> children;
+
+        std::vector<Frame> stack;
+
+        // (from << 24) | to to the number of times taken
+        std::unordered_map<std::uint64_t, std::uint64_t> calls;
+        std::unordered_map<std::uint64_t, std::uint64_t> returns;
+
+        unsigned int until_sample = kSampleInterval;
+
+        Counts& countsFor(const std::uint32_t pc)
+        {
+            std::unique_ptr<Counts[]>& bank = banks[pc >> 16];
+
+            if (!bank) bank.reset(new Counts[65536]);
+
+            return bank[pc & 0xFFFF];
+        }
+
+        unsigned int currentNode();
+
+        void sample(const std::uint32_t, const unsigned int);
+
+        void writeEdges(std::ostream&, const char *, const std::unordered_map<std::uint64_t, std::uint64_t>&) const;
+};
+
+} // namespace M65816
+
+#endif // PROFILER_H
@@ -0,0 +1,172 @@
+/**
+ * Copy the registers from the Processor into the engine
+ */
+void loadRegisters()
+{
+    SR  = cpu->SR;
+    D   = cpu->D;
+    S   = static_cast<StackSizeType>(cpu->S);
+    PC  = cpu->PC;
+    PBR = cpu->PBR;
+    DBR = cpu->DBR;
+    A   = static_cast<MemSizeType>(cpu->A);
+    B   = cpu->A.B.H;
+    X   = static_cast<IndexSizeType>(cpu->X);
+    Y   = static_cast<IndexSizeType>(cpu->Y);
+
+    // The page windows stay filled across runs; anything that changes how
+    // memory has to be accessed (including the debugger starting or
+    // stopping a trace) bumps System::map_generation, which windowCovers()
+    // checks on every use.
+}
+
+/**
+ * Copy the engine's registers back into the Processor
+ */
+void storeRegisters()
+{
+    cpu->SR  = SR;
+    cpu->D   = D;
+    cpu->PC  = PC;
+    cpu->PBR = PBR;
+    cpu->DBR = DBR;
+    cpu->A.W = accumulatorWord();
+    cpu->X.W = X;
+    cpu->Y.W = Y;
+
+    if (sizeof(StackSizeType) == 2) {
+        cpu->S.W = S;
+    }
+    else {
+        cpu->S.B.L = S;
+    }
+}
+
+/**
+ * Execute one of the interrupt pseudo-opcodes
+ */
+void interrupt(const unsigned int opcode)
+{
+    loadRegisters();
+
+    cpu->in_run = true;
+
+    executeOpcode(opcode);
+
+    cpu->in_run = false;
+
+    storeRegisters();
+}
+
+/**
+ * Execute instructions in this engine's CPU mode until the cycle budget is
+ * used up or something calls endSlice() (an interrupt being raised, a mode
+ * switch, WAI/STP, or the idle loop detector), and return the number of
+ * cycles executed.
+ *
+ * The registers live in the engine for the duration of the run. Anything
+ * outside the engine that needs them part way through (WDM handlers and
+ * the debugger) has to go through storeRegisters()/loadRegisters().
+ */
+unsigned int run(const unsigned int max_cycles)
+{
+    unsigned int opcode, cycles_done = 0;
+
+    // A counting profiler has to see every instruction
+    const bool counting = cpu->profiler.isCounting();
+
+#ifdef ENABLE_DEBUGGER
+    // The debugger trace relies on seeing every instruction fetch
+    const bool use_block_cache = !counting && !(system->debugger && system->debugger->isTracing());
+#else
+    const bool use_block_cache = !counting;
+#endif
+
+    loadRegisters();
+
+    cpu->in_run = true;
+
+    // The threaded loop doesn't record coverage, so fall back to the
+    // block cache while it's on.
+    if ((cpu->core == THREADED) && !counting && !cpu->coverage.enabled) {
+        cycles_done = runThreaded(max_cycles);
+    }
+    else {
+        cpu->slice_limit = max_cycles;
+
+        while (cycles_done < cpu->slice_limit) {
+            if (use_block_cache) {
+                if (CodeBlock *block = cpu->block_cache.lookup(PBR, PC, cpu->mode, cpu->cycle_counts, cpu->instruction_lengths, fused)) {
+                    cycles_done += runBlock(*block, max_cycles - cycles_done);
+
+                    continue;
+                }
+            }
+
+            const uint32_t pc = linearAddress(PBR, PC);
+
+            opcode = readCodeByte(PC);
+            cpu->num_cycles = cpu->cycle_counts[opcode];
+
+            ++PC;
+
+            executeOpcode(opcode);
+
+            if (counting) cpu->profiler.count(pc, cpu->num_cycles);
+
+            if (cpu->coverage.enabled) {
+                cpu->coverage.mark(pc >> 16, pc, cpu->instruction_lengths[opcode], kCoverageMode);
+            }
+
+            cycles_done += cpu->num_cycles;
+        }
+    }
+
+    cpu->in_run = false;
+
+    storeRegisters();
+
+    return cycles_done;
+}
+
+/**
+ * Execute instructions from a predecoded block until the end of the block,
+ * a branch is taken, the block is invalidated by a write, the slice is
+ * ended, or the cycle budget is used up.
+ */
+unsigned int runBlock(CodeBlock& block, const unsigned int max_cycles)
+{
+    const bool covering = cpu->coverage.enabled;
+    unsigned int cycles_done = 0;
+
+    const DecodedInstruction *ins = block.instructions;
+    const DecodedInstruction *end = ins + block.length;
+
+    while (true) {
+        const uint16_t next_pc = PC + ins->length;
+
+        if (covering) cpu->coverage.mark(PBR, PC, ins->length, kCoverageMode);
+
+        cpu->num_cycles = ins->cycles;
+        cpu->fetch_ptr  = ins->operands;
+
+        ++PC;
+
+        if (ins->handler) {
+            ins->handler(this);
+        }
+        else {
+            executeOpcode(ins->opcode);
+        }
+
+        cycles_done += cpu->num_cycles;
+
+        if ((++ins == end) || (PC != next_pc) || (cycles_done >= max_cycles)) break;
+        if (!cpu->slice_limit) break;
+        if (!cpu->block_cache.isValid(block)) break;
+    }
+
+    cpu->fetch_ptr = nullptr;
+
+    return cycles_done;
+}
@@ -0,0 +1,338 @@
+/**
+ * Direct-threaded interpreter loop. Executes instructions until the cycle
+ * budget is used up or something ends the slice early (an interrupt being
+ * raised, WAI/STP, or a mode switch), and returns the number of cycles
+ * executed.
+ *
+ * When the compiler supports computed gotos each opcode gets its own copy
+ * of the dispatch code, so the branch predictor sees one indirect jump per
+ * opcode instead of a single shared one. Interrupts are not polled here;
+ * instead anything that needs the processor's attention calls endSlice(),
+ * which drops the budget to zero.
+ */
+unsigned int runThreaded(const unsigned int max_cycles)
+{
+    unsigned int opcode, cycles_done = 0;
+
+    cpu->slice_limit = max_cycles;
+
+#ifdef __GNUC__
+    static void * const labels[256] = {
+        &&label_00, &&label_01, &&label_02, &&label_03, &&label_04, &&label_05, &&label_06, &&label_07,
+        &&label_08, &&label_09, &&label_0A, &&label_0B, &&label_0C, &&label_0D, &&label_0E, &&label_0F,
+        &&label_10, &&label_11, &&label_12, &&label_13, &&label_14, &&label_15, &&label_16, &&label_17,
+        &&label_18, &&label_19, &&label_1A, &&label_1B, &&label_1C, &&label_1D, &&label_1E, &&label_1F,
+        &&label_20, &&label_21, &&label_22, &&label_23, &&label_24, &&label_25, &&label_26, &&label_27,
+        &&label_28, &&label_29, &&label_2A, &&label_2B, &&label_2C, &&label_2D, &&label_2E, &&label_2F,
+        &&label_30, &&label_31, &&label_32, &&label_33, &&label_34, &&label_35, &&label_36, &&label_37,
+        &&label_38, &&label_39, &&label_3A, &&label_3B, &&label_3C, &&label_3D, &&label_3E, &&label_3F,
+        &&label_40, &&label_41, &&label_42, &&label_43, &&label_44, &&label_45, &&label_46, &&label_47,
+        &&label_48, &&label_49, &&label_4A, &&label_4B, &&label_4C, &&label_4D, &&label_4E, &&label_4F,
+        &&label_50, &&label_51, &&label_52, &&label_53, &&label_54, &&label_55, &&label_56, &&label_57,
+        &&label_58, &&label_59, &&label_5A, &&label_5B, &&label_5C, &&label_5D, &&label_5E, &&label_5F,
+        &&label_60, &&label_61, &&label_62, &&label_63, &&label_64, &&label_65, &&label_66, &&label_67,
+        &&label_68, &&label_69, &&label_6A, &&label_6B, &&label_6C, &&label_6D, &&label_6E, &&label_6F,
+        &&label_70, &&label_71, &&label_72, &&label_73, &&label_74, &&label_75, &&label_76, &&label_77,
+        &&label_78, &&label_79, &&label_7A, &&label_7B, &&label_7C, &&label_7D, &&label_7E, &&label_7F,
+        &&label_80, &&label_81, &&label_82, &&label_83, &&label_84, &&label_85, &&label_86, &&label_87,
+        &&label_88, &&label_89, &&label_8A, &&label_8B, &&label_8C, &&label_8D, &&label_8E, &&label_8F,
+        &&label_90, &&label_91, &&label_92, &&label_93, &&label_94, &&label_95, &&label_96, &&label_97,
+        &&label_98, &&label_99, &&label_9A, &&label_9B, &&label_9C, &&label_9D, &&label_9E, &&label_9F,
+        &&label_A0, &&label_A1, &&label_A2, &&label_A3, &&label_A4, &&label_A5, &&label_A6, &&label_A7,
+        &&label_A8, &&label_A9, &&label_AA, &&label_AB, &&label_AC, &&label_AD, &&label_AE, &&label_AF,
+        &&label_B0, &&label_B1, &&label_B2, &&label_B3, &&label_B4, &&label_B5, &&label_B6, &&label_B7,
+        &&label_B8, &&label_B9, &&label_BA, &&label_BB, &&label_BC, &&label_BD, &&label_BE, &&label_BF,
+        &&label_C0, &&label_C1, &&label_C2, &&label_C3, &&label_C4, &&label_C5, &&label_C6, &&label_C7,
+        &&label_C8, &&label_C9, &&label_CA, &&label_CB, &&label_CC, &&label_CD, &&label_CE, &&label_CF,
+        &&label_D0, &&label_D1, &&label_D2, &&label_D3, &&label_D4, &&label_D5, &&label_D6, &&label_D7,
+        &&label_D8, &&label_D9, &&label_DA, &&label_DB, &&label_DC, &&label_DD, &&label_DE, &&label_DF,
+        &&label_E0, &&label_E1, &&label_E2, &&label_E3, &&label_E4, &&label_E5, &&label_E6, &&label_E7,
+        &&label_E8, &&label_E9, &&label_EA, &&label_EB, &&label_EC, &&label_ED, &&label_EE, &&label_EF,
+        &&label_F0, &&label_F1, &&label_F2, &&label_F3, &&label_F4, &&label_F5, &&label_F6, &&label_F7,
+        &&label_F8, &&label_F9, &&label_FA, &&label_FB, &&label_FC, &&label_FD, &&label_FE, &&label_FF
+    };
+
+#define DISPATCH()                                      \
+    cycles_done += cpu->num_cycles;                     \
+    if (cycles_done >= cpu->slice_limit) goto done;     \
+    opcode = fetchInstructionByte();                    \
+    cpu->num_cycles = cpu->cycle_counts[opcode];        \
+    goto *labels[opcode]
+
+    cpu->num_cycles = 0;
+
+    DISPATCH();
+
+label_00: opcode_00(); DISPATCH();
+label_01: opcode_01(); DISPATCH();
+label_02: opcode_02(); DISPATCH();
+label_03: opcode_03(); DISPATCH();
+label_04: opcode_04(); DISPATCH();
+label_05: opcode_05(); DISPATCH();
+label_06: opcode_06(); DISPATCH();
+label_07: opcode_07(); DISPATCH();
+label_08: opcode_08(); DISPATCH();
+label_09: opcode_09(); DISPATCH();
+label_0A: opcode_0A(); DISPATCH();
+label_0B: opcode_0B(); DISPATCH();
+label_0C: opcode_0C(); DISPATCH();
+label_0D: opcode_0D(); DISPATCH();
+label_0E: opcode_0E(); DISPATCH();
+label_0F: opcode_0F(); DISPATCH();
+label_10: opcode_10(); DISPATCH();
+label_11: opcode_11(); DISPATCH();
+label_12: opcode_12(); DISPATCH();
+label_13: opcode_13(); DISPATCH();
+label_14: opcode_14(); DISPATCH();
+label_15: opcode_15(); DISPATCH();
+label_16: opcode_16(); DISPATCH();
+label_17: opcode_17(); DISPATCH();
+label_18: opcode_18(); DISPATCH();
+label_19: opcode_19(); DISPATCH();
+label_1A: opcode_1A(); DISPATCH();
+label_1B: opcode_1B(); DISPATCH();
+label_1C: opcode_1C(); DISPATCH();
+label_1D: opcode_1D(); DISPATCH();
+label_1E: opcode_1E(); DISPATCH();
+label_1F: opcode_1F(); DISPATCH();
+label_20: opcode_20(); DISPATCH();
+label_21: opcode_21(); DISPATCH();
+label_22: opcode_22(); DISPATCH();
+label_23: opcode_23(); DISPATCH();
+label_24: opcode_24(); DISPATCH();
+label_25: opcode_25(); DISPATCH();
+label_26: opcode_26(); DISPATCH();
+label_27: opcode_27(); DISPATCH();
+label_28: opcode_28(); DISPATCH();
+label_29: opcode_29(); DISPATCH();
+label_2A: opcode_2A(); DISPATCH();
+label_2B: opcode_2B(); DISPATCH();
+label_2C: opcode_2C(); DISPATCH();
+label_2D: opcode_2D(); DISPATCH();
+label_2E: opcode_2E(); DISPATCH();
+label_2F: opcode_2F(); DISPATCH();
+label_30: opcode_30(); DISPATCH();
+label_31: opcode_31(); DISPATCH();
+label_32: opcode_32(); DISPATCH();
+label_33: opcode_33(); DISPATCH();
+label_34: opcode_34(); DISPATCH();
+label_35: opcode_35(); DISPATCH();
+label_36: opcode_36(); DISPATCH();
+label_37: opcode_37(); DISPATCH();
+label_38: opcode_38(); DISPATCH();
+label_39: opcode_39(); DISPATCH();
+label_3A: opcode_3A(); DISPATCH();
+label_3B: opcode_3B(); DISPATCH();
+label_3C: opcode_3C(); DISPATCH();
+label_3D: opcode_3D(); DISPATCH();
+label_3E: opcode_3E(); DISPATCH();
+label_3F: opcode_3F(); DISPATCH();
+label_40: opcode_40(); DISPATCH();
+label_41: opcode_41(); DISPATCH();
+label_42: opcode_42(); DISPATCH();
+label_43: opcode_43(); DISPATCH();
+label_44: opcode_44(); DISPATCH();
+label_45: opcode_45(); DISPATCH();
+label_46: opcode_46(); DISPATCH();
+label_47: opcode_47(); DISPATCH();
+label_48: opcode_48(); DISPATCH();
+label_49: opcode_49(); DISPATCH();
+label_4A: opcode_4A(); DISPATCH();
+label_4B: opcode_4B(); DISPATCH();
+label_4C: opcode_4C(); DISPATCH();
+label_4D: opcode_4D(); DISPATCH();
+label_4E: opcode_4E(); DISPATCH();
+label_4F: opcode_4F(); DISPATCH();
+label_50: opcode_50(); DISPATCH();
+label_51: opcode_51(); DISPATCH();
+label_52: opcode_52(); DISPATCH();
+label_53: opcode_53(); DISPATCH();
+label_54: opcode_54(); DISPATCH();
+label_55: opcode_55(); DISPATCH();
+label_56: opcode_56(); DISPATCH();
+label_57: opcode_57(); DISPATCH();
+label_58: opcode_58(); DISPATCH();
+label_59: opcode_59(); DISPATCH();
+label_5A: opcode_5A(); DISPATCH();
+label_5B: opcode_5B(); DISPATCH();
+label_5C: opcode_5C(); DISPATCH();
+label_5D: opcode_5D(); DISPATCH();
+label_5E: opcode_5E(); DISPATCH();
+label_5F: opcode_5F(); DISPATCH();
+label_60: opcode_60(); DISPATCH();
+label_61: opcode_61(); DISPATCH();
+label_62: opcode_62(); DISPATCH();
+label_63: opcode_63(); DISPATCH();
+label_64: opcode_64(); DISPATCH();
+label_65: opcode_65(); DISPATCH();
+label_66: opcode_66(); DISPATCH();
+label_67: opcode_67(); DISPATCH();
+label_68: opcode_68(); DISPATCH();
+label_69: opcode_69(); DISPATCH();
+label_6A: opcode_6A(); DISPATCH();
+label_6B: opcode_6B(); DISPATCH();
+label_6C: opcode_6C(); DISPATCH();
+label_6D: opcode_6D(); DISPATCH();
+label_6E: opcode_6E(); DISPATCH();
+label_6F: opcode_6F(); DISPATCH();
+label_70: opcode_70(); DISPATCH();
+label_71: opcode_71(); DISPATCH();
+label_72: opcode_72(); DISPATCH();
+label_73: opcode_73(); DISPATCH();
+label_74: opcode_74(); DISPATCH();
+label_75: opcode_75(); DISPATCH();
+label_76: opcode_76(); DISPATCH();
+label_77: opcode_77(); DISPATCH();
+label_78: opcode_78(); DISPATCH();
+label_79: opcode_79(); DISPATCH();
+label_7A: opcode_7A(); DISPATCH();
+label_7B: opcode_7B(); DISPATCH();
+label_7C: opcode_7C(); DISPATCH();
+label_7D: opcode_7D(); DISPATCH();
+label_7E: opcode_7E(); DISPATCH();
+label_7F: opcode_7F(); DISPATCH();
+label_80: opcode_80(); DISPATCH();
+label_81: opcode_81(); DISPATCH();
+label_82: opcode_82(); DISPATCH();
+label_83: opcode_83(); DISPATCH();
+label_84: opcode_84(); DISPATCH();
+label_85: opcode_85(); DISPATCH();
+label_86: opcode_86(); DISPATCH();
+label_87: opcode_87(); DISPATCH();
+label_88: opcode_88(); DISPATCH();
+label_89: opcode_89(); DISPATCH();
+label_8A: opcode_8A(); DISPATCH();
+label_8B: opcode_8B(); DISPATCH();
+label_8C: opcode_8C(); DISPATCH();
+label_8D: opcode_8D(); DISPATCH();
+label_8E: opcode_8E(); DISPATCH();
+label_8F: opcode_8F(); DISPATCH();
+label_90: opcode_90(); DISPATCH();
+label_91: opcode_91(); DISPATCH();
+label_92: opcode_92(); DISPATCH();
+label_93: opcode_93(); DISPATCH();
+label_94: opcode_94(); DISPATCH();
+label_95: opcode_95(); DISPATCH();
+label_96: opcode_96(); DISPATCH();
+label_97: opcode_97(); DISPATCH();
+label_98: opcode_98(); DISPATCH();
+label_99: opcode_99(); DISPATCH();
+label_9A: opcode_9A(); DISPATCH();
+label_9B: opcode_9B(); DISPATCH();
+label_9C: opcode_9C(); DISPATCH();
+label_9D: opcode_9D(); DISPATCH();
+label_9E: opcode_9E(); DISPATCH();
+label_9F: opcode_9F(); DISPATCH();
+label_A0: opcode_A0(); DISPATCH();
+label_A1: opcode_A1(); DISPATCH();
+label_A2: opcode_A2(); DISPATCH();
+label_A3: opcode_A3(); DISPATCH();
+label_A4: opcode_A4(); DISPATCH();
+label_A5: opcode_A5(); DISPATCH();
+label_A6: opcode_A6(); DISPATCH();
+label_A7: opcode_A7(); DISPATCH();
+label_A8: opcode_A8(); DISPATCH();
+label_A9: opcode_A9(); DISPATCH();
+label_AA: opcode_AA(); DISPATCH();
+label_AB: opcode_AB(); DISPATCH();
+label_AC: opcode_AC(); DISPATCH();
+label_AD: opcode_AD(); DISPATCH();
+label_AE: opcode_AE(); DISPATCH();
+label_AF: opcode_AF(); DISPATCH();
+label_B0: opcode_B0(); DISPATCH();
+label_B1: opcode_B1(); DISPATCH();
+label_B2: opcode_B2(); DISPATCH();
+label_B3: opcode_B3(); DISPATCH();
+label_B4: opcode_B4(); DISPATCH();
+label_B5: opcode_B5(); DISPATCH();
+label_B6: opcode_B6(); DISPATCH();
+label_B7: opcode_B7(); DISPATCH();
+label_B8: opcode_B8(); DISPATCH();
+label_B9: opcode_B9(); DISPATCH();
+label_BA: opcode_BA(); DISPATCH();
+label_BB: opcode_BB(); DISPATCH();
+label_BC: opcode_BC(); DISPATCH();
+label_BD: opcode_BD(); DISPATCH();
+label_BE: opcode_BE(); DISPATCH();
+label_BF: opcode_BF(); DISPATCH();
+label_C0: opcode_C0(); DISPATCH();
+label_C1: opcode_C1(); DISPATCH();
+label_C2: opcode_C2(); DISPATCH();
+label_C3: opcode_C3(); DISPATCH();
+label_C4: opcode_C4(); DISPATCH();
+label_C5: opcode_C5(); DISPATCH();
+label_C6: opcode_C6(); DISPATCH();
+label_C7: opcode_C7(); DISPATCH();
+label_C8: opcode_C8(); DISPATCH();
+label_C9: opcode_C9(); DISPATCH();
+label_CA: opcode_CA(); DISPATCH();
+label_CB: opcode_CB(); DISPATCH();
+label_CC: opcode_CC(); DISPATCH();
+label_CD: opcode_CD(); DISPATCH();
+label_CE: opcode_CE(); DISPATCH();
+label_CF: opcode_CF(); DISPATCH();
+label_D0: opcode_D0(); DISPATCH();
+label_D1: opcode_D1(); DISPATCH();
+label_D2: opcode_D2(); DISPATCH();
+label_D3: opcode_D3(); DISPATCH();
+label_D4: opcode_D4(); DISPATCH();
+label_D5: opcode_D5(); DISPATCH();
+label_D6: opcode_D6(); DISPATCH();
+label_D7: opcode_D7(); DISPATCH();
+label_D8: opcode_D8(); DISPATCH();
+label_D9: opcode_D9(); DISPATCH();
+label_DA: opcode_DA(); DISPATCH();
+label_DB: opcode_DB(); DISPATCH();
+label_DC: opcode_DC(); DISPATCH();
+label_DD: opcode_DD(); DISPATCH();
+label_DE: opcode_DE(); DISPATCH();
+label_DF: opcode_DF(); DISPATCH();
+label_E0: opcode_E0(); DISPATCH();
+label_E1: opcode_E1(); DISPATCH();
+label_E2: opcode_E2(); DISPATCH();
+label_E3: opcode_E3(); DISPATCH();
+label_E4: opcode_E4(); DISPATCH();
+label_E5: opcode_E5(); DISPATCH();
+label_E6: opcode_E6(); DISPATCH();
+label_E7: opcode_E7(); DISPATCH();
+label_E8: opcode_E8(); DISPATCH();
+label_E9: opcode_E9(); DISPATCH();
+label_EA: opcode_EA(); DISPATCH();
+label_EB: opcode_EB(); DISPATCH();
+label_EC: opcode_EC(); DISPATCH();
+label_ED: opcode_ED(); DISPATCH();
+label_EE: opcode_EE(); DISPATCH();
+label_EF: opcode_EF(); DISPATCH();
+label_F0: opcode_F0(); DISPATCH();
+label_F1: opcode_F1(); DISPATCH();
+label_F2: opcode_F2(); DISPATCH();
+label_F3: opcode_F3(); DISPATCH();
+label_F4: opcode_F4(); DISPATCH();
+label_F5: opcode_F5(); DISPATCH();
+label_F6: opcode_F6(); DISPATCH();
+label_F7: opcode_F7(); DISPATCH();
+label_F8: opcode_F8(); DISPATCH();
+label_F9: opcode_F9(); DISPATCH();
+label_FA: opcode_FA(); DISPATCH();
+label_FB: opcode_FB(); DISPATCH();
+label_FC: opcode_FC(); DISPATCH();
+label_FD: opcode_FD(); DISPATCH();
+label_FE: opcode_FE(); DISPATCH();
+label_FF: opcode_FF(); DISPATCH();
+
+#undef DISPATCH
+
+done:
+#else
+    while (cycles_done < cpu->slice_limit) {
+        opcode = fetchInstructionByte();
+        cpu->num_cycles = cpu->cycle_counts[opcode];
+
+        executeOpcode(opcode);
+
+        cycles_done += cpu->num_cycles;
+    }
+#endif
+
+    return cycles_done;
+}
@@ -51,6 +51,33 @@ enum mem_access_t {
     OPERAND
 };
 
+/**
+ * Selects how the processor executes code: by interpreting each
+ * instruction (through the block cache), or with the direct-threaded
+ * interpreter loop.
+ */
+enum cpu_core_t {
+    INTERPRETER = 0,
+    THREADED
+};
+
+class LogicEngineBase;
+
+/**
+ * Pointer to a function that executes one specific opcode on an engine.
+ */
+typedef void (*opcode_handler_t)(LogicEngineBase *);
+
+/**
+ * A superinstruction: a short sequence of opcodes that is executed by a
+ * single handler when it appears in a cached block.
+ */
+struct fused_opcode_t {
+    unsigned int count;
+    unsigned int opcodes[3];
+    opcode_handler_t handler;
+};
+
 } // namespace M65816
 
 #endif // M65816_TYPES_H_
@@ -0,0 +1,166 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+/*
+ * This class implements the registers of a ZipGS-style accelerator card,
+ * which guest software (such as the ZipGS control panel) uses to set the
+ * speed of the card, turn its cache on and off, and pick the slots it
+ * slows down for. The registers are locked at powerup, and have to be
+ * unlocked by writing $5A to $C05A four times; writing $A5 locks them
+ * again.
+ *
+ * $C058 W: disable the card
+ * $C059 R/W: control bits; bit 4 set disables the cache
+ * $C05A R: speed reduction in the high nibble
+ *       W: unlock/lock sequence
+ * $C05B R: status; bit 7 toggles every millisecond, bit 4 is set when
+ *          the card is disabled, bits 1-0 give the cache size
+ *       W: enable the card
+ * $C05C R/W: slot slowdown mask, one bit per slot
+ * $C05D R/W: speed reduction in the high nibble; the card runs at
+ *            (16 - n)/16 of its clock speed
+ *
+ * The card does not do anything itself; the Emulator asks it for the
+ * resulting CPU speed once per frame.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "ZipGS.h"
+
+using std::uint8_t;
+
+/**
+ * Reset the card to its powerup state.
+ */
+void ZipGS::reset()
+{
+    unlock_count = 0;
+
+    enabled         = true;
+    cache_enabled   = true;
+    speed_reduction = 0;
+    slow_slots      = 0;
+    control         = 0;
+
+    timer_bit = false;
+}
+
+uint8_t ZipGS::read(const unsigned int& offset)
+{
+    uint8_t val = 0;
+
+    if (!isUnlocked()) {
+        return val;
+    }
+
+    switch (offset) {
+        case 0x59:
+            val = control;
+
+            break;
+
+        case 0x5A:
+        case 0x5D:
+            val = (speed_reduction << 4) | 0x0F;
+
+            break;
+
+        case 0x5B:
+            if (timer_bit) val |= 0x80;
+            if (!enabled)  val |= 0x10;
+
+            val |= 0x03;    // 64K cache
+
+            break;
+
+        case 0x5C:
+            val = slow_slots;
+
+            break;
+
+        default:
+            break;
+    }
+
+    return val;
+}
+
+void ZipGS::write(const unsigned int& offset, const uint8_t& val)
+{
+    if (offset == 0x5A) {
+        if (val == 0x5A) {
+            if (!isUnlocked()) ++unlock_count;
+        }
+        else if (val == 0xA5) {
+            unlock_count = 0;
+        }
+
+        return;
+    }
+
+    if (!isUnlocked()) {
+        return;
+    }
+
+    switch (offset) {
+        case 0x58:
+            enabled = false;
+
+            break;
+
+        case 0x59:
+            control       = val;
+            cache_enabled = !(val & 0x10);
+
+            break;
+
+        case 0x5B:
+            enabled = true;
+
+            break;
+
+        case 0x5C:
+            slow_slots = val;
+
+            break;
+
+        case 0x5D:
+            speed_reduction = val >> 4;
+
+            break;
+
+        default:
+            break;
+    }
+}
+
+void ZipGS::microtick(const unsigned int line_number)
+{
+    if (!(line_number % kTimerLines)) {
+        timer_bit = !timer_bit;
+    }
+}
+
+float ZipGS::getSpeed(const float clock) const
+{
+    if (!enabled) {
+        return kSystemSpeed;
+    }
+
+    float speed = clock * (16 - speed_reduction) / 16.0f;
+
+    // Without the cache every access goes out over the motherboard's bus
+    if (!cache_enabled) {
+        speed = std::min(speed, kSystemSpeed);
+    }
+
+    return std::max(speed, 1.0f);
+}
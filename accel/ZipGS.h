@@ -0,0 +1,92 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef ZIPGS_H_
+#define ZIPGS_H_
+
+#include <vector>
+
+#include "emulator/Device.h"
+
+/**
+ * An accelerator card in the style of the ZipGS. The card sits between
+ * the CPU and the rest of the machine and runs the CPU from its own clock
+ * (with a cache in front of fast RAM), dropping back to 1 MHz whenever a
+ * slot it has been told to slow down for is busy.
+ */
+class ZipGS : public Device {
+    private:
+        // Speed of the motherboard's FPI, which the card falls back to when
+        // it is disabled or running without its cache
+        static constexpr float kSystemSpeed = 2.8f;
+
+        // Number of $5A writes to $C05A needed to unlock the registers
+        static constexpr unsigned int kUnlockCount = 4;
+
+        // Number of scanlines between toggles of the 1 ms timer bit
+        static constexpr unsigned int kTimerLines = 16;
+
+        unsigned int unlock_count;
+
+        bool enabled;
+        bool cache_enabled;
+
+        // Speed reduction, in sixteenths of the card's clock
+        uint8_t speed_reduction;
+
+        // Bit n set = slow down to 1 MHz while slot n is busy
+        uint8_t slow_slots;
+
+        // The raw contents of the control register at $C059
+        uint8_t control;
+
+        bool timer_bit;
+
+        bool isUnlocked() const { return unlock_count >= kUnlockCount; }
+
+        std::vector<unsigned int>& ioReadList()
+        {
+            static std::vector<unsigned int> locs = {
+                0x59, 0x5A, 0x5B, 0x5C, 0x5D
+            };
+
+            return locs;
+        }
+
+        std::vector<unsigned int>& ioWriteList()
+        {
+            static std::vector<unsigned int> locs = {
+                0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D
+            };
+
+            return locs;
+        }
+
+    public:
+        ZipGS() = default;
+        ~ZipGS() = default;
+
+        void reset();
+        uint8_t read(const unsigned int& offset);
+        void write(const unsigned int& offset, const uint8_t& value);
+
+        void microtick(const unsigned int);
+
+        // Returns the speed, in MHz, that the CPU runs at with the card
+        // clocked at the given speed.
+        float getSpeed(const float) const;
+
+        // Returns true if the card slows down while the given slot is busy
+        bool isSlowSlot(const unsigned int slot) const
+        {
+            return (slot < 8) && (slow_slots & (1 << slot));
+        }
+};
+
+#endif // ZIPGS_H_
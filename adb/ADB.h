@@ -88,6 +88,13 @@ class ADB : public Device {
             return locs;
         }
 
+        std::vector<unsigned int>& ioPollList()
+        {
+            static std::vector<unsigned int> locs = { 0x00 };
+
+            return locs;
+        }
+
         uint8_t readKeyboard();
         uint8_t readMouse();
         uint8_t readModifiers();
@@ -30,6 +30,15 @@ using boost::format;
 
 using M65816::mem_access_t;
 
+void Debugger::setTrace(const bool on)
+{
+    trace = on;
+
+    // Make the CPU drop its cached page pointers, so that a trace sees
+    // every instruction fetch from here on.
+    if (system) ++system->map_generation;
+}
+
 uint8_t Debugger::memoryRead(const uint8_t bank, const uint16_t address, const uint8_t val, const mem_access_t type)
 {
     switch (type) {
@@ -65,6 +74,10 @@ void Debugger::handleInstructionRead(const uint8_t bank, const uint16_t address,
         cpu_instr.bytes.push_back(val);
     }
     else {
+        // Only the trace looks at the registers, so only it needs the
+        // running engine's copies written back
+        system->cpu->syncRegisters();
+
         if (cpu_instr.bytes.size()) {
             cout << format("%02X/%04X:%-12s  %3s  %-18s |%c%c%c%c%c%c%c%c| E=%1d DBR=%02X A=%04X X=%04X Y=%04X S=%04X D=%04X\n")
                             % (int) cpu_instr.pbr
@@ -72,13 +85,13 @@ void Debugger::handleInstructionRead(const uint8_t bank, const uint16_t address,
                             % renderBytes()
                             % opcodes[cpu_instr.bytes[0]].mnemonic
                             % renderArgument()
-                            % (system->cpu->SR.N? 'n' : '-')
+                            % (system->cpu->SR.N()? 'n' : '-')
                             % (system->cpu->SR.V? 'v' : '-')
                             % (system->cpu->SR.M? 'm' : '-')
                             % (system->cpu->SR.X? 'x' : '-')
                             % (system->cpu->SR.D? 'd' : '-')
                             % (system->cpu->SR.I? 'i' : '-')
-                            % (system->cpu->SR.Z? 'z' : '-')
+                            % (system->cpu->SR.Z()? 'z' : '-')
                             % (system->cpu->SR.C? 'c' : '-')
                             % (int) system->cpu->SR.E
                             % (int) system->cpu->DBR
@@ -23,7 +23,7 @@ class Debugger {
     private:
         const unsigned int kMaxInstLen = 4;
 
-        System *system;
+        System *system = nullptr;
 
         /**
          * True when the CPU is fetching an instruction
@@ -63,9 +63,12 @@ class Debugger {
             system = theSystem;
         }
 
-        void enableTrace() { trace = true; }
-        void disableTrace() { trace = false; }
-        void toggleTrace() { trace = !trace; }
+        void enableTrace() { setTrace(true); }
+        void disableTrace() { setTrace(false); }
+        void toggleTrace() { setTrace(!trace); }
+        bool isTracing() const { return trace; }
+
+        void setTrace(const bool);
 
         std::uint8_t memoryRead(const uint8_t bank, const uint16_t address, const uint8_t val, const M65816::mem_access_t type);
         std::uint8_t memoryWrite(const uint8_t bank, const uint16_t address, const uint8_t val, const M65816::mem_access_t type);
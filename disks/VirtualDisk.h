@@ -101,12 +101,12 @@ class VirtualDisk {
         VirtualDisk(std::experimental::filesystem::path filename) : image_path(filename) {}
 #endif
         
-        ~VirtualDisk();
+        virtual ~VirtualDisk();
 
-        void open();
-        void close();
-        void read(uint8_t *, const unsigned int, const unsigned int);
-        void write(uint8_t *, const unsigned int, const unsigned int);
+        virtual void open();
+        virtual void close();
+        virtual void read(uint8_t *, const unsigned int, const unsigned int);
+        virtual void write(uint8_t *, const unsigned int, const unsigned int);
 };
 
 #endif
@@ -30,4 +30,8 @@ void Device::attach(System *parent)
     for (auto loc : ioWriteList()) {
         system->setIoWrite(loc, this);
     }
+
+    for (auto loc : ioPollList()) {
+        system->setIoPoll(loc);
+    }
 }
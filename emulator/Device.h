@@ -14,6 +14,16 @@ class Device {
         virtual std::vector<unsigned int>& ioReadList() = 0;
         virtual std::vector<unsigned int>& ioWriteList() = 0;
 
+        // I/O locations that can be read without side effects and whose
+        // values only change between scanlines, such as status registers.
+        // Loops that poll only these are fast-forwarded by the CPU.
+        virtual std::vector<unsigned int>& ioPollList()
+        {
+            static std::vector<unsigned int> locs;
+
+            return locs;
+        }
+
     public:
         Device() = default;
         virtual ~Device() = default;
@@ -25,6 +35,31 @@ class Device {
         virtual void cop(const uint8_t) {}
         virtual void wdm(const uint8_t) {}
 
+        // Called before a call to a function in a tool set the device has
+        // been registered for with System::setToolHandler(), with the
+        // Processor's registers as they are at the JSL. Returns true if
+        // the device did the whole call itself, in which case it must
+        // leave the registers as the tool would have on return.
+        virtual bool toolCall(const uint16_t, const uint32_t) { return false; }
+
+        // Called when a call passed to System::watchToolReturn() returns
+        virtual void toolReturn(const uint16_t) {}
+
+        // Called before a ProDOS 8 MLI call if the device has been
+        // registered with System::setMLIHandler(), with the address of the
+        // command byte following the JSR. Returns true if the device did
+        // the call itself, in which case it must set the registers and PC
+        // as the MLI would have on return.
+        virtual bool mliCall(const uint16_t) { return false; }
+
+        // Called before a GS/OS call if the device has been registered
+        // with System::setGSOSHandler(), with whether it is a stack-based
+        // call and the address it returns to. Returns true if the device
+        // did the call itself, in which case it must leave the registers
+        // (including PC or S, to skip the call's parameters) as GS/OS
+        // would have on return.
+        virtual bool gsosCall(const bool, const uint32_t) { return false; }
+
         virtual void attach(System *theSystem);
         virtual void detach() { system = nullptr; }
 
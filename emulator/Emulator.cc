@@ -22,6 +22,8 @@
     #include <thread>
 #endif
 
+#include <algorithm>
+#include <cctype>
 #include <iostream>
 #include <stdexcept>
 #include <boost/format.hpp>
@@ -42,6 +44,15 @@
 #include "scc/Zilog8530.h"
 #include "vgc/VGC.h"
 
+#include "accel/ZipGS.h"
+#include "hle/MemoryManager.h"
+#include "hle/IntegerMath.h"
+#include "hle/SANE.h"
+#include "hle/ProDOS8.h"
+#include "hle/HostFST.h"
+#include "hle/HostVolume.h"
+#include "hle/QuickDraw.h"
+
 #include "disks/IWM.h"
 #include "disks/Smartport.h"
 #include "disks/VirtualDisk.h"
@@ -84,11 +95,53 @@ Emulator::~Emulator()
 #ifndef _WIN32
     close(timer_fd);
 #endif
+    if (idle_skip) {
+        cerr << boost::format("Skipped %d idle loops (%d cycles)\n") % cpu->idle_loops.skips % cpu->idle_loops.cycles_skipped;
+    }
+
+    if (profile_file.length()) {
+        std::ofstream report(profile_file + ".txt");
+        std::ofstream collapsed(profile_file + ".folded");
+
+        cpu->profiler.writeReport(report);
+        cpu->profiler.writeCollapsed(collapsed);
+
+        cerr << boost::format("Wrote profile to %s.txt and %s.folded\n") % profile_file % profile_file;
+    }
+
+    if (coverage_file.length()) {
+        std::ofstream cov(coverage_file, std::ofstream::binary);
+
+        cpu->coverage.write(cov);
+
+        cerr << boost::format("Wrote coverage to %s\n") % coverage_file;
+    }
+
+    if (qd_hle) qd_hle->writeStats(cerr);
+    if (mm_hle) mm_hle->writeStats(cerr);
+    if (im_hle) im_hle->writeStats(cerr);
+    if (sane_hle) sane_hle->writeStats(cerr);
+
+    if (p8_hle) {
+        cerr << boost::format("ProDOS 8 HLE: handled %d calls\n") % p8_hle->getCallsHandled();
+    }
+
+    if (gsos_host) {
+        cerr << boost::format("GS/OS host path passthrough: handled %d calls\n") % gsos_host->getCallsHandled();
+    }
+
     delete cpu;
     delete sys;
     delete mega2;
     delete scc;
     delete vgc;
+    delete zip;
+    delete qd_hle;
+    delete mm_hle;
+    delete im_hle;
+    delete sane_hle;
+    delete p8_hle;
+    delete gsos_host;
 
     delete video;
 
@@ -117,7 +170,8 @@ bool Emulator::setup(const int argc, const char** argv)
 
     last_time = now();
 
-    maximum_speed = 2.8;
+    // With an accelerator card the speed setting is the card's clock
+    maximum_speed = zipgs? 8.0 : 2.8;
     framerate = pal? 50 : 60;
 
     for (int i = 0 ; i < framerate; ++i) {
@@ -160,6 +214,24 @@ bool Emulator::setup(const int argc, const char** argv)
 
     sys->installProcessor(cpu);
 
+    if (cpu_core == "threaded") {
+        cpu->setCore(M65816::THREADED);
+    }
+    else {
+        cpu->setCore(M65816::INTERPRETER);
+    }
+
+    cpu->idle_loops.enabled = idle_skip;
+
+    if (profile_file.length()) {
+        cpu->profiler.enabled = true;
+        cpu->profiler.mode    = (profile_mode == "count")? M65816::COUNTING : M65816::SAMPLING;
+    }
+
+    if (coverage_file.length()) {
+        cpu->coverage.enable(coverage_by_mode);
+    }
+
     sys->installMemory(rom, rom_start_page, rom_pages, ROM);
     sys->installMemory(fast_ram, 0, fast_ram_pages, FAST);
     sys->installMemory(slow_ram, 0xE000, 512, SLOW);
@@ -172,6 +244,46 @@ bool Emulator::setup(const int argc, const char** argv)
     sys->installDevice("iwm", iwm);
     sys->installDevice("smpt", smpt);
 
+    if (zipgs) {
+        zip = new ZipGS();
+
+        sys->installDevice("zipgs", zip);
+    }
+
+    if (use_qd_hle || qd_hle_compare) {
+        qd_hle = new QuickDrawHLE(qd_hle_compare);
+
+        sys->installDevice("qdhle", qd_hle);
+    }
+
+    if (use_mm_hle || mm_hle_compare) {
+        mm_hle = new MemoryManagerHLE(mm_hle_compare);
+
+        sys->installDevice("mmhle", mm_hle);
+    }
+
+    if (use_math_hle || math_hle_compare) {
+        im_hle = new IntegerMathHLE(math_hle_compare);
+
+        sys->installDevice("imhle", im_hle);
+
+        sane_hle = new SANEHLE(math_hle_compare);
+
+        sys->installDevice("sanehle", sane_hle);
+    }
+
+    if (prodos_host_dir.length()) {
+        p8_hle = new ProDOS8HLE(prodos_host_dir, prodos_host_volume);
+
+        sys->installDevice("p8hle", p8_hle);
+    }
+
+    if (gsos_host_dir.length()) {
+        gsos_host = new HostFST(gsos_host_dir, gsos_host_volume);
+
+        sys->installDevice("gsoshost", gsos_host);
+    }
+
     sys->setWdmHandler(0xC7, smpt);
     sys->setWdmHandler(0xC8, smpt);
 
@@ -193,6 +305,36 @@ bool Emulator::setup(const int argc, const char** argv)
         }
     }
 
+    // Let GS/OS see the host directory as a volume on the first free
+    // Smartport unit, if its name will do for ProDOS
+    if (gsos_host_dir.length()) {
+        string name = gsos_host_volume;
+        unsigned int unit = 0;
+
+        std::transform(name.begin(), name.end(), name.begin(), [](char c) { return std::toupper(static_cast<unsigned char>(c)); });
+
+        while ((unit < kSmartportUnits) && hd[unit].length()) ++unit;
+
+        if (!ProDOS8HLE::isValidName(name)) {
+            cerr << boost::format("Not mounting the GS/OS host directory: \"%s\" isn't a valid ProDOS volume name\n") % gsos_host_volume;
+        }
+        else if (unit == kSmartportUnits) {
+            cerr << "Not mounting the GS/OS host directory: no free Smartport unit\n";
+        }
+        else {
+            HostVolume *volume = new HostVolume(gsos_host_dir, name);
+
+            try {
+                smpt->mountImage(unit, volume);
+            }
+            catch (std::runtime_error& e) {
+                cerr << boost::format("Not mounting the GS/OS host directory: %s\n") % e.what();
+
+                delete volume;
+            }
+        }
+    }
+
     if (s5d1.length()) {
         iwm->loadDrive(5, 0, new VirtualDisk(s5d1));
     }
@@ -257,10 +399,30 @@ void Emulator::tick()
 {
     target_speed = mega2->sw_fastmode? maximum_speed : 1.0f;
 
+    // In fast mode an accelerator card sets the speed instead, dropping
+    // to 1 MHz while a disk in one of its slowed-down slots is spinning.
+    if (zip && mega2->sw_fastmode) {
+        const unsigned int motor = iwm->getMotorState();
+
+        target_speed = (motor && zip->isSlowSlot(motor >> 4))? 1.0f : zip->getSpeed(maximum_speed);
+    }
+
+    // Each access to the slow side costs the fast CPU roughly one 1 MHz
+    // cycle, of which one CPU cycle is already in the cycle counts.
+    sys->setSlowAccessStall((target_speed > 1.0f)? static_cast<unsigned int>(target_speed + 0.5f) - 1 : 0);
+
     unsigned int cycles_per = (1000000/(VGC::kLinesPerFrame * framerate)) * target_speed;
 
     for (unsigned int line = 0; line < VGC::kLinesPerFrame ; ++line) {
-        cpu->runUntil(cycles_per);
+        // A processor sitting in WAI or STP can only be woken by a device,
+        // and devices only change state between lines, so there is no need
+        // to call into the CPU core until then.
+        if (cpu->isIdle()) {
+            cpu->idle(cycles_per);
+        }
+        else {
+            cpu->runUntil(cycles_per);
+        }
 
         for (unsigned int dt = 0 ; dt < doc_ticks[line % 19] ; ++dt) {
             doc->microtick(0);
@@ -268,6 +430,8 @@ void Emulator::tick()
 
         vgc->microtick(line);
         mega2->microtick(line);
+
+        if (zip) zip->microtick(line);
     }
 
     mega2->tick(current_frame);
@@ -280,9 +444,12 @@ void Emulator::tick()
         current_frame = 0;
     }
 
-    cycles_t diff_cycles = sys->cpu->total_cycles - last_cycles;
+    // Cycles lost to slow memory stalls don't count towards the speed,
+    // so that it reflects how much work the CPU actually got done.
+    const cycles_t useful_cycles = sys->cpu->total_cycles - sys->cpu->stall_cycles;
+    cycles_t diff_cycles = useful_cycles - last_cycles;
 
-    last_cycles = sys->cpu->total_cycles;
+    last_cycles = useful_cycles;
 
     video->startFrame();
     video->drawFrame(vgc->frame_buffer, vgc->video_width, vgc->video_height);
@@ -445,6 +612,23 @@ bool Emulator::loadConfig(const int argc, const char **argv)
         ("trace",    po::bool_switch(&debugger.trace)->default_value(false), "Enable trace")
         ("rom03,3",  po::bool_switch(&rom03)->default_value(false),          "Enable ROM 03 emulation")
         ("pal",      po::bool_switch(&pal)->default_value(false),            "Enable PAL (50 Hz) mode")
+        ("idle-skip", po::bool_switch(&idle_skip)->default_value(false),     "Fast-forward through loops that only poll status registers")
+        ("zipgs",    po::bool_switch(&zipgs)->default_value(false),          "Emulate a ZipGS accelerator card")
+        ("profile",  po::value<string>(&profile_file),                        "Profile guest code, writing the reports to <arg>.txt and <arg>.folded")
+        ("profile-mode", po::value<string>(&profile_mode)->default_value("sample"), "Profiler mode (sample or count)")
+        ("coverage", po::value<string>(&coverage_file),                      "Record which addresses are executed, writing the bitmap to <arg>")
+        ("coverage-by-mode", po::bool_switch(&coverage_by_mode)->default_value(false), "Record coverage separately for each E/M/X mode")
+        ("qd-hle",   po::bool_switch(&use_qd_hle)->default_value(false),     "Perform selected QuickDraw II calls natively")
+        ("qd-hle-compare", po::bool_switch(&qd_hle_compare)->default_value(false), "Check the native QuickDraw II calls against the ROM instead of replacing it")
+        ("mm-hle",   po::bool_switch(&use_mm_hle)->default_value(false),     "Perform the Memory Manager handle queries and block copies natively (allocation stays in the ROM)")
+        ("mm-hle-compare", po::bool_switch(&mm_hle_compare)->default_value(false), "Check the native Memory Manager calls against the ROM instead of replacing it")
+        ("math-hle", po::bool_switch(&use_math_hle)->default_value(false),   "Perform Integer Math and selected SANE calls natively")
+        ("math-hle-compare", po::bool_switch(&math_hle_compare)->default_value(false), "Check the native Integer Math and selected SANE calls against the ROM instead of replacing it")
+        ("prodos-host", po::value<string>(&prodos_host_dir),                 "Serve a ProDOS 8 volume from host directory <arg>")
+        ("prodos-host-volume", po::value<string>(&prodos_host_volume)->default_value("HOST"), "Volume name for the host directory")
+        ("gsos-host", po::value<string>(&gsos_host_dir),                     "Pass GS/OS calls on full paths under /<gsos-host-volume>/ through to host directory <arg>, and mount a read-only snapshot of it on a free Smartport unit")
+        ("gsos-host-volume", po::value<string>(&gsos_host_volume)->default_value("Host"), "First pathname component that selects the GS/OS host directory")
+        ("cpu-core", po::value<string>(&cpu_core)->default_value("interp"),        "CPU core to use (interp or threaded)")
         ("romfile",  po::value<string>(&rom_file)->default_value("xgs.rom"),        "Name of ROM file to load")
         ("ram",      po::value<unsigned int>(&ram_size)->default_value(1024),       "Set RAM size in KB")
         ("font40",   po::value<string>(&font40_file)->default_value("xgs40.fnt"),   "Name of 40-column font to load")
@@ -497,6 +681,24 @@ bool Emulator::loadConfig(const int argc, const char **argv)
             po::notify(vm);
         } 
 
+        if ((cpu_core != "interp") && (cpu_core != "threaded")) {
+            throw std::runtime_error("Unknown CPU core \"" + cpu_core + "\"");
+        }
+
+        if ((profile_mode != "sample") && (profile_mode != "count")) {
+            throw std::runtime_error("Unknown profiler mode \"" + profile_mode + "\"");
+        }
+
+        prodos_host_volume = ProDOS8HLE::prodosName(prodos_host_volume);
+
+        if (!ProDOS8HLE::isValidName(prodos_host_volume)) {
+            throw std::runtime_error("Invalid ProDOS volume name \"" + prodos_host_volume + "\"");
+        }
+
+        if (!HostFST::isValidName(gsos_host_volume)) {
+            throw std::runtime_error("Invalid GS/OS volume name \"" + gsos_host_volume + "\"");
+        }
+
         rom_pages      = rom03? 1024 : 512;
         rom_start_page = 0x10000 - rom_pages;
         rom = new uint8_t[rom_pages * 256];
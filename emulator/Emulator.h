@@ -21,6 +21,13 @@ class Mega2;
 class Smartport;
 class VGC;
 class Zilog8530;
+class QuickDrawHLE;
+class MemoryManagerHLE;
+class IntegerMathHLE;
+class SANEHLE;
+class ProDOS8HLE;
+class HostFST;
+class ZipGS;
 
 namespace M65816 {
     class Processor;
@@ -76,6 +83,13 @@ class Emulator {
         Zilog8530* scc;
         Smartport* smpt;
         VGC*   vgc;
+        ZipGS* zip = nullptr;
+        QuickDrawHLE* qd_hle = nullptr;
+        MemoryManagerHLE* mm_hle = nullptr;
+        IntegerMathHLE* im_hle = nullptr;
+        SANEHLE* sane_hle = nullptr;
+        ProDOS8HLE* p8_hle = nullptr;
+        HostFST* gsos_host = nullptr;
 
         uint8_t *rom;
         unsigned int rom_start_page;
@@ -90,6 +104,31 @@ class Emulator {
         bool use_debugger;
         bool pal;
 
+        std::string cpu_core;
+        bool idle_skip;
+        bool zipgs;
+
+        std::string profile_file;
+        std::string profile_mode;
+
+        std::string coverage_file;
+        bool coverage_by_mode;
+
+        bool use_qd_hle;
+        bool qd_hle_compare;
+
+        bool use_mm_hle;
+        bool mm_hle_compare;
+
+        bool use_math_hle;
+        bool math_hle_compare;
+
+        std::string prodos_host_dir;
+        std::string prodos_host_volume;
+
+        std::string gsos_host_dir;
+        std::string gsos_host_volume;
+
         uint8_t font_40col[kFont40Bytes * 2];
         uint8_t font_80col[kFont80Bytes * 2];
 
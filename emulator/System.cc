@@ -32,6 +32,18 @@ System::System(const bool rom03)
 
     for (unsigned int page = 0 ; page < System::kNumPages;  page++) {
         read_map[page] = write_map[page] = page;
+        page_versions[page] = 0;
+        access_stalls[page] = 0;
+    }
+
+    access_stalls[kIOPage] = 0;
+
+    for (unsigned int offset = 0 ; offset < System::kPageSize ; ++offset) {
+        io_poll[offset] = false;
+    }
+
+    for (unsigned int toolset = 0 ; toolset < 256 ; ++toolset) {
+        tool_handler[toolset] = nullptr;
     }
 }
 
@@ -58,7 +70,13 @@ void System::installMemory(uint8_t *mem, const unsigned int start_page, const un
         memory[page].type  = type;
         memory[page].read  = p;
         memory[page].write = (type == ROM? nullptr : p);
+
+        access_stalls[page] = (type == SLOW)? slow_access_stall : 0;
+
+        ++page_versions[page];
     }
+
+    ++map_generation;
 }
 
 void System::installDevice(const string& name, Device *d)
@@ -73,6 +91,8 @@ void System::installDevice(const string& name, Device *d)
  */
 void System::reset()
 {
+    tool_return = kNoToolReturn;
+
     for (auto const& iter : devices) {
         iter.second->reset();
     }
@@ -113,8 +133,12 @@ void System::sysWrite(const uint8_t bank, const uint16_t address, uint8_t val)
     if (page.write) {
         page.write[offset] = val;
 
+        ++page_versions[page_no];
+
         if (page.swrite) {
             page.swrite[offset] = val;
+
+            ++page_versions[(page_no & 0x01FF) | 0xE000];
         }
     }
 }
@@ -126,13 +150,12 @@ uint8_t System::cpuRead(const uint8_t bank, const uint16_t address, const M65816
     MemoryPage& page = (type == M65816::VECTOR)? memory[page_no|0xFF00] : memory[page_no];
     uint8_t val;
 
+    if (access_stalls[page_no]) {
+        cpu->stall(access_stalls[page_no]);
+    }
+
     if (page_no == kIOPage) {
-        if (Device *dev = io_read[offset]) {
-            val = dev->read(offset);
-        }
-        else {
-            val = 0; // FIXME: should be random
-        }
+        val = ioRead(offset);
     }
     else if (page.read) {
         val = page.read[offset];
@@ -159,8 +182,19 @@ void System::cpuWrite(const uint8_t bank, const uint16_t address, uint8_t val, c
     const unsigned int offset  = address & 0xFF;
     MemoryPage& page = memory[page_no];
 
+    ++cpu_writes;
+
+    // Writes to shadowed pages go through to the slow side as well
+    const unsigned int stall = (page_no != kIOPage) && page.swrite? slow_access_stall : access_stalls[page_no];
+
+    if (stall) {
+        cpu->stall(stall);
+    }
+
 #ifdef ENABLE_DEBUGGER
-    if (debugger) { val = debugger->memoryWrite(bank, address, val, type); }
+    if (debugger) {
+        val = debugger->memoryWrite(bank, address, val, type);
+    }
 #endif
 
     if (page_no == kIOPage) {
@@ -171,12 +205,82 @@ void System::cpuWrite(const uint8_t bank, const uint16_t address, uint8_t val, c
     else if (page.write) {
         page.write[offset] = val;
 
+        ++page_versions[page_no];
+
         if (page.swrite) {
             page.swrite[offset] = val;
+
+            ++page_versions[(page_no & 0x01FF) | 0xE000];
         }
     }
 }
 
+uint8_t System::cpuIoRead(const uint8_t offset)
+{
+    if (access_stalls[kIOPage]) {
+        cpu->stall(access_stalls[kIOPage]);
+    }
+
+    return ioRead(offset);
+}
+
+/**
+ * Read from the I/O page, keeping track of the reads the idle loop
+ * detector cares about.
+ */
+uint8_t System::ioRead(const uint8_t offset)
+{
+    uint8_t val = 0; // FIXME: should be random
+
+    if (Device *dev = io_read[offset]) {
+        val = dev->read(offset);
+    }
+
+    if (io_poll[offset]) {
+        ++poll_reads;
+
+        poll_signature = (poll_signature * 31) + ((offset << 8) | val);
+    }
+    else {
+        ++volatile_io_reads;
+    }
+
+    return val;
+}
+
+void System::cpuIoWrite(const uint8_t offset, const uint8_t val)
+{
+    ++cpu_writes;
+
+    if (access_stalls[kIOPage]) {
+        cpu->stall(access_stalls[kIOPage]);
+    }
+
+    if (Device *dev = io_write[offset]) {
+        dev->write(offset, val);
+    }
+}
+
+/**
+ * Set the stall charged for CPU accesses to the slow side of the machine:
+ * the Mega II RAM in banks $E0/$E1 and the I/O page. This changes which
+ * pages the CPU may access directly, so it counts as a map change.
+ */
+void System::setSlowAccessStall(const unsigned int cycles)
+{
+    if (cycles == slow_access_stall) return;
+
+    slow_access_stall = cycles;
+
+    for (unsigned int page = 0 ; page < System::kNumPages ; ++page) {
+        access_stalls[page] = (memory[page].type == SLOW)? cycles : 0;
+    }
+
+    access_stalls[kIOPage] = cycles;
+
+    ++map_generation;
+}
+
 void System::raiseInterrupt(irq_source_t source)
 {
     irq_states[source] = true;
@@ -63,25 +63,87 @@ class System {
 
         MemoryPage memory[kNumPages];
 
+        // Extra CPU cycles charged for each access to a memory page (or
+        // the I/O page), modelling the FPI slowing the CPU down to 1 MHz
+        // whenever it has to go through the Mega II. See setSlowAccessStall().
+        unsigned int access_stalls[kNumPages + 1];
+
+        // The stall charged for an access to the slow side
+        unsigned int slow_access_stall = 0;
+
+        // Incremented every time a physical page is written to, so that
+        // anything caching the contents of a page (such as the CPU's block
+        // cache) can tell when its copy has gone stale.
+        unsigned int page_versions[kNumPages];
+
         std::map<std::string, Device *> devices;
 
         Device *io_read[kPageSize];
         Device *io_write[kPageSize];
 
+        // I/O locations that can be polled without side effects
+        bool io_poll[kPageSize];
+
         Device *cop_handler[256];
         Device *wdm_handler[256];
 
+        // Devices doing high-level emulation of tool sets, indexed by
+        // tool set number
+        Device *tool_handler[256];
+
+        // The tool call whose return a tool handler is waiting for
+        Device *tool_return_handler = nullptr;
+        uint16_t tool_return_function;
+        uint16_t tool_return_sp;
+
+        // Device serving ProDOS 8 MLI calls itself
+        Device *mli_handler = nullptr;
+
+        // Device offered every GS/OS call, which may do some itself
+        Device *gsos_handler = nullptr;
+
         bool irq_states[16];
 
         void updateIRQ();
 
+        uint8_t ioRead(const uint8_t);
+
     public:
+        // Main entry point of the tool dispatcher
+        static constexpr uint32_t kToolDispatcher = 0xE10000;
+
+        static constexpr uint32_t kNoToolReturn = 0xFFFFFFFF;
+
+        // ProDOS 8 MLI entry point in bank 0
+        static constexpr uint16_t kMLIEntry = 0xBF00;
+
+        // GS/OS entry points for inline and stack-based calls, where
+        // calls are offered to the GS/OS handler (see setGSOSHandler())
+        static constexpr uint32_t kGSOSInline = 0xE100A8;
+        static constexpr uint32_t kGSOSStack  = 0xE100B0;
+
+        // Return address of the tool call being watched by a tool
+        // handler (see watchToolReturn()), or kNoToolReturn.
+        uint32_t tool_return = kNoToolReturn;
+
         vbls_t vbl_count = 0;
 
+        // Incremented whenever the memory maps are changed, so that cached
+        // translations of bank/address to memory pages can be revalidated.
+        unsigned int map_generation = 0;
+
         M65816::Processor *cpu;
 
+        // Counts of CPU accesses since the idle loop detector last looked
+        // at them, and a running hash of the values read from pollable
+        // I/O locations.
+        unsigned int cpu_writes = 0;
+        unsigned int volatile_io_reads = 0;
+        unsigned int poll_reads = 0;
+        uint32_t poll_signature = 0;
+
 #ifdef ENABLE_DEBUGGER
-        Debugger *debugger;
+        Debugger *debugger = nullptr;
 #endif
 
         System(const bool);
@@ -97,6 +159,8 @@ class System {
             this->debugger = dbg;
 
             dbg->attach(this);
+
+            ++map_generation;
         }
 #endif
 
@@ -118,24 +182,88 @@ class System {
             }
         }
 
+        // Called by the CPU just before a JSL to the tool dispatcher, with
+        // the function number from X and the address the call returns to.
+        // Returns true if a tool handler performed the call itself.
+        bool handleToolCall(const uint16_t function, const uint32_t return_ea)
+        {
+            if (Device *dev = tool_handler[function & 0xFF]) {
+                return dev->toolCall(function, return_ea);
+            }
+
+            return false;
+        }
+
+        // Called by the CPU when an RTL lands on tool_return
+        void handleToolReturn(const uint16_t sp)
+        {
+            // A recursive call returning to the same place
+            if (sp != tool_return_sp) return;
+
+            tool_return = kNoToolReturn;
+
+            tool_return_handler->toolReturn(tool_return_function);
+        }
+
+        // Called by the CPU just before a JSR to the ProDOS 8 MLI entry
+        // point in bank 0, with the address of the call's inline command
+        // byte. Returns true if the MLI handler performed the call itself.
+        bool handleMLICall(const uint16_t addr)
+        {
+            return mli_handler && mli_handler->mliCall(addr);
+        }
+
+        // Called by the CPU just before a JSL to one of the GS/OS entry
+        // points, with the address the call returns to (where the inline
+        // parameters of an inline call are). Returns true if the GS/OS
+        // handler performed the call itself.
+        bool handleGSOSCall(const bool stack_call, const uint32_t return_ea)
+        {
+            return gsos_handler && gsos_handler->gsosCall(stack_call, return_ea);
+        }
+
+        // Have Device::toolReturn() called once the tool call that was
+        // just passed to the device returns to return_ea, leaving the stack
+        // pointer at sp. Only one call can be watched at a time; returns
+        // false if one already is.
+        bool watchToolReturn(Device *device, const uint16_t function, const uint32_t return_ea, const uint16_t sp)
+        {
+            if (tool_return != kNoToolReturn) return false;
+
+            tool_return          = return_ea;
+            tool_return_handler  = device;
+            tool_return_function = function;
+            tool_return_sp       = sp;
+
+            return true;
+        }
+
         inline void mapRead(const unsigned int src_page, const unsigned int dst_page)
         {
             read_map[src_page] = dst_page;
+
+            ++map_generation;
         }
 
         inline void mapWrite(const unsigned int src_page, const unsigned int dst_page)
         {
             write_map[src_page] = dst_page;
+
+            ++map_generation;
         }
 
         inline void mapIO(const unsigned int src_page)
         {
             read_map[src_page] = write_map[src_page] = kIOPage;
+
+            ++map_generation;
         }
 
         inline void setShadowed(const unsigned int page, const bool isShadowed)
         {
             memory[page].swrite = isShadowed? memory[(page & 0x01FF) | 0xE000].write : nullptr;
+
+            ++map_generation;
         }
 
         inline void setIoRead(const unsigned int& offset, Device *device)
@@ -148,6 +276,11 @@ class System {
             io_write[offset] = device;
         }
 
+        inline void setIoPoll(const unsigned int& offset)
+        {
+            io_poll[offset] = true;
+        }
+
         inline void setCopHandler(const unsigned int& command, Device *device)
         {
             cop_handler[command] = device;
@@ -158,11 +291,115 @@ class System {
             wdm_handler[command] = device;
         }
 
+        inline void setToolHandler(const unsigned int& toolset, Device *device)
+        {
+            tool_handler[toolset] = device;
+        }
+
+        inline bool hasToolHandler(const unsigned int& toolset)
+        {
+            return tool_handler[toolset] != nullptr;
+        }
+
+        inline void setMLIHandler(Device *device)
+        {
+            mli_handler = device;
+        }
+
+        inline bool hasMLIHandler()
+        {
+            return mli_handler != nullptr;
+        }
+
+        inline void setGSOSHandler(Device *device)
+        {
+            gsos_handler = device;
+        }
+
+        inline bool hasGSOSHandler()
+        {
+            return gsos_handler != nullptr;
+        }
+
         MemoryPage& getPage(const unsigned int page)
         {
             return memory[page];
         }
 
+        // Returns the memory page that a CPU read from bank/address is
+        // currently mapped to.
+        inline unsigned int getReadPage(const uint8_t bank, const uint16_t address)
+        {
+            return read_map[(bank << 8) | (address >> 8)];
+        }
+
+        // Same as above, for a 24-bit linear address
+        inline unsigned int getReadPage(const uint32_t address)
+        {
+            return read_map[address >> 8];
+        }
+
+        // Returns a pointer to the contents of a memory page for reading, or
+        // nullptr if the page is the I/O page, is unmapped, or stalls the
+        // CPU (and so has to go through cpuRead() to be charged for).
+        inline const uint8_t *getReadPointer(const unsigned int page_no)
+        {
+            return (page_no == kIOPage) || access_stalls[page_no]? nullptr : memory[page_no].read;
+        }
+
+        // Returns the memory page that a CPU write to bank/address is
+        // currently mapped to.
+        inline unsigned int getWritePage(const uint8_t bank, const uint16_t address)
+        {
+            return write_map[(bank << 8) | (address >> 8)];
+        }
+
+        // Same as above, for a 24-bit linear address
+        inline unsigned int getWritePage(const uint32_t address)
+        {
+            return write_map[address >> 8];
+        }
+
+        // Returns a pointer to the contents of a memory page for writing, or
+        // nullptr if writes to the page have side effects (I/O, shadowing,
+        // or stalling the CPU) or are discarded, and so must go through
+        // cpuWrite().
+        inline uint8_t *getWritePointer(const unsigned int page_no)
+        {
+            if ((page_no == kIOPage) || access_stalls[page_no]) return nullptr;
+
+            return memory[page_no].swrite? nullptr : memory[page_no].write;
+        }
+
+        // Note that the CPU has changed a page through getWritePointer()
+        inline void touchPage(const unsigned int page_no)
+        {
+            ++page_versions[page_no];
+            ++cpu_writes;
+        }
+
+        // Returns true if page_no is the I/O page
+        inline bool isIOPage(const unsigned int page_no)
+        {
+            return page_no == kIOPage;
+        }
+
+        // Access a location on the I/O page. These do what cpuRead() and
+        // cpuWrite() do for an address the caller already knows is mapped
+        // to the I/O page, minus the debugger hooks.
+        uint8_t cpuIoRead(const uint8_t);
+        void cpuIoWrite(const uint8_t, const uint8_t);
+
+        // Set the number of cycles the CPU is stalled for on each access
+        // to slow memory or I/O (zero if the CPU itself is running at the
+        // slow speed).
+        void setSlowAccessStall(const unsigned int);
+
+        inline unsigned int getPageVersion(const unsigned int page_no)
+        {
+            return page_versions[page_no];
+        }
+
         uint8_t sysRead(const uint8_t, const uint16_t);
         void sysWrite(const uint8_t, const uint16_t, uint8_t);
 
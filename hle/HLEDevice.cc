@@ -0,0 +1,91 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#include "HLEDevice.h"
+
+#include "emulator/System.h"
+
+uint8_t HLEDevice::readByte(const uint32_t ea)
+{
+    // sysRead() can't be used on the I/O page
+    if (system->isIOPage(system->getReadPage(ea & 0xFFFFFF))) return 0;
+
+    return system->sysRead((ea >> 16) & 0xFF, ea & 0xFFFF);
+}
+
+uint16_t HLEDevice::readWord(const uint32_t ea)
+{
+    return readByte(ea) | (readByte(ea + 1) << 8);
+}
+
+uint32_t HLEDevice::readLong(const uint32_t ea)
+{
+    return readWord(ea) | (readWord(ea + 2) << 16);
+}
+
+void HLEDevice::writeByte(const uint32_t ea, const uint8_t val)
+{
+    if (system->isIOPage(system->getWritePage(ea & 0xFFFFFF))) return;
+
+    system->sysWrite((ea >> 16) & 0xFF, ea & 0xFFFF, val);
+}
+
+void HLEDevice::writeWord(const uint32_t ea, const uint16_t val)
+{
+    writeByte(ea, val & 0xFF);
+    writeByte(ea + 1, val >> 8);
+}
+
+void HLEDevice::writeLong(const uint32_t ea, const uint32_t val)
+{
+    writeWord(ea, val & 0xFFFF);
+    writeWord(ea + 2, val >> 16);
+}
+
+/**
+ * Returns true if a range of memory contains no I/O locations, so that
+ * it can be accessed directly.
+ */
+bool HLEDevice::isPlainMemory(const uint32_t start, const uint32_t length)
+{
+    if (!length || (start + length > 0x1000000)) return false;
+
+    for (uint32_t page = start >> 8 ; page <= (start + length - 1) >> 8 ; ++page) {
+        if (system->isIOPage(system->getReadPage(page << 8)) || system->isIOPage(system->getWritePage(page << 8))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+HLEDevice::Span HLEDevice::readSpan(const uint32_t start, const uint32_t length)
+{
+    Span span;
+
+    span.start = start;
+    span.bytes.resize(length);
+
+    for (uint32_t i = 0 ; i < length ; ++i) {
+        span.bytes[i] = system->sysRead((start + i) >> 16, (start + i) & 0xFFFF);
+    }
+
+    return span;
+}
+
+void HLEDevice::writeSpan(const Span& span)
+{
+    for (uint32_t i = 0 ; i < span.bytes.size() ; ++i) {
+        const uint32_t ea = span.start + i;
+
+        if (system->sysRead(ea >> 16, ea & 0xFFFF) != span.bytes[i]) {
+            system->sysWrite(ea >> 16, ea & 0xFFFF, span.bytes[i]);
+        }
+    }
+}
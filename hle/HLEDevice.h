@@ -0,0 +1,64 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef HLEDEVICE_H_
+#define HLEDEVICE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "emulator/Device.h"
+
+/**
+ * Base class for devices doing high-level emulation of system software,
+ * with helpers for working on guest memory directly. None of them go
+ * through the I/O page, which has to be left to the CPU.
+ */
+class HLEDevice : public Device {
+    protected:
+        // A run of bytes in memory along with their (new) contents
+        struct Span {
+            uint32_t start = 0;
+            std::vector<uint8_t> bytes;
+        };
+
+        std::vector<unsigned int>& ioReadList()
+        {
+            static std::vector<unsigned int> locs;
+
+            return locs;
+        }
+
+        std::vector<unsigned int>& ioWriteList()
+        {
+            static std::vector<unsigned int> locs;
+
+            return locs;
+        }
+
+        uint8_t  readByte(const uint32_t);
+        uint16_t readWord(const uint32_t);
+        uint32_t readLong(const uint32_t);
+        void     writeByte(const uint32_t, const uint8_t);
+        void     writeWord(const uint32_t, const uint16_t);
+        void     writeLong(const uint32_t, const uint32_t);
+
+        bool isPlainMemory(const uint32_t, const uint32_t);
+        Span readSpan(const uint32_t, const uint32_t);
+        void writeSpan(const Span&);
+
+    public:
+        HLEDevice() = default;
+        virtual ~HLEDevice() = default;
+
+        uint8_t read(const unsigned int&) { return 0; }
+        void write(const unsigned int&, const uint8_t&) {}
+};
+
+#endif // HLEDEVICE_H_
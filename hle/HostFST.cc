@@ -0,0 +1,891 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+/*
+ * This class passes GS/OS file calls on full pathnames under a host
+ * directory through to the host. It is not a File System Translator: the
+ * CPU offers it every JSL to the GS/OS inline and stack-based entry
+ * points; class 1 calls naming a full path that starts with the
+ * configured name (":Host:..." or "/Host/..."), or a reference number
+ * for a file opened that way, are done here and everything else is
+ * passed on to GS/OS untouched.
+ *
+ * Supported are Create, Destroy, SetFileInfo, GetFileInfo, Open, Read,
+ * Write, Close, Flush, SetMark, GetMark, SetEOF, GetEOF and GetDirEntry.
+ * GS/OS resolves partial pathnames and prefixes itself, so those never
+ * reach this class. To cover them the emulator also mounts a read-only
+ * snapshot of the directory under the same name on a Smartport unit (see
+ * HostVolume), which GS/OS reads through its ProDOS FST. That puts the
+ * volume in GS/OS's device and volume lists, where the Finder, Standard
+ * File, Volume and DInfo find it, and gives prefixes and partial paths
+ * something to resolve against. Calls naming a full path still come here,
+ * so they reach the live directory and can write to it.
+ *
+ * A file's data fork is the host file itself. Its resource fork, if it
+ * has one, is kept in a "name#rsrc" file next to it, and its access,
+ * file type and aux type in a "name#info" text file such as:
+ *
+ *   filetype=$B3
+ *   auxtype=$DB07
+ *   access=$C3
+ *
+ * Files without an info file are BIN files that can be read, written,
+ * renamed, and destroyed, unless the host won't let them be written.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+#include <boost/format.hpp>
+
+#if __has_include(<filesystem>)
+    #include <filesystem>
+    namespace fs = std::filesystem;
+#else
+    #include <experimental/filesystem>
+    namespace fs = std::experimental::filesystem;
+#endif
+
+#include "HostFST.h"
+
+#include "emulator/System.h"
+#include "M65816/Processor.h"
+
+using std::string;
+using std::vector;
+
+static bool sameName(const string& a, const string& b)
+{
+    return (a.length() == b.length())
+        && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::toupper(static_cast<unsigned char>(x)) == std::toupper(static_cast<unsigned char>(y));
+           });
+}
+
+static bool endsWith(const string& s, const string& suffix)
+{
+    return (s.length() >= suffix.length()) && !s.compare(s.length() - suffix.length(), suffix.length(), suffix);
+}
+
+static uint32_t hostSize(const string& path)
+{
+    std::error_code ec;
+    const std::uintmax_t size = fs::file_size(path, ec);
+
+    return ec? 0 : std::min<std::uintmax_t>(size, 0xFFFFFFFF);
+}
+
+bool HostFST::isValidName(const string& name)
+{
+    if (name.empty() || (name.length() > 255) || (name == ".") || (name == "..")) return false;
+
+    if (endsWith(name, kResourceSuffix) || endsWith(name, kInfoSuffix)) return false;
+
+    return name.find_first_of(":/") == string::npos;
+}
+
+void HostFST::reset()
+{
+    for (OpenFile& file : files) {
+        closeFile(file);
+    }
+}
+
+void HostFST::attach(System *theSystem)
+{
+    Device::attach(theSystem);
+
+    system->setGSOSHandler(this);
+}
+
+/**
+ * Split the pathname in the GS/OS string at addr into the names below the
+ * host volume. Returns false if the path isn't on the host volume.
+ */
+bool HostFST::resolve(const uint32_t addr, vector<string>& components)
+{
+    const unsigned int length = readWord(addr);
+    string path;
+
+    for (unsigned int i = 0 ; i < length ; ++i) {
+        path += static_cast<char>(readByte(addr + 2 + i));
+    }
+
+    if (path.empty() || ((path[0] != ':') && (path[0] != '/'))) return false;
+
+    const char separator = path[0];
+    vector<string> names;
+    size_t pos = 1;
+
+    while (pos < path.length()) {
+        size_t end = path.find(separator, pos);
+
+        if (end == string::npos) end = path.length();
+        if (end > pos) names.push_back(path.substr(pos, end - pos));
+
+        pos = end + 1;
+    }
+
+    if (names.empty() || !sameName(names[0], volume)) return false;
+
+    components.assign(names.begin() + 1, names.end());
+
+    return true;
+}
+
+/**
+ * Find the host file for a path on the host volume.
+ */
+int HostFST::hostPath(const vector<string>& components, string& result)
+{
+    fs::path p(host_dir);
+
+    for (size_t i = 0 ; i < components.size() ; ++i) {
+        const bool last = (i + 1) == components.size();
+        std::error_code ec;
+        bool found = false;
+
+        if (!isValidName(components[i])) return kBadPath;
+
+        for (const fs::directory_entry& entry : fs::directory_iterator(p, ec)) {
+            if (sameName(entry.path().filename().string(), components[i])) {
+                p = entry.path();
+                found = true;
+
+                break;
+            }
+        }
+
+        if (!found) return last? kFileNotFound : kPathNotFound;
+
+        if (!last && !fs::is_directory(p, ec)) return kPathNotFound;
+    }
+
+    result = p.string();
+
+    return kNoError;
+}
+
+HostFST::FileInfo HostFST::readInfo(const string& path)
+{
+    std::error_code ec;
+    const fs::file_status status = fs::status(path, ec);
+    FileInfo info = { 0xC3, static_cast<uint16_t>(fs::is_directory(status)? 0x0F : 0x06), 0 };
+
+    std::ifstream in(path + kInfoSuffix);
+    string line;
+
+    while (std::getline(in, line)) {
+        unsigned int v;
+
+        if (std::sscanf(line.c_str(), "filetype=$%x", &v) == 1) {
+            info.file_type = v;
+        }
+        else if (std::sscanf(line.c_str(), "auxtype=$%x", &v) == 1) {
+            info.aux_type = v;
+        }
+        else if (std::sscanf(line.c_str(), "access=$%x", &v) == 1) {
+            info.access = v;
+        }
+    }
+
+    // Anything the host won't let us change is locked
+    if ((status.permissions() & fs::perms::owner_write) == fs::perms::none) {
+        info.access &= ~0xC2;
+    }
+
+    return info;
+}
+
+void HostFST::writeInfo(const string& path, const FileInfo& info)
+{
+    std::ofstream out(path + kInfoSuffix);
+
+    out << boost::format("filetype=$%02X\nauxtype=$%04X\naccess=$%02X\n") % info.file_type % info.aux_type % info.access;
+}
+
+HostFST::Description HostFST::describe(const string& path, const bool is_volume)
+{
+    Description desc;
+    std::error_code ec;
+
+    desc.info = readInfo(path);
+
+    if (fs::is_directory(path, ec)) {
+        desc.storage_type    = is_volume? 0x0F : 0x0D;
+        desc.extended        = false;
+        desc.eof             = 512;
+        desc.blocks          = 1;
+        desc.resource_eof    = 0;
+        desc.resource_blocks = 0;
+    }
+    else {
+        desc.eof      = hostSize(path);
+        desc.blocks   = (desc.eof + 511) / 512;
+        desc.extended = fs::exists(path + kResourceSuffix, ec);
+
+        desc.resource_eof    = desc.extended? hostSize(path + kResourceSuffix) : 0;
+        desc.resource_blocks = (desc.resource_eof + 511) / 512;
+
+        if (desc.extended) {
+            desc.storage_type = 0x05;
+        }
+        else if (desc.eof <= 512) {
+            desc.storage_type = 0x01;   // seedling
+        }
+        else if (desc.eof <= 131072) {
+            desc.storage_type = 0x02;   // sapling
+        }
+        else {
+            desc.storage_type = 0x03;   // tree
+        }
+    }
+
+    return desc;
+}
+
+/**
+ * Returns the names of the files in a host directory that are visible on
+ * the host volume, in order.
+ */
+vector<string> HostFST::listDirectory(const string& path)
+{
+    vector<string> names;
+    std::error_code ec;
+
+    for (const fs::directory_entry& entry : fs::directory_iterator(path, ec)) {
+        const string name = entry.path().filename().string();
+
+        if (isValidName(name)) names.push_back(name);
+    }
+
+    std::sort(names.begin(), names.end());
+
+    return names;
+}
+
+/**
+ * Write the modification time of a host file in the eight-byte format
+ * returned by ReadTimeHex.
+ */
+void HostFST::writeTime(const uint32_t ea, const string& path)
+{
+    using namespace std::chrono;
+
+    std::error_code ec;
+    const fs::file_time_type ftime = fs::last_write_time(path, ec);
+
+    if (ec) {
+        for (unsigned int i = 0 ; i < 8 ; ++i) writeByte(ea + i, 0);
+
+        return;
+    }
+
+    const auto sys_time = time_point_cast<system_clock::duration>(ftime - fs::file_time_type::clock::now() + system_clock::now());
+    const std::time_t t = system_clock::to_time_t(sys_time);
+    const std::tm *tm   = std::localtime(&t);
+
+    writeByte(ea,     tm->tm_sec);
+    writeByte(ea + 1, tm->tm_min);
+    writeByte(ea + 2, tm->tm_hour);
+    writeByte(ea + 3, tm->tm_year);
+    writeByte(ea + 4, tm->tm_mday - 1);
+    writeByte(ea + 5, tm->tm_mon);
+    writeByte(ea + 6, 0);
+    writeByte(ea + 7, tm->tm_wday + 1);
+}
+
+/**
+ * Return a string in a GS/OS result buffer, which starts with its size.
+ */
+int HostFST::writeResult(const uint32_t ea, const string& str)
+{
+    if (!ea) return kNoError;
+
+    writeWord(ea + 2, str.length());
+
+    if (readWord(ea) < str.length() + 4) return kBufferTooSmall;
+
+    for (unsigned int i = 0 ; i < str.length() ; ++i) {
+        writeByte(ea + 4 + i, str[i]);
+    }
+
+    return kNoError;
+}
+
+// There's no FST-specific information to put in an option list
+void HostFST::writeOptionList(const uint32_t ea)
+{
+    if (ea && (readWord(ea) >= 4)) writeWord(ea + 2, 0);
+}
+
+/**
+ * Look up the open file for a call taking a reference number. Returns
+ * kNotMine if the reference number isn't one of ours.
+ */
+int HostFST::checkRef(const uint32_t params, const unsigned int min_count, const unsigned int max_count, OpenFile *& file)
+{
+    const uint16_t ref = readWord(params + 2);
+
+    if ((ref < kFirstRefNum) || (ref >= kFirstRefNum + kMaxFiles)) return kNotMine;
+
+    const unsigned int count = readWord(params);
+
+    if ((count < min_count) || (count > max_count)) return kBadParamCount;
+
+    file = &files[ref - kFirstRefNum];
+
+    return file->open? kNoError : kBadRefNum;
+}
+
+void HostFST::closeFile(OpenFile& file)
+{
+    if (file.open) {
+        if (file.stream.is_open()) file.stream.close();
+
+        file.entries.clear();
+        file.open = false;
+    }
+}
+
+uint32_t HostFST::fileEOF(OpenFile& file)
+{
+    file.stream.flush();
+
+    return hostSize(file.forkPath());
+}
+
+/**
+ * Work out the position a SetMark or SetEOF call asks for.
+ */
+static int newPosition(const uint16_t base, const uint32_t displacement, const uint32_t mark, const uint32_t eof, uint32_t& pos)
+{
+    switch (base) {
+        case 0: pos = displacement;                      break;
+        case 1: pos = eof - displacement;   if (displacement > eof) return 0x4D; break;
+        case 2: pos = mark + displacement;  if (pos < mark) return 0x4D;         break;
+        case 3: pos = mark - displacement;  if (displacement > mark) return 0x4D; break;
+        default: return 0x53;
+    }
+
+    return 0;
+}
+
+int HostFST::create(const uint32_t params)
+{
+    vector<string> components;
+    string parent;
+
+    if (!resolve(readLong(params + 2) & 0xFFFFFF, components)) return kNotMine;
+
+    const unsigned int count = readWord(params);
+
+    if ((count < 1) || (count > 7)) return kBadParamCount;
+
+    if (components.empty()) return kDuplicate;
+
+    const string name = components.back();
+
+    components.pop_back();
+
+    if (const int err = hostPath(components, parent)) return (err == kFileNotFound)? kPathNotFound : err;
+
+    if (!isValidName(name)) return kBadPath;
+
+    for (const string& existing : listDirectory(parent)) {
+        if (sameName(existing, name)) return kDuplicate;
+    }
+
+    const string path = (fs::path(parent) / name).string();
+    FileInfo info = { 0xC3, 0x06, 0 };
+
+    if (count >= 2) info.access    = readWord(params + 0x06);
+    if (count >= 3) info.file_type = readWord(params + 0x08);
+    if (count >= 4) info.aux_type  = readLong(params + 0x0A);
+
+    const uint16_t storage_type = (count >= 5)? readWord(params + 0x0E) : ((info.file_type == 0x0F)? 0x0D : 0x01);
+    std::error_code ec;
+
+    if (storage_type == 0x0D) {
+        if (!fs::create_directory(path, ec)) return kIOError;
+    }
+    else {
+        if (!std::ofstream(path)) return kIOError;
+
+        if (count >= 6) fs::resize_file(path, readLong(params + 0x10), ec);
+
+        if (storage_type == 0x05) {
+            if (!std::ofstream(path + kResourceSuffix)) return kIOError;
+
+            if (count >= 7) fs::resize_file(path + kResourceSuffix, readLong(params + 0x14), ec);
+        }
+
+        if (ec) return kIOError;
+    }
+
+    if (count >= 2) writeInfo(path, info);
+
+    return kNoError;
+}
+
+int HostFST::destroy(const uint32_t params)
+{
+    vector<string> components;
+    string path;
+
+    if (!resolve(readLong(params + 2) & 0xFFFFFF, components)) return kNotMine;
+
+    if (readWord(params) != 1) return kBadParamCount;
+
+    if (const int err = hostPath(components, path)) return err;
+
+    if (components.empty() || !(readInfo(path).access & 0x80)) return kAccessError;
+
+    for (const OpenFile& file : files) {
+        if (file.open && (file.path == path)) return kFileBusy;
+    }
+
+    std::error_code ec;
+
+    // A directory has to be empty
+    if (!fs::remove(path, ec)) return kAccessError;
+
+    fs::remove(path + kResourceSuffix, ec);
+    fs::remove(path + kInfoSuffix, ec);
+
+    return kNoError;
+}
+
+int HostFST::setFileInfo(const uint32_t params)
+{
+    vector<string> components;
+    string path;
+
+    if (!resolve(readLong(params + 2) & 0xFFFFFF, components)) return kNotMine;
+
+    const unsigned int count = readWord(params);
+
+    if ((count < 2) || (count > 12)) return kBadParamCount;
+
+    if (const int err = hostPath(components, path)) return err;
+
+    FileInfo info = readInfo(path);
+
+    info.access = readWord(params + 0x06);
+
+    if (count >= 3) info.file_type = readWord(params + 0x08);
+    if (count >= 4) info.aux_type  = readLong(params + 0x0A);
+
+    writeInfo(path, info);
+
+    return kNoError;
+}
+
+int HostFST::getFileInfo(const uint32_t params)
+{
+    vector<string> components;
+    string path;
+
+    if (!resolve(readLong(params + 2) & 0xFFFFFF, components)) return kNotMine;
+
+    const unsigned int count = readWord(params);
+
+    if ((count < 2) || (count > 12)) return kBadParamCount;
+
+    if (const int err = hostPath(components, path)) return err;
+
+    const Description desc = describe(path, components.empty());
+
+    writeWord(params + 0x06, desc.info.access);
+
+    if (count >= 3)  writeWord(params + 0x08, desc.info.file_type);
+    if (count >= 4)  writeLong(params + 0x0A, desc.info.aux_type);
+    if (count >= 5)  writeWord(params + 0x0E, desc.storage_type);
+    if (count >= 6)  writeTime(params + 0x10, path);
+    if (count >= 7)  writeTime(params + 0x18, path);
+    if (count >= 8)  writeOptionList(readLong(params + 0x20) & 0xFFFFFF);
+    if (count >= 9)  writeLong(params + 0x24, desc.eof);
+    if (count >= 10) writeLong(params + 0x28, desc.blocks);
+    if (count >= 11) writeLong(params + 0x2C, desc.resource_eof);
+    if (count >= 12) writeLong(params + 0x30, desc.resource_blocks);
+
+    return kNoError;
+}
+
+int HostFST::openFile(const uint32_t params)
+{
+    vector<string> components;
+    string path;
+
+    if (!resolve(readLong(params + 4) & 0xFFFFFF, components)) return kNotMine;
+
+    const unsigned int count = readWord(params);
+
+    if ((count < 2) || (count > 15)) return kBadParamCount;
+
+    if (const int err = hostPath(components, path)) return err;
+
+    const uint16_t request = (count >= 3)? readWord(params + 0x08) : 0;
+    const uint16_t fork    = (count >= 4)? readWord(params + 0x0A) : 0;
+
+    const Description desc = describe(path, components.empty());
+    std::error_code ec;
+
+    if ((request > 3) || (fork > 1)) return kBadParam;
+
+    if (fork && !desc.extended) return kBadStorage;
+
+    OpenFile *file = std::find_if(std::begin(files), std::end(files), [](const OpenFile& f) { return !f.open; });
+
+    if (file == std::end(files)) return kFCBFull;
+
+    file->path      = path;
+    file->fork      = fork;
+    file->directory = fs::is_directory(path, ec);
+    file->mark      = 0;
+    file->entry     = 0;
+
+    // Reading or writing is only allowed if asked for (or, with no
+    // request, if the access bits let it).
+    file->readable = (request & 0x01) || !request;
+    file->writable = (request & 0x02) || (!request && (desc.info.access & 0x02) && !file->directory);
+
+    if ((file->readable && !(desc.info.access & 0x01)) || (file->writable && !(desc.info.access & 0x02))) {
+        return kAccessError;
+    }
+
+    if (file->directory) {
+        if (file->writable) return kAccessError;
+
+        file->entries = listDirectory(path);
+    }
+    else {
+        for (const OpenFile& other : files) {
+            if (other.open && (other.forkPath() == file->forkPath()) && (other.writable || file->writable)) {
+                return kFileBusy;
+            }
+        }
+
+        std::ios::openmode mode = std::fstream::binary;
+
+        if (file->readable) mode |= std::fstream::in;
+        if (file->writable) mode |= std::fstream::in | std::fstream::out;
+
+        file->stream.open(file->forkPath(), mode);
+
+        if (file->stream.fail()) {
+            file->stream.clear();
+
+            return kIOError;
+        }
+    }
+
+    file->open = true;
+
+    writeWord(params + 0x02, kFirstRefNum + (file - files));
+
+    if (count >= 5)  writeWord(params + 0x0C, desc.info.access);
+    if (count >= 6)  writeWord(params + 0x0E, desc.info.file_type);
+    if (count >= 7)  writeLong(params + 0x10, desc.info.aux_type);
+    if (count >= 8)  writeWord(params + 0x14, desc.storage_type);
+    if (count >= 9)  writeTime(params + 0x16, path);
+    if (count >= 10) writeTime(params + 0x1E, path);
+    if (count >= 11) writeOptionList(readLong(params + 0x26) & 0xFFFFFF);
+    if (count >= 12) writeLong(params + 0x2A, desc.eof);
+    if (count >= 13) writeLong(params + 0x2E, desc.blocks);
+    if (count >= 14) writeLong(params + 0x32, desc.resource_eof);
+    if (count >= 15) writeLong(params + 0x36, desc.resource_blocks);
+
+    return kNoError;
+}
+
+int HostFST::readFile(const uint32_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 4, 5, file)) return err;
+
+    const uint32_t buffer  = readLong(params + 0x04) & 0xFFFFFF;
+    const uint32_t request = readLong(params + 0x08);
+
+    writeLong(params + 0x0C, 0);
+
+    if (file->directory || !file->readable) return kAccessError;
+
+    if (request && !isPlainMemory(buffer, request)) return kBadParam;
+
+    Span span;
+
+    span.start = buffer;
+    span.bytes.resize(request);
+
+    file->stream.clear();
+    file->stream.seekg(file->mark);
+    file->stream.read(reinterpret_cast<char *>(span.bytes.data()), request);
+
+    if (file->stream.bad()) return kIOError;
+
+    span.bytes.resize(file->stream.gcount());
+
+    if (request && span.bytes.empty()) return kEndOfFile;
+
+    writeSpan(span);
+
+    file->mark += span.bytes.size();
+
+    writeLong(params + 0x0C, span.bytes.size());
+
+    return kNoError;
+}
+
+int HostFST::writeFile(const uint32_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 4, 5, file)) return err;
+
+    const uint32_t buffer  = readLong(params + 0x04) & 0xFFFFFF;
+    const uint32_t request = readLong(params + 0x08);
+
+    writeLong(params + 0x0C, 0);
+
+    if (file->directory || !file->writable) return kAccessError;
+
+    if (request && !isPlainMemory(buffer, request)) return kBadParam;
+
+    const Span span = readSpan(buffer, request);
+
+    file->stream.clear();
+    file->stream.seekp(file->mark);
+    file->stream.write(reinterpret_cast<const char *>(span.bytes.data()), request);
+
+    if (file->stream.fail()) return kIOError;
+
+    file->mark += request;
+
+    writeLong(params + 0x0C, request);
+
+    return kNoError;
+}
+
+int HostFST::close(const uint32_t params)
+{
+    // Closing everything closes our files too, but GS/OS still has to
+    // close its own.
+    if (!readWord(params + 2)) {
+        for (OpenFile& file : files) {
+            closeFile(file);
+        }
+
+        return kNotMine;
+    }
+
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 1, 1, file)) return err;
+
+    closeFile(*file);
+
+    return kNoError;
+}
+
+int HostFST::flush(const uint32_t params)
+{
+    if (!readWord(params + 2)) {
+        for (OpenFile& file : files) {
+            if (file.open) file.stream.flush();
+        }
+
+        return kNotMine;
+    }
+
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 1, 2, file)) return err;
+
+    if (!file->directory) file->stream.flush();
+
+    return file->stream.fail()? kIOError : kNoError;
+}
+
+int HostFST::setMark(const uint32_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 3, 3, file)) return err;
+
+    if (file->directory) return kBadStorage;
+
+    const uint32_t eof = fileEOF(*file);
+    uint32_t mark;
+
+    if (const int err = newPosition(readWord(params + 0x04), readLong(params + 0x06), file->mark, eof, mark)) return err;
+
+    if (mark > eof) return kOutOfRange;
+
+    file->mark = mark;
+
+    return kNoError;
+}
+
+int HostFST::getMark(const uint32_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 2, 2, file)) return err;
+
+    if (file->directory) return kBadStorage;
+
+    writeLong(params + 0x04, file->mark);
+
+    return kNoError;
+}
+
+int HostFST::setEOF(const uint32_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 3, 3, file)) return err;
+
+    if (file->directory || !file->writable) return kAccessError;
+
+    uint32_t eof;
+
+    if (const int err = newPosition(readWord(params + 0x04), readLong(params + 0x06), file->mark, fileEOF(*file), eof)) return err;
+
+    std::error_code ec;
+
+    fs::resize_file(file->forkPath(), eof, ec);
+
+    if (ec) return kIOError;
+
+    file->mark = std::min(file->mark, eof);
+
+    return kNoError;
+}
+
+int HostFST::getEOF(const uint32_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 2, 2, file)) return err;
+
+    if (file->directory) return kBadStorage;
+
+    writeLong(params + 0x04, fileEOF(*file));
+
+    return kNoError;
+}
+
+int HostFST::getDirEntry(const uint32_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 5, 17, file)) return err;
+
+    if (!file->directory) return kBadStorage;
+
+    const unsigned int count        = readWord(params);
+    const uint16_t     base         = readWord(params + 0x06);
+    const uint16_t     displacement = readWord(params + 0x08);
+
+    // Asking for entry 0 gets the number of entries
+    if (!base && !displacement) {
+        if (count >= 6) writeWord(params + 0x0E, file->entries.size());
+
+        return kNoError;
+    }
+
+    int n;
+
+    switch (base) {
+        case 0:  n = displacement;               break;
+        case 1:  n = file->entry + displacement; break;
+        case 2:  n = file->entry - displacement; break;
+        default: return kBadParam;
+    }
+
+    if ((n < 1) || (n > static_cast<int>(file->entries.size()))) return kEndOfDir;
+
+    file->entry = n;
+
+    const string& name = file->entries[n - 1];
+    const string  path = (fs::path(file->path) / name).string();
+    const Description desc = describe(path, false);
+
+    writeWord(params + 0x04, desc.extended? 0x8000 : 0);
+
+    const int error = writeResult(readLong(params + 0x0A) & 0xFFFFFF, name);
+
+    if (count >= 6)  writeWord(params + 0x0E, n);
+    if (count >= 7)  writeWord(params + 0x10, desc.info.file_type);
+    if (count >= 8)  writeLong(params + 0x12, desc.eof);
+    if (count >= 9)  writeLong(params + 0x16, desc.blocks);
+    if (count >= 10) writeTime(params + 0x1A, path);
+    if (count >= 11) writeTime(params + 0x22, path);
+    if (count >= 12) writeWord(params + 0x2A, desc.info.access);
+    if (count >= 13) writeLong(params + 0x2C, desc.info.aux_type);
+    if (count >= 14) writeWord(params + 0x30, kFileSysID);
+    if (count >= 15) writeOptionList(readLong(params + 0x32) & 0xFFFFFF);
+    if (count >= 16) writeLong(params + 0x36, desc.resource_eof);
+    if (count >= 17) writeLong(params + 0x3A, desc.resource_blocks);
+
+    return error;
+}
+
+bool HostFST::gsosCall(const bool stack_call, const uint32_t return_ea)
+{
+    M65816::Processor *cpu = system->cpu;
+
+    // A stack-based call pushes the parameter block pointer and then the
+    // call number; an inline one has them after the JSL.
+    const uint32_t args   = stack_call? static_cast<uint16_t>(cpu->S.W + 1) : return_ea;
+    const uint16_t call   = readWord(args);
+    const uint32_t params = readLong(args + 2) & 0xFFFFFF;
+    int error;
+
+    switch (call) {
+        case kCreate:      error = create(params);      break;
+        case kDestroy:     error = destroy(params);     break;
+        case kSetFileInfo: error = setFileInfo(params); break;
+        case kGetFileInfo: error = getFileInfo(params); break;
+        case kOpen:        error = openFile(params);    break;
+        case kRead:        error = readFile(params);    break;
+        case kWrite:       error = writeFile(params);   break;
+        case kClose:       error = close(params);       break;
+        case kFlush:       error = flush(params);       break;
+        case kSetMark:     error = setMark(params);     break;
+        case kGetMark:     error = getMark(params);     break;
+        case kSetEOF:      error = setEOF(params);      break;
+        case kGetEOF:      error = getEOF(params);      break;
+        case kGetDirEntry: error = getDirEntry(params); break;
+        default:           return false;
+    }
+
+    if (error == kNotMine) return false;
+
+    cpu->A.W  = error;
+    cpu->SR.C = error != kNoError;
+    cpu->SR.setN(false);
+    cpu->SR.setZ(error == kNoError);
+
+    if (stack_call) {
+        cpu->S.W += 6;
+    }
+    else {
+        cpu->PC += 6;
+    }
+
+    ++calls_handled;
+
+    return true;
+}
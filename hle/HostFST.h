@@ -0,0 +1,172 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef HOSTFST_H_
+#define HOSTFST_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "HLEDevice.h"
+
+/**
+ * Passes GS/OS file calls on full pathnames under one name through to a
+ * directory on the host. GS/OS itself only sees the directory through the
+ * read-only HostVolume mounted alongside it; calls for anything else,
+ * including partial paths, are left to GS/OS.
+ */
+class HostFST : public HLEDevice {
+    public:
+        // Suffixes of the sidecar files holding a file's resource fork
+        // and its GS/OS file information
+        static constexpr const char *kResourceSuffix = "#rsrc";
+        static constexpr const char *kInfoSuffix     = "#info";
+
+        struct FileInfo {
+            uint16_t access;
+            uint16_t file_type;
+            uint32_t aux_type;
+        };
+
+    private:
+        // GS/OS (class 1) calls
+        static constexpr uint16_t kCreate      = 0x2001;
+        static constexpr uint16_t kDestroy     = 0x2002;
+        static constexpr uint16_t kSetFileInfo = 0x2005;
+        static constexpr uint16_t kGetFileInfo = 0x2006;
+        static constexpr uint16_t kOpen        = 0x2010;
+        static constexpr uint16_t kRead        = 0x2012;
+        static constexpr uint16_t kWrite       = 0x2013;
+        static constexpr uint16_t kClose       = 0x2014;
+        static constexpr uint16_t kFlush       = 0x2015;
+        static constexpr uint16_t kSetMark     = 0x2016;
+        static constexpr uint16_t kGetMark     = 0x2017;
+        static constexpr uint16_t kSetEOF      = 0x2018;
+        static constexpr uint16_t kGetEOF      = 0x2019;
+        static constexpr uint16_t kGetDirEntry = 0x201C;
+
+        // GS/OS error codes
+        static constexpr int kNoError       = 0x0000;
+        static constexpr int kBadParamCount = 0x0004;
+        static constexpr int kIOError       = 0x0027;
+        static constexpr int kBadPath       = 0x0040;
+        static constexpr int kFCBFull       = 0x0042;
+        static constexpr int kBadRefNum     = 0x0043;
+        static constexpr int kPathNotFound  = 0x0044;
+        static constexpr int kFileNotFound  = 0x0046;
+        static constexpr int kDuplicate     = 0x0047;
+        static constexpr int kBadStorage    = 0x004B;
+        static constexpr int kEndOfFile     = 0x004C;
+        static constexpr int kOutOfRange    = 0x004D;
+        static constexpr int kAccessError   = 0x004E;
+        static constexpr int kBufferTooSmall = 0x004F;
+        static constexpr int kFileBusy      = 0x0050;
+        static constexpr int kBadParam      = 0x0053;
+        static constexpr int kEndOfDir      = 0x0061;
+
+        // Returned by the call handlers when a call is for GS/OS
+        static constexpr int kNotMine = -1;
+
+        // Reference numbers for host files, well clear of GS/OS's own
+        static constexpr uint16_t kFirstRefNum = 0x7F00;
+        static constexpr unsigned int kMaxFiles = 32;
+
+        // File system ID reported for the volume (AppleShare, the closest
+        // match for a host file system with long mixed-case names)
+        static constexpr uint16_t kFileSysID = 0x000D;
+
+        struct OpenFile {
+            bool         open = false;
+            bool         directory;
+            std::string  path;
+            std::fstream stream;
+            unsigned int fork;
+            bool         readable;
+            bool         writable;
+            uint32_t     mark;
+
+            // The names in a directory, and the entry last returned
+            std::vector<std::string> entries;
+            unsigned int entry;
+
+            // The host file holding the fork that's open
+            std::string forkPath() const { return fork? path + kResourceSuffix : path; }
+        };
+
+        // Everything GS/OS can be told about a file
+        struct Description {
+            FileInfo info;
+            uint16_t storage_type;
+            bool     extended;
+            uint32_t eof;
+            uint32_t blocks;
+            uint32_t resource_eof;
+            uint32_t resource_blocks;
+        };
+
+        const std::string host_dir;
+        const std::string volume;
+
+        OpenFile files[kMaxFiles];
+
+        unsigned long calls_handled = 0;
+
+        bool resolve(const uint32_t, std::vector<std::string>&);
+        int  hostPath(const std::vector<std::string>&, std::string&);
+
+        void writeInfo(const std::string&, const FileInfo&);
+        Description describe(const std::string&, const bool);
+        std::vector<std::string> listDirectory(const std::string&);
+
+        void writeTime(const uint32_t, const std::string&);
+        int  writeResult(const uint32_t, const std::string&);
+        void writeOptionList(const uint32_t);
+
+        int checkRef(const uint32_t, const unsigned int, const unsigned int, OpenFile *&);
+        void closeFile(OpenFile&);
+        uint32_t fileEOF(OpenFile&);
+
+        int create(const uint32_t);
+        int destroy(const uint32_t);
+        int setFileInfo(const uint32_t);
+        int getFileInfo(const uint32_t);
+        int openFile(const uint32_t);
+        int readFile(const uint32_t);
+        int writeFile(const uint32_t);
+        int close(const uint32_t);
+        int flush(const uint32_t);
+        int setMark(const uint32_t);
+        int getMark(const uint32_t);
+        int setEOF(const uint32_t);
+        int getEOF(const uint32_t);
+        int getDirEntry(const uint32_t);
+
+    public:
+        HostFST(const std::string& dir, const std::string& volume_name) : host_dir(dir), volume(volume_name) {}
+        ~HostFST() = default;
+
+        void reset();
+
+        void attach(System *theSystem);
+
+        bool gsosCall(const bool, const uint32_t);
+
+        unsigned long getCallsHandled() const { return calls_handled; }
+
+        // True if name can be used for a file or volume on the host volume
+        static bool isValidName(const std::string&);
+
+        // A host file's GS/OS file information, from its info file if it
+        // has one
+        static FileInfo readInfo(const std::string&);
+};
+
+#endif // HOSTFST_H_
@@ -0,0 +1,453 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+/*
+ * This class builds a ProDOS volume image in memory from a directory on
+ * the host, so that the directory can be mounted on a Smartport unit. GS/OS
+ * then sees it through its own ProDOS FST, which puts it in the volume
+ * list and makes it visible to the Finder, Standard File, prefixes, and
+ * partial pathnames, none of which HostFST's passthrough reaches.
+ *
+ * The image is a snapshot taken when the volume is opened (at startup),
+ * and it is write protected: files written through HostFST, or changed
+ * on the host, don't show up in it until the emulator is restarted.
+ *
+ * Host names are upper-cased, and files whose names still aren't valid
+ * ProDOS names, or that would clash with one already on the volume, are
+ * left off it, as are files too big for ProDOS and links to directories.
+ * File information and resource forks come from the same sidecar files
+ * HostFST uses; files with a resource fork become extended files.
+ *
+ * Every block of the image is in use, so its bitmap is all zeros.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+
+#if __has_include(<filesystem>)
+    #include <filesystem>
+    namespace fs = std::filesystem;
+#else
+    #include <experimental/filesystem>
+    namespace fs = std::experimental::filesystem;
+#endif
+
+#include "HostVolume.h"
+#include "HostFST.h"
+#include "ProDOS8.h"
+
+using std::string;
+using std::vector;
+
+// ProDOS can't hold files of 16 MB or more
+static const uint32_t kMaxEOF = 0xFFFFFF;
+
+static void putWord(uint8_t *p, const unsigned int w)
+{
+    p[0] = w;
+    p[1] = w >> 8;
+}
+
+static void putName(uint8_t *p, const uint8_t storage_type, const string& name)
+{
+    p[0] = (storage_type << 4) | name.length();
+
+    std::memcpy(p + 1, name.data(), name.length());
+}
+
+static void prodosDateTime(const string& path, uint16_t& date, uint16_t& time)
+{
+    using namespace std::chrono;
+
+    std::error_code ec;
+    const fs::file_time_type ftime = fs::last_write_time(path, ec);
+
+    if (ec) {
+        date = time = 0;
+
+        return;
+    }
+
+    const auto sys_time = time_point_cast<system_clock::duration>(ftime - fs::file_time_type::clock::now() + system_clock::now());
+    const std::time_t t = system_clock::to_time_t(sys_time);
+    const std::tm *tm   = std::localtime(&t);
+
+    date = ((tm->tm_year % 100) << 9) | ((tm->tm_mon + 1) << 5) | tm->tm_mday;
+    time = (tm->tm_hour << 8) | tm->tm_min;
+}
+
+static uint32_t hostSize(const string& path)
+{
+    std::error_code ec;
+    const std::uintmax_t size = fs::file_size(path, ec);
+
+    return ec? 0 : static_cast<uint32_t>(std::min<std::uintmax_t>(size, kMaxEOF + 1));
+}
+
+/**
+ * Read everything a host directory (or file) will put on the volume.
+ */
+HostVolume::Node HostVolume::scan(const string& path, const string& name)
+{
+    std::error_code ec;
+    const HostFST::FileInfo info = HostFST::readInfo(path);
+    Node node;
+
+    node.name      = name;
+    node.path      = path;
+    node.directory = fs::is_directory(path, ec);
+    node.access    = info.access;
+    node.file_type = node.directory? 0x0F : info.file_type;
+    node.aux_type  = node.directory? 0 : info.aux_type;
+    node.extended  = !node.directory && fs::exists(path + HostFST::kResourceSuffix, ec);
+
+    node.data_eof     = node.directory? 0 : hostSize(path);
+    node.resource_eof = node.extended? hostSize(path + HostFST::kResourceSuffix) : 0;
+
+    prodosDateTime(path, node.date, node.time);
+
+    if (!node.directory) return node;
+
+    std::set<string> names;
+
+    for (const fs::directory_entry& entry : fs::directory_iterator(path, ec)) {
+        const string host_name = entry.path().filename().string();
+        string prodos_name = host_name;
+
+        std::transform(prodos_name.begin(), prodos_name.end(), prodos_name.begin(),
+                       [](char c) { return std::toupper(static_cast<unsigned char>(c)); });
+
+        if (!HostFST::isValidName(host_name) || !ProDOS8HLE::isValidName(prodos_name) || names.count(prodos_name)) continue;
+
+        if (fs::is_directory(entry.path(), ec)) {
+            if (fs::is_symlink(entry.path(), ec)) continue;
+        }
+        else if (!fs::is_regular_file(entry.path(), ec) || (hostSize(entry.path().string()) > kMaxEOF)) {
+            continue;
+        }
+
+        names.insert(prodos_name);
+        node.children.push_back(scan(entry.path().string(), prodos_name));
+    }
+
+    std::sort(node.children.begin(), node.children.end(), [](const Node& a, const Node& b) { return a.name < b.name; });
+
+    return node;
+}
+
+/**
+ * Blocks used by a fork of eof bytes, including index blocks
+ */
+unsigned int HostVolume::forkBlocks(const uint32_t eof)
+{
+    const unsigned int data = std::max(1u, (eof + kBlockSize - 1) / kBlockSize);
+
+    if (data == 1) return 1;                            // seedling
+    if (data <= 256) return data + 1;                   // sapling
+
+    return data + (data + 255) / 256 + 1;               // tree
+}
+
+/**
+ * Blocks needed for a directory with entries files in it
+ */
+unsigned int HostVolume::dirBlocks(const unsigned int entries, const bool volume)
+{
+    // The header takes up the first entry
+    return std::max(volume? kVolumeDirBlocks : 1, (entries + 1 + kEntriesPerBlock - 1) / kEntriesPerBlock);
+}
+
+unsigned int HostVolume::blocksFor(const Node& node)
+{
+    if (!node.directory) {
+        return node.extended? 1 + forkBlocks(node.data_eof) + forkBlocks(node.resource_eof) : forkBlocks(node.data_eof);
+    }
+
+    unsigned int blocks = 0;
+
+    for (const Node& child : node.children) {
+        blocks += blocksFor(child);
+
+        if (child.directory) blocks += dirBlocks(child.children.size(), false);
+    }
+
+    return blocks;
+}
+
+uint16_t HostVolume::allocate(const unsigned int count)
+{
+    const uint16_t first = next_block;
+
+    if (next_block + count > num_chunks) {
+        throw std::runtime_error("Host volume layout overran its blocks");
+    }
+
+    next_block += count;
+
+    return first;
+}
+
+/**
+ * Lay out a fork as a seedling, sapling or tree file, returning its
+ * storage type, key block and the number of blocks it used.
+ */
+void HostVolume::writeFork(const vector<uint8_t>& data, uint8_t& storage_type, uint16_t& key_block, uint16_t& blocks_used)
+{
+    const unsigned int count = std::max<size_t>(1, (data.size() + kBlockSize - 1) / kBlockSize);
+
+    const auto copyBlock = [&](const unsigned int i) {
+        const uint16_t b = allocate(1);
+        const size_t offset = i * kBlockSize;
+
+        if (offset < data.size()) {
+            std::memcpy(block(b), data.data() + offset, std::min<size_t>(kBlockSize, data.size() - offset));
+        }
+
+        return b;
+    };
+
+    // Index blocks hold the low bytes of the block numbers in their first
+    // half and the high bytes in the second
+    const auto putIndex = [&](const uint16_t index, const unsigned int i, const uint16_t b) {
+        block(index)[i]       = b;
+        block(index)[i + 256] = b >> 8;
+    };
+
+    if (count == 1) {
+        storage_type = 0x01;
+        key_block    = copyBlock(0);
+        blocks_used  = 1;
+    }
+    else if (count <= 256) {
+        storage_type = 0x02;
+        key_block    = allocate(1);
+        blocks_used  = count + 1;
+
+        for (unsigned int i = 0 ; i < count ; ++i) putIndex(key_block, i, copyBlock(i));
+    }
+    else {
+        const unsigned int indexes = (count + 255) / 256;
+
+        storage_type = 0x03;
+        key_block    = allocate(1);
+        blocks_used  = count + indexes + 1;
+
+        for (unsigned int j = 0 ; j < indexes ; ++j) {
+            const uint16_t index = allocate(1);
+
+            putIndex(key_block, j, index);
+
+            for (unsigned int i = j * 256 ; i < std::min(count, (j + 1) * 256) ; ++i) {
+                putIndex(index, i % 256, copyBlock(i));
+            }
+        }
+    }
+}
+
+void HostVolume::writeFile(Node& node)
+{
+    const auto readFork = [](const string& path, const uint32_t eof) {
+        vector<uint8_t> data(eof);
+        std::ifstream in(path, std::ios::binary);
+
+        // Whatever can't be read (if the file has shrunk) stays zero
+        in.read(reinterpret_cast<char *>(data.data()), eof);
+
+        return data;
+    };
+
+    const vector<uint8_t> data = readFork(node.path, node.data_eof);
+
+    if (!node.extended) {
+        writeFork(data, node.storage_type, node.key_block, node.blocks_used);
+
+        node.eof = node.data_eof;
+
+        return;
+    }
+
+    // An extended file's key block describes its two forks, the data fork
+    // in the first half and the resource fork in the second
+    const vector<uint8_t> resource = readFork(node.path + HostFST::kResourceSuffix, node.resource_eof);
+    const uint16_t key = allocate(1);
+    uint16_t blocks = 1;
+
+    for (const unsigned int fork : { 0, 1 }) {
+        uint8_t *entry = block(key) + fork * 0x100;
+        const uint32_t eof = fork? node.resource_eof : node.data_eof;
+        uint8_t  storage_type;
+        uint16_t key_block, blocks_used;
+
+        writeFork(fork? resource : data, storage_type, key_block, blocks_used);
+
+        entry[0] = storage_type;
+        putWord(entry + 1, key_block);
+        putWord(entry + 3, blocks_used);
+        putWord(entry + 5, eof);
+        entry[7] = eof >> 16;
+
+        blocks += blocks_used;
+    }
+
+    node.storage_type = 0x05;
+    node.key_block    = key;
+    node.blocks_used  = blocks;
+    node.eof          = kBlockSize;
+}
+
+/**
+ * Write out a directory whose blocks have been allocated, along with
+ * everything in it. parent_block and parent_entry locate its entry in
+ * its parent, with parent_block 0 for the volume directory.
+ */
+void HostVolume::writeDirectory(Node& node, const uint16_t parent_block, const unsigned int parent_entry)
+{
+    const bool volume = !parent_block;
+
+    // Entry slot 0 is the header
+    const auto entryAt = [&](const unsigned int slot) {
+        return block(node.dir_blocks[slot / kEntriesPerBlock]) + 4 + (slot % kEntriesPerBlock) * kEntryLength;
+    };
+
+    for (unsigned int i = 0 ; i < node.children.size() ; ++i) {
+        Node& child = node.children[i];
+        const unsigned int slot = i + 1;
+
+        if (child.directory) {
+            const unsigned int blocks = dirBlocks(child.children.size(), false);
+            const uint16_t first = allocate(blocks);
+
+            for (unsigned int b = 0 ; b < blocks ; ++b) child.dir_blocks.push_back(first + b);
+
+            child.storage_type = 0x0D;
+            child.key_block    = first;
+            child.blocks_used  = blocks;
+            child.eof          = blocks * kBlockSize;
+
+            writeDirectory(child, node.dir_blocks[slot / kEntriesPerBlock], slot % kEntriesPerBlock + 1);
+        }
+        else {
+            writeFile(child);
+        }
+    }
+
+    for (unsigned int i = 0 ; i < node.dir_blocks.size() ; ++i) {
+        uint8_t *p = block(node.dir_blocks[i]);
+
+        putWord(p, i? node.dir_blocks[i - 1] : 0);
+        putWord(p + 2, (i + 1 < node.dir_blocks.size())? node.dir_blocks[i + 1] : 0);
+    }
+
+    uint8_t *header = entryAt(0);
+
+    putName(header, volume? 0x0F : 0x0E, node.name);
+
+    if (!volume) header[0x10] = 0x75;
+
+    putWord(header + 0x18, node.date);
+    putWord(header + 0x1A, node.time);
+    header[0x1E] = node.access;
+    header[0x1F] = kEntryLength;
+    header[0x20] = kEntriesPerBlock;
+    putWord(header + 0x21, node.children.size());
+
+    if (volume) {
+        putWord(header + 0x23, bitmap_block);
+        putWord(header + 0x25, num_chunks);
+    }
+    else {
+        putWord(header + 0x23, parent_block);
+        header[0x25] = parent_entry;
+        header[0x26] = kEntryLength;
+    }
+
+    for (unsigned int i = 0 ; i < node.children.size() ; ++i) {
+        const Node& child = node.children[i];
+        uint8_t *entry = entryAt(i + 1);
+
+        putName(entry, child.storage_type, child.name);
+
+        entry[0x10] = child.file_type;
+        putWord(entry + 0x11, child.key_block);
+        putWord(entry + 0x13, child.blocks_used);
+        putWord(entry + 0x15, child.eof);
+        entry[0x17] = child.eof >> 16;
+        putWord(entry + 0x18, child.date);
+        putWord(entry + 0x1A, child.time);
+        entry[0x1E] = child.access;
+        putWord(entry + 0x1F, child.aux_type);
+        putWord(entry + 0x21, child.date);
+        putWord(entry + 0x23, child.time);
+        putWord(entry + 0x25, node.dir_blocks[0]);
+    }
+}
+
+void HostVolume::open()
+{
+    std::error_code ec;
+
+    if (!fs::is_directory(host_dir, ec)) {
+        throw std::runtime_error("Host volume directory not found");
+    }
+
+    Node root = scan(host_dir, volume);
+
+    // Boot blocks, the volume directory, and everything in it, plus
+    // enough bitmap blocks to cover the lot
+    const unsigned int dir_blocks = dirBlocks(root.children.size(), true);
+    const unsigned int used = 2 + dir_blocks + blocksFor(root);
+    unsigned int bitmap_blocks = 1;
+
+    while (used + bitmap_blocks > bitmap_blocks * kBlockSize * 8) ++bitmap_blocks;
+
+    if (used + bitmap_blocks > kMaxBlocks) {
+        throw std::runtime_error("Host directory is too big for a ProDOS volume");
+    }
+
+    type       = RAW;
+    format     = PRODOS;
+    locked     = true;
+    chunk_size = kBlockSize;
+    num_chunks = used + bitmap_blocks;
+
+    image.assign(num_chunks * kBlockSize, 0);
+
+    next_block = 2;
+
+    for (unsigned int b = 0 ; b < dir_blocks ; ++b) root.dir_blocks.push_back(allocate(1));
+
+    bitmap_block = allocate(bitmap_blocks);
+
+    writeDirectory(root, 0, 0);
+}
+
+void HostVolume::close()
+{
+    vector<uint8_t>().swap(image);
+}
+
+void HostVolume::read(uint8_t *buffer, const unsigned int first_chunk, const unsigned int count)
+{
+    if ((first_chunk + count) > num_chunks) {
+        throw std::runtime_error("Error reading from host volume");
+    }
+
+    std::memcpy(buffer, block(first_chunk), count * kBlockSize);
+}
+
+void HostVolume::write(uint8_t *, const unsigned int, const unsigned int)
+{
+    throw std::runtime_error("Attempt to write to a locked disk");
+}
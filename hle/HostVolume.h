@@ -0,0 +1,88 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef HOSTVOLUME_H_
+#define HOSTVOLUME_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "disks/VirtualDisk.h"
+
+/**
+ * A read-only ProDOS block volume built from a directory on the host when
+ * it is opened, so that it can be mounted on a Smartport unit and show up
+ * in GS/OS like any other disk.
+ */
+class HostVolume : public VirtualDisk {
+    private:
+        static constexpr unsigned int kBlockSize       = 512;
+        static constexpr unsigned int kMaxBlocks       = 65535;
+        static constexpr unsigned int kEntryLength     = 0x27;
+        static constexpr unsigned int kEntriesPerBlock = 0x0D;
+        static constexpr unsigned int kVolumeDirBlocks = 4;
+
+        // A file or directory to go on the volume
+        struct Node {
+            std::string name;       // ProDOS name
+            std::string path;       // host path
+            bool        directory;
+            uint16_t    access;
+            uint8_t     file_type;
+            uint16_t    aux_type;
+            uint16_t    date;
+            uint16_t    time;
+            bool        extended;
+            uint32_t    data_eof;
+            uint32_t    resource_eof;
+
+            std::vector<Node> children;
+
+            // What its directory entry says about where it ended up
+            uint8_t  storage_type;
+            uint16_t key_block;
+            uint16_t blocks_used;
+            uint32_t eof;
+
+            // Blocks holding a directory, in order
+            std::vector<uint16_t> dir_blocks;
+        };
+
+        const std::string host_dir;
+        const std::string volume;
+
+        std::vector<uint8_t> image;
+        unsigned int next_block;
+        uint16_t bitmap_block;
+
+        Node scan(const std::string&, const std::string&);
+
+        static unsigned int forkBlocks(const uint32_t);
+        static unsigned int dirBlocks(const unsigned int, const bool);
+        static unsigned int blocksFor(const Node&);
+
+        uint8_t *block(const uint16_t b) { return image.data() + b * kBlockSize; }
+
+        uint16_t allocate(const unsigned int);
+        void writeFork(const std::vector<uint8_t>&, uint8_t&, uint16_t&, uint16_t&);
+        void writeFile(Node&);
+        void writeDirectory(Node&, const uint16_t, const unsigned int);
+
+    public:
+        HostVolume(const std::string& dir, const std::string& volume_name) : VirtualDisk(dir), host_dir(dir), volume(volume_name) {}
+        ~HostVolume() = default;
+
+        void open();
+        void close();
+        void read(uint8_t *, const unsigned int, const unsigned int);
+        void write(uint8_t *, const unsigned int, const unsigned int);
+};
+
+#endif // HOSTVOLUME_H_
@@ -0,0 +1,352 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+/*
+ * This class implements high-level emulation of the Integer Math tool set.
+ *
+ * The arithmetic (Multiply, SDivide, UDivide, LongMul, LongDivide), the
+ * Fixed and Frac math (FixRatio, FixMul, FracMul, FixDiv, FracDiv,
+ * FixRound and the conversions between Fixed, Frac and long integers),
+ * HiWord/LoWord, and the hex and decimal string conversions are done
+ * natively. Results have to match the ROM bit for bit, so a call is only
+ * done natively when its result is fully pinned down by the Toolbox
+ * Reference; the cases it leaves open are always passed to the ROM:
+ *
+ * - Multiply and LongMul when either input has its top bit set, since
+ *   the high half of the product depends on whether the inputs are
+ *   taken as signed.
+ * - Rounded results that fall exactly halfway between two values.
+ * - Anything that divides by zero, overflows, or doesn't fit in the
+ *   string it's going into, all of which the ROM reports as errors.
+ * - Negative numbers converted to signed decimal strings.
+ *
+ * As with the Memory Manager, calls are left alone if the tool set's
+ * entry for them no longer points into the ROM.
+ */
+
+#include <cstdlib>
+
+#include <boost/format.hpp>
+
+#include "IntegerMath.h"
+
+#include "emulator/System.h"
+#include "M65816/Processor.h"
+
+// Returns the name of a call done natively, or nullptr for the rest
+static const char *callName(const uint16_t function)
+{
+    switch (function) {
+        case 0x090B: return "Multiply";
+        case 0x0A0B: return "SDivide";
+        case 0x0B0B: return "UDivide";
+        case 0x0C0B: return "LongMul";
+        case 0x0D0B: return "LongDivide";
+        case 0x0E0B: return "FixRatio";
+        case 0x0F0B: return "FixMul";
+        case 0x100B: return "FracMul";
+        case 0x110B: return "FixDiv";
+        case 0x120B: return "FracDiv";
+        case 0x130B: return "FixRound";
+        case 0x180B: return "HiWord";
+        case 0x190B: return "LoWord";
+        case 0x1A0B: return "Long2Fix";
+        case 0x1B0B: return "Fix2Long";
+        case 0x1C0B: return "Fix2Frac";
+        case 0x1D0B: return "Frac2Fix";
+        case 0x220B: return "Int2Hex";
+        case 0x230B: return "Long2Hex";
+        case 0x260B: return "Int2Dec";
+        case 0x270B: return "Long2Dec";
+        default:     return nullptr;
+    }
+}
+
+/**
+ * Work out numerator * 2^shift / denominator rounded to the nearest long
+ * integer. All of the rounded Fixed and Frac results come down to this.
+ * Returns false if the result is a tie, overflows, or divides by zero.
+ */
+bool IntegerMathHLE::divide(const int64_t numerator, const int64_t denominator, const unsigned int shift, int32_t& result)
+{
+    if (!denominator) return false;
+
+    const int64_t n = numerator * (static_cast<int64_t>(1) << shift);
+    const int64_t d = std::llabs(denominator);
+    const int64_t r = std::llabs(n % denominator) * 2;
+    int64_t q = n / denominator;
+
+    if (r == d) return false;
+
+    if (r > d) q += ((n < 0) != (denominator < 0))? -1 : 1;
+
+    if ((q < INT32_MIN) || (q > INT32_MAX)) return false;
+
+    result = q;
+
+    return true;
+}
+
+/**
+ * Work out the result of putting digits right-justified in a string of
+ * length bytes at addr, padded on the left with pad.
+ */
+bool IntegerMathHLE::putString(const uint32_t addr, const unsigned int length, const std::string& digits, const char pad, std::vector<Span>& result)
+{
+    if (!length || (digits.length() > length) || !isPlainMemory(addr, length)) return false;
+
+    Span span;
+
+    span.start = addr;
+    span.bytes.assign(length - digits.length(), pad);
+    span.bytes.insert(span.bytes.end(), digits.begin(), digits.end());
+
+    result.push_back(std::move(span));
+
+    return true;
+}
+
+/**
+ * Work out what a call would leave in memory, and how many bytes of
+ * parameters it pulls off the stack. Returns false if the call isn't
+ * one that can be done natively.
+ */
+bool IntegerMathHLE::perform(const uint16_t function, std::vector<Span>& result, unsigned int& param_bytes)
+{
+    int32_t value;
+
+    switch (function) {
+        case kMultiply: {
+            const uint16_t multiplier   = readWord(stackAddress(1));
+            const uint16_t multiplicand = readWord(stackAddress(3));
+
+            if ((multiplier | multiplicand) & 0x8000) return false;
+
+            result.push_back(valueSpan(stackAddress(5), multiplicand * multiplier, 4));
+            param_bytes = 4;
+
+            return true;
+        }
+
+        case kSDivide: {
+            const int16_t denominator = readWord(stackAddress(1));
+            const int16_t numerator   = readWord(stackAddress(3));
+
+            if (!denominator || ((numerator == INT16_MIN) && (denominator == -1))) return false;
+
+            result.push_back(valueSpan(stackAddress(5), static_cast<uint16_t>(numerator / denominator), 2));
+            result.push_back(valueSpan(stackAddress(7), static_cast<uint16_t>(numerator % denominator), 2));
+            param_bytes = 4;
+
+            return true;
+        }
+
+        case kUDivide: {
+            const uint16_t denominator = readWord(stackAddress(1));
+            const uint16_t numerator   = readWord(stackAddress(3));
+
+            if (!denominator) return false;
+
+            result.push_back(valueSpan(stackAddress(5), numerator / denominator, 2));
+            result.push_back(valueSpan(stackAddress(7), numerator % denominator, 2));
+            param_bytes = 4;
+
+            return true;
+        }
+
+        case kLongMul: {
+            const uint64_t multiplier   = readLong(stackAddress(1));
+            const uint64_t multiplicand = readLong(stackAddress(5));
+
+            if ((multiplier | multiplicand) & 0x80000000) return false;
+
+            result.push_back(valueSpan(stackAddress(9), multiplicand * multiplier, 8));
+            param_bytes = 8;
+
+            return true;
+        }
+
+        case kLongDivide: {
+            const uint32_t denominator = readLong(stackAddress(1));
+            const uint32_t numerator   = readLong(stackAddress(5));
+
+            if (!denominator) return false;
+
+            result.push_back(valueSpan(stackAddress(9),  numerator / denominator, 4));
+            result.push_back(valueSpan(stackAddress(13), numerator % denominator, 4));
+            param_bytes = 8;
+
+            return true;
+        }
+
+        case kFixRatio: {
+            const int16_t denominator = readWord(stackAddress(1));
+            const int16_t numerator   = readWord(stackAddress(3));
+
+            if (!divide(numerator, denominator, 16, value)) return false;
+
+            result.push_back(valueSpan(stackAddress(5), static_cast<uint32_t>(value), 4));
+            param_bytes = 4;
+
+            return true;
+        }
+
+        // Fixed is 16.16 and Frac is 2.30, so products and quotients just
+        // differ in how far they're shifted
+        case kFixMul:
+        case kFracMul:
+        case kFixDiv:
+        case kFracDiv: {
+            const int64_t b = static_cast<int32_t>(readLong(stackAddress(1)));
+            const int64_t a = static_cast<int32_t>(readLong(stackAddress(5)));
+            bool ok;
+
+            switch (function) {
+                case kFixMul:  ok = divide(a * b, 1 << 16, 0, value); break;
+                case kFracMul: ok = divide(a * b, 1 << 30, 0, value); break;
+                case kFixDiv:  ok = divide(a, b, 16, value);          break;
+                default:       ok = divide(a, b, 30, value);          break;
+            }
+
+            if (!ok) return false;
+
+            result.push_back(valueSpan(stackAddress(9), static_cast<uint32_t>(value), 4));
+            param_bytes = 8;
+
+            return true;
+        }
+
+        case kFixRound: {
+            if (!divide(static_cast<int32_t>(readLong(stackAddress(1))), 1 << 16, 0, value)) return false;
+
+            if ((value < INT16_MIN) || (value > INT16_MAX)) return false;
+
+            result.push_back(valueSpan(stackAddress(5), static_cast<uint16_t>(value), 2));
+            param_bytes = 4;
+
+            return true;
+        }
+
+        case kHiWord:
+        case kLoWord: {
+            const uint32_t input = readLong(stackAddress(1));
+
+            result.push_back(valueSpan(stackAddress(5), (function == kHiWord)? (input >> 16) : (input & 0xFFFF), 2));
+            param_bytes = 4;
+
+            return true;
+        }
+
+        case kLong2Fix:
+        case kFix2Long:
+        case kFix2Frac:
+        case kFrac2Fix: {
+            const int32_t input = readLong(stackAddress(1));
+
+            switch (function) {
+                case kLong2Fix:
+                    if ((input < INT16_MIN) || (input > INT16_MAX)) return false;
+
+                    value = input * 65536;
+
+                    break;
+
+                case kFix2Frac:
+                    if ((input < -0x20000) || (input > 0x1FFFF)) return false;
+
+                    value = input * 16384;
+
+                    break;
+
+                case kFix2Long:
+                    if (!divide(input, 1 << 16, 0, value)) return false;
+
+                    break;
+
+                default:
+                    if (!divide(input, 1 << 14, 0, value)) return false;
+
+                    break;
+            }
+
+            result.push_back(valueSpan(stackAddress(5), static_cast<uint32_t>(value), 4));
+            param_bytes = 4;
+
+            return true;
+        }
+
+        case kInt2Hex:
+        case kLong2Hex: {
+            const bool     is_long = function == kLong2Hex;
+            const uint16_t length  = readWord(stackAddress(1));
+            const uint32_t addr    = readLong(stackAddress(3)) & 0xFFFFFF;
+            const uint32_t input   = is_long? readLong(stackAddress(7)) : readWord(stackAddress(7));
+            const std::string digits = (boost::format(is_long? "%08X" : "%04X") % input).str();
+
+            param_bytes = is_long? 10 : 8;
+
+            return putString(addr, length, digits, '0', result);
+        }
+
+        case kInt2Dec:
+        case kLong2Dec: {
+            const bool     is_long   = function == kLong2Dec;
+            const bool     is_signed = readWord(stackAddress(1)) != 0;
+            const uint16_t length    = readWord(stackAddress(3));
+            const uint32_t addr      = readLong(stackAddress(5)) & 0xFFFFFF;
+            const uint32_t input     = is_long? readLong(stackAddress(9)) : readWord(stackAddress(9));
+
+            if (is_signed && (input & (is_long? 0x80000000 : 0x8000))) return false;
+
+            param_bytes = is_long? 12 : 10;
+
+            return putString(addr, length, std::to_string(input), ' ', result);
+        }
+
+        default:
+            return false;
+    }
+}
+
+bool IntegerMathHLE::toolCall(const uint16_t function, const uint32_t return_ea)
+{
+    if (!callName(function)) {
+        ++calls_unhandled;
+
+        return false;
+    }
+
+    std::vector<Span> result;
+    unsigned int param_bytes;
+
+    if (((functionEntry(function) & 0xFFFFFF) < kROMStart) || !perform(function, result, param_bytes)) {
+        ++rom_fallbacks;
+
+        return false;
+    }
+
+    if (compare) {
+        watchResult(function, return_ea, param_bytes, std::move(result));
+
+        return false;
+    }
+
+    for (const Span& span : result) {
+        writeSpan(span);
+    }
+
+    returnNoError(param_bytes);
+
+    return true;
+}
+
+void IntegerMathHLE::toolReturn(const uint16_t function)
+{
+    checkExpected(callName(function));
+}
@@ -0,0 +1,62 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef INTEGERMATH_H_
+#define INTEGERMATH_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ToolSet.h"
+
+/**
+ * High-level emulation of the Integer Math tool set's arithmetic and
+ * conversion calls.
+ */
+class IntegerMathHLE : public ToolSetHLE {
+    private:
+        static constexpr unsigned int kToolSet = 0x0B;
+
+        static constexpr uint16_t kMultiply   = 0x090B;
+        static constexpr uint16_t kSDivide    = 0x0A0B;
+        static constexpr uint16_t kUDivide    = 0x0B0B;
+        static constexpr uint16_t kLongMul    = 0x0C0B;
+        static constexpr uint16_t kLongDivide = 0x0D0B;
+        static constexpr uint16_t kFixRatio   = 0x0E0B;
+        static constexpr uint16_t kFixMul     = 0x0F0B;
+        static constexpr uint16_t kFracMul    = 0x100B;
+        static constexpr uint16_t kFixDiv     = 0x110B;
+        static constexpr uint16_t kFracDiv    = 0x120B;
+        static constexpr uint16_t kFixRound   = 0x130B;
+        static constexpr uint16_t kHiWord     = 0x180B;
+        static constexpr uint16_t kLoWord     = 0x190B;
+        static constexpr uint16_t kLong2Fix   = 0x1A0B;
+        static constexpr uint16_t kFix2Long   = 0x1B0B;
+        static constexpr uint16_t kFix2Frac   = 0x1C0B;
+        static constexpr uint16_t kFrac2Fix   = 0x1D0B;
+        static constexpr uint16_t kInt2Hex    = 0x220B;
+        static constexpr uint16_t kLong2Hex   = 0x230B;
+        static constexpr uint16_t kInt2Dec    = 0x260B;
+        static constexpr uint16_t kLong2Dec   = 0x270B;
+
+        bool divide(const int64_t, const int64_t, const unsigned int, int32_t&);
+        bool putString(const uint32_t, const unsigned int, const std::string&, const char, std::vector<Span>&);
+
+        bool perform(const uint16_t, std::vector<Span>&, unsigned int&);
+
+    public:
+        IntegerMathHLE(const bool compare_mode) : ToolSetHLE("Integer Math HLE", kToolSet, compare_mode) {}
+        ~IntegerMathHLE() = default;
+
+        bool toolCall(const uint16_t, const uint32_t);
+        void toolReturn(const uint16_t);
+};
+
+#endif // INTEGERMATH_H_
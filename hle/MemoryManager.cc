@@ -0,0 +1,208 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+/*
+ * This class implements high-level emulation of a subset of the Memory
+ * Manager: the calls that work on existing handles and blocks.
+ *
+ * Only GetHandleSize, HLock, HUnlock, and the block copies (BlockMove,
+ * PtrToHand, HandToPtr, HandToHand) are done natively. They act on the
+ * handle records in the Memory Manager's own handle table, so nothing
+ * else can tell they weren't done by the ROM. Allocation is deliberately
+ * not emulated: NewHandle, DisposeHandle, CompactMem and every other call
+ * that creates, frees or moves blocks go to the ROM. Besides the handle
+ * records, those calls maintain the Memory Manager's free handle list and
+ * other private state whose layout isn't documented, so a native version
+ * would leave the ROM's view of the heap out of step with its own, and
+ * compare mode couldn't vouch for a block placed anywhere other than
+ * exactly where the ROM would have put it. Those show up as unhandled
+ * calls in the stats, and calls that could have been done natively but
+ * went to the ROM anyway as fallbacks.
+ *
+ * A handle is only trusted if its record is linked to its neighbours,
+ * belongs to someone, and hasn't been purged; anything doubtful goes to
+ * the ROM so that it can report the error. Calls are also left alone if
+ * the tool set's entry for them no longer points into the ROM, so that
+ * patches to the Memory Manager still take effect.
+ */
+
+#include "MemoryManager.h"
+
+#include "emulator/System.h"
+#include "M65816/Processor.h"
+
+// Returns the name of a call done natively, or nullptr for the rest
+static const char *callName(const uint16_t function)
+{
+    switch (function) {
+        case 0x1802: return "GetHandleSize";
+        case 0x2002: return "HLock";
+        case 0x2202: return "HUnlock";
+        case 0x2802: return "PtrToHand";
+        case 0x2902: return "HandToPtr";
+        case 0x2A02: return "HandToHand";
+        case 0x2B02: return "BlockMove";
+        default:     return nullptr;
+    }
+}
+
+/**
+ * Read a handle record, returning false if it doesn't look like one the
+ * Memory Manager has handed out.
+ */
+bool MemoryManagerHLE::readHandle(const uint32_t addr, Handle& handle)
+{
+    if (!addr || !isPlainMemory(addr, Handle::kSize)) return false;
+
+    handle.addr       = addr;
+    handle.block      = readLong(addr) & 0xFFFFFF;
+    handle.attributes = readWord(addr + 0x04);
+    handle.owner      = readWord(addr + 0x06);
+    handle.size       = readLong(addr + 0x08);
+    handle.prev       = readLong(addr + 0x0C) & 0xFFFFFF;
+    handle.next       = readLong(addr + 0x10) & 0xFFFFFF;
+
+    if (!handle.block || !handle.owner) return false;
+
+    if (handle.prev && (!isPlainMemory(handle.prev, Handle::kSize) || ((readLong(handle.prev + 0x10) & 0xFFFFFF) != addr))) {
+        return false;
+    }
+
+    if (handle.next && (!isPlainMemory(handle.next, Handle::kSize) || ((readLong(handle.next + 0x0C) & 0xFFFFFF) != addr))) {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Work out the result of copying count bytes from src to dst. Overlapping
+ * blocks are copied as though through a buffer, as BlockMove does.
+ */
+bool MemoryManagerHLE::copy(const uint32_t src, const uint32_t dst, const uint32_t count, std::vector<Span>& result)
+{
+    if (!count) return true;
+
+    if (!isPlainMemory(src, count) || !isPlainMemory(dst, count)) return false;
+
+    Span span = readSpan(src, count);
+
+    span.start = dst;
+
+    result.push_back(std::move(span));
+
+    return true;
+}
+
+/**
+ * Work out what a call would leave in memory, and how many bytes of
+ * parameters it pulls off the stack. Returns false if the call isn't
+ * one that can be done natively.
+ */
+bool MemoryManagerHLE::perform(const uint16_t function, std::vector<Span>& result, unsigned int& param_bytes)
+{
+    Handle src, dst;
+
+    switch (function) {
+        case kGetHandleSize: {
+            if (!readHandle(readLong(stackAddress(1)) & 0xFFFFFF, src)) return false;
+
+            // The size goes in the result space under the handle
+            Span span = readSpan(stackAddress(5), 4);
+
+            for (unsigned int i = 0 ; i < 4 ; ++i) {
+                span.bytes[i] = src.size >> (i * 8);
+            }
+
+            result.push_back(std::move(span));
+            param_bytes = 4;
+
+            return true;
+        }
+
+        case kHLock:
+        case kHUnlock: {
+            if (!readHandle(readLong(stackAddress(1)) & 0xFFFFFF, src)) return false;
+
+            const uint16_t attributes = (function == kHLock)? (src.attributes | Handle::kLocked) : (src.attributes & ~Handle::kLocked);
+
+            result.push_back({ src.addr + 0x04, { static_cast<uint8_t>(attributes), static_cast<uint8_t>(attributes >> 8) } });
+            param_bytes = 4;
+
+            return true;
+        }
+
+        // The rest all take a source, a destination, and a count, pushed
+        // in that order
+        case kBlockMove:
+        case kPtrToHand:
+        case kHandToPtr:
+        case kHandToHand: {
+            const uint32_t count   = readLong(stackAddress(1));
+            uint32_t       to      = readLong(stackAddress(5)) & 0xFFFFFF;
+            uint32_t       from    = readLong(stackAddress(9)) & 0xFFFFFF;
+
+            if ((function == kHandToPtr) || (function == kHandToHand)) {
+                if (!readHandle(from, src) || (count > src.size)) return false;
+
+                from = src.block;
+            }
+
+            if ((function == kPtrToHand) || (function == kHandToHand)) {
+                if (!readHandle(to, dst) || (count > dst.size)) return false;
+
+                to = dst.block;
+            }
+
+            param_bytes = 12;
+
+            return copy(from, to, count, result);
+        }
+
+        default:
+            return false;
+    }
+}
+
+bool MemoryManagerHLE::toolCall(const uint16_t function, const uint32_t return_ea)
+{
+    if (!callName(function)) {
+        ++calls_unhandled;
+
+        return false;
+    }
+
+    std::vector<Span> result;
+    unsigned int param_bytes;
+
+    if (((functionEntry(function) & 0xFFFFFF) < kROMStart) || !perform(function, result, param_bytes)) {
+        ++rom_fallbacks;
+
+        return false;
+    }
+
+    if (compare) {
+        watchResult(function, return_ea, param_bytes, std::move(result));
+
+        return false;
+    }
+
+    for (const Span& span : result) {
+        writeSpan(span);
+    }
+
+    returnNoError(param_bytes);
+
+    return true;
+}
+
+void MemoryManagerHLE::toolReturn(const uint16_t function)
+{
+    checkExpected(callName(function));
+}
@@ -0,0 +1,63 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef MEMORYMANAGER_H_
+#define MEMORYMANAGER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "ToolSet.h"
+
+/**
+ * High-level emulation of the Memory Manager calls that work on existing
+ * handles. Allocation always stays in the ROM.
+ */
+class MemoryManagerHLE : public ToolSetHLE {
+    private:
+        static constexpr unsigned int kToolSet = 0x02;
+
+        static constexpr uint16_t kGetHandleSize = 0x1802;
+        static constexpr uint16_t kHLock         = 0x2002;
+        static constexpr uint16_t kHUnlock       = 0x2202;
+        static constexpr uint16_t kPtrToHand     = 0x2802;
+        static constexpr uint16_t kHandToPtr     = 0x2902;
+        static constexpr uint16_t kHandToHand    = 0x2A02;
+        static constexpr uint16_t kBlockMove     = 0x2B02;
+
+        // A handle record in the Memory Manager's handle table
+        struct Handle {
+            static constexpr unsigned int kSize = 0x14;
+
+            static constexpr uint16_t kLocked = 0x8000;
+
+            uint32_t addr;
+            uint32_t block;
+            uint16_t attributes;
+            uint16_t owner;
+            uint32_t size;
+            uint32_t prev;
+            uint32_t next;
+        };
+
+        bool readHandle(const uint32_t, Handle&);
+
+        bool copy(const uint32_t, const uint32_t, const uint32_t, std::vector<Span>&);
+
+        bool perform(const uint16_t, std::vector<Span>&, unsigned int&);
+
+    public:
+        MemoryManagerHLE(const bool compare_mode) : ToolSetHLE("Memory Manager HLE", kToolSet, compare_mode) {}
+        ~MemoryManagerHLE() = default;
+
+        bool toolCall(const uint16_t, const uint32_t);
+        void toolReturn(const uint16_t);
+};
+
+#endif // MEMORYMANAGER_H_
@@ -0,0 +1,659 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+/*
+ * This class serves ProDOS 8 MLI calls for a volume backed by a host
+ * directory. The CPU offers it every JSR to the MLI entry point at $BF00
+ * in bank 0; calls naming a path on the host volume, or a reference
+ * number for a file opened there, are done here and everything else is
+ * passed on to ProDOS.
+ *
+ * Supported are GET_FILE_INFO, ON_LINE (for the host volume's own unit
+ * only), SET_PREFIX, GET_PREFIX, OPEN, NEWLINE, READ, WRITE, CLOSE,
+ * FLUSH, SET_MARK, GET_MARK, SET_EOF and GET_EOF. Files can't be
+ * created, destroyed or renamed, and directories can't be opened for
+ * reading. The volume doesn't show up in an ON_LINE call for all units,
+ * since that list is built by ProDOS itself.
+ *
+ * Host files are matched case-insensitively, and their ProDOS file type
+ * and aux type can be given with a "#ttaaaa" suffix on the name, as
+ * CiderPress does; files without one are treated as BIN files.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <ctime>
+
+#if __has_include(<filesystem>)
+    #include <filesystem>
+    namespace fs = std::filesystem;
+#else
+    #include <experimental/filesystem>
+    namespace fs = std::experimental::filesystem;
+#endif
+
+#include "ProDOS8.h"
+
+#include "emulator/System.h"
+#include "M65816/Processor.h"
+
+using std::string;
+using std::vector;
+
+bool ProDOS8HLE::isValidName(const string& name)
+{
+    if (name.empty() || (name.length() > 15) || !std::isalpha(static_cast<unsigned char>(name[0]))) return false;
+
+    return std::all_of(name.begin(), name.end(), [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || (c == '.'); });
+}
+
+/**
+ * Returns true if a host file name ends in a "#ttaaaa" type suffix.
+ */
+static bool hasTypeSuffix(const string& name)
+{
+    return (name.length() > 7) && (name[name.length() - 7] == '#')
+        && std::all_of(name.end() - 6, name.end(), [](char c) { return std::isxdigit(static_cast<unsigned char>(c)); });
+}
+
+string ProDOS8HLE::prodosName(const string& host_name)
+{
+    string name = hasTypeSuffix(host_name)? host_name.substr(0, host_name.length() - 7) : host_name;
+
+    std::transform(name.begin(), name.end(), name.begin(), [](char c) { return std::toupper(static_cast<unsigned char>(c)); });
+
+    return name;
+}
+
+static void fileType(const string& host_name, uint8_t& type, uint16_t& aux)
+{
+    if (hasTypeSuffix(host_name)) {
+        const unsigned long v = std::stoul(host_name.substr(host_name.length() - 6), nullptr, 16);
+
+        type = v >> 16;
+        aux  = v & 0xFFFF;
+    }
+    else {
+        type = 0x06;    // BIN
+        aux  = 0x0000;
+    }
+}
+
+static void prodosDateTime(const fs::file_time_type& ftime, uint16_t& date, uint16_t& time)
+{
+    using namespace std::chrono;
+
+    const auto sys_time = time_point_cast<system_clock::duration>(ftime - fs::file_time_type::clock::now() + system_clock::now());
+    const std::time_t t = system_clock::to_time_t(sys_time);
+    const std::tm *tm   = std::localtime(&t);
+
+    date = ((tm->tm_year % 100) << 9) | ((tm->tm_mon + 1) << 5) | tm->tm_mday;
+    time = (tm->tm_hour << 8) | tm->tm_min;
+}
+
+void ProDOS8HLE::reset()
+{
+    for (OpenFile& file : files) {
+        closeFile(file);
+    }
+
+    prefix_on_host = false;
+    prefix.clear();
+}
+
+void ProDOS8HLE::attach(System *theSystem)
+{
+    Device::attach(theSystem);
+
+    system->setMLIHandler(this);
+}
+
+/**
+ * Returns true if a buffer in bank 0 contains no I/O locations, so that
+ * data can be moved in and out of it directly.
+ */
+bool ProDOS8HLE::isPlainBuffer(const uint16_t start, const unsigned int length)
+{
+    if (!length) return true;
+
+    return (start + length <= 0x10000) && isPlainMemory(start, length);
+}
+
+/**
+ * Split the pathname at addr into the names below the host volume.
+ * Returns false if the path isn't on the host volume.
+ */
+bool ProDOS8HLE::resolve(const uint16_t addr, vector<string>& components)
+{
+    const unsigned int length = readByte(addr);
+    string path;
+
+    for (unsigned int i = 1 ; i <= length ; ++i) {
+        path += std::toupper(readByte(addr + i) & 0x7F);
+    }
+
+    if (path.empty()) return false;
+
+    const bool full = path[0] == '/';
+    vector<string> names;
+    size_t pos = full? 1 : 0;
+
+    while (pos < path.length()) {
+        size_t end = path.find('/', pos);
+
+        if (end == string::npos) end = path.length();
+        if (end > pos) names.push_back(path.substr(pos, end - pos));
+
+        pos = end + 1;
+    }
+
+    if (full) {
+        if (names.empty() || (names[0] != volume)) return false;
+
+        components.assign(names.begin() + 1, names.end());
+    }
+    else {
+        if (!prefix_on_host) return false;
+
+        components = prefix;
+        components.insert(components.end(), names.begin(), names.end());
+    }
+
+    return true;
+}
+
+/**
+ * Find the host file for a path on the host volume.
+ */
+int ProDOS8HLE::hostPath(const vector<string>& components, string& result)
+{
+    fs::path p(host_dir);
+
+    for (size_t i = 0 ; i < components.size() ; ++i) {
+        const bool last = (i + 1) == components.size();
+        std::error_code ec;
+        bool found = false;
+
+        if (!isValidName(components[i])) return kInvalidPath;
+
+        for (const fs::directory_entry& entry : fs::directory_iterator(p, ec)) {
+            if (prodosName(entry.path().filename().string()) == components[i]) {
+                p = entry.path();
+                found = true;
+
+                break;
+            }
+        }
+
+        if (!found) return last? kFileNotFound : kPathNotFound;
+
+        if (!last && !fs::is_directory(p, ec)) return kPathNotFound;
+    }
+
+    result = p.string();
+
+    return kNoError;
+}
+
+/**
+ * Look up the open file for a call taking a reference number. Returns
+ * kNotMine if the reference number isn't one of ours.
+ */
+int ProDOS8HLE::checkRef(const uint16_t params, const unsigned int count, OpenFile *& file)
+{
+    const uint8_t ref = readByte(params + 1);
+
+    if ((ref < kFirstRefNum) || (ref >= kFirstRefNum + kMaxFiles)) return kNotMine;
+
+    if (readByte(params) != count) return kBadParamCount;
+
+    file = &files[ref - kFirstRefNum];
+
+    return file->open? kNoError : kBadRefNum;
+}
+
+void ProDOS8HLE::closeFile(OpenFile& file)
+{
+    if (file.open) {
+        file.stream.close();
+        file.open = false;
+    }
+}
+
+uint32_t ProDOS8HLE::fileEOF(OpenFile& file)
+{
+    std::error_code ec;
+
+    file.stream.flush();
+
+    const std::uintmax_t size = fs::file_size(file.path, ec);
+
+    return ec? 0 : std::min<std::uintmax_t>(size, 0xFFFFFF);
+}
+
+int ProDOS8HLE::getFileInfo(const uint16_t params)
+{
+    vector<string> components;
+    string path;
+
+    if (!resolve(readWord(params + 1), components)) return kNotMine;
+
+    if (readByte(params) != 0x0A) return kBadParamCount;
+
+    if (const int err = hostPath(components, path)) return err;
+
+    std::error_code ec;
+    const fs::file_status status = fs::status(path, ec);
+
+    if (ec) return kIOError;
+
+    const bool writable = (status.permissions() & fs::perms::owner_write) != fs::perms::none;
+    uint8_t  type, storage;
+    uint16_t aux, blocks;
+
+    if (fs::is_directory(status)) {
+        type    = 0x0F;
+        storage = components.empty()? 0x0F : 0x0D;
+        aux     = components.empty()? 0xFFFF : 0;   // total blocks for a volume
+        blocks  = components.empty()? 0 : 1;
+    }
+    else {
+        const std::uintmax_t size = fs::file_size(path, ec);
+        const std::uintmax_t data = (size + 511) / 512;
+
+        fileType(fs::path(path).filename().string(), type, aux);
+
+        if (size <= 512) {
+            storage = 0x01; // seedling
+            blocks  = 1;
+        }
+        else if (size <= 131072) {
+            storage = 0x02; // sapling
+            blocks  = data + 1;
+        }
+        else {
+            storage = 0x03; // tree
+            blocks  = std::min<std::uintmax_t>(data + 1 + (data + 255) / 256, 0xFFFF);
+        }
+    }
+
+    uint16_t date, time;
+
+    prodosDateTime(fs::last_write_time(path, ec), date, time);
+
+    writeByte(params + 0x03, writable? 0xC3 : 0x01);
+    writeByte(params + 0x04, type);
+    writeWord(params + 0x05, aux);
+    writeByte(params + 0x07, storage);
+    writeWord(params + 0x08, blocks);
+    writeWord(params + 0x0A, date);
+    writeWord(params + 0x0C, time);
+    writeWord(params + 0x0E, date);
+    writeWord(params + 0x10, time);
+
+    return kNoError;
+}
+
+int ProDOS8HLE::onLine(const uint16_t params)
+{
+    if (readByte(params + 1) != kHostUnit) return kNotMine;
+
+    if (readByte(params) != 2) return kBadParamCount;
+
+    const uint16_t buffer = readWord(params + 2);
+
+    if (!isPlainBuffer(buffer, 16)) return kBadBuffer;
+
+    writeByte(buffer, kHostUnit | volume.length());
+
+    for (unsigned int i = 0 ; i < 15 ; ++i) {
+        writeByte(buffer + 1 + i, (i < volume.length())? volume[i] : 0);
+    }
+
+    return kNoError;
+}
+
+int ProDOS8HLE::setPrefix(const uint16_t params)
+{
+    vector<string> components;
+    string path;
+
+    if (!resolve(readWord(params + 1), components)) {
+        // ProDOS is taking the prefix back
+        prefix_on_host = false;
+
+        return kNotMine;
+    }
+
+    if (readByte(params) != 1) return kBadParamCount;
+
+    if (const int err = hostPath(components, path)) return err;
+
+    std::error_code ec;
+
+    if (!fs::is_directory(path, ec)) return kBadStorage;
+
+    prefix = components;
+    prefix_on_host = true;
+
+    return kNoError;
+}
+
+int ProDOS8HLE::getPrefix(const uint16_t params)
+{
+    if (!prefix_on_host) return kNotMine;
+
+    if (readByte(params) != 1) return kBadParamCount;
+
+    string path = "/" + volume + "/";
+
+    for (const string& name : prefix) {
+        path += name + "/";
+    }
+
+    const uint16_t buffer = readWord(params + 1);
+
+    if ((path.length() > 64) || !isPlainBuffer(buffer, path.length() + 1)) return kBadBuffer;
+
+    writeByte(buffer, path.length());
+
+    for (unsigned int i = 0 ; i < path.length() ; ++i) {
+        writeByte(buffer + 1 + i, path[i]);
+    }
+
+    return kNoError;
+}
+
+int ProDOS8HLE::openFile(const uint16_t params)
+{
+    vector<string> components;
+    string path;
+
+    if (!resolve(readWord(params + 1), components)) return kNotMine;
+
+    if (readByte(params) != 3) return kBadParamCount;
+
+    if (const int err = hostPath(components, path)) return err;
+
+    std::error_code ec;
+
+    if (components.empty() || fs::is_directory(path, ec)) return kBadStorage;
+
+    for (const OpenFile& file : files) {
+        if (file.open && (file.path == path)) return kFileBusy;
+    }
+
+    OpenFile *file = std::find_if(std::begin(files), std::end(files), [](const OpenFile& f) { return !f.open; });
+
+    if (file == std::end(files)) return kFCBFull;
+
+    file->writable = true;
+    file->stream.open(path, std::fstream::in | std::fstream::out | std::fstream::binary);
+
+    if (file->stream.fail()) {
+        file->writable = false;
+        file->stream.clear();
+        file->stream.open(path, std::fstream::in | std::fstream::binary);
+
+        if (file->stream.fail()) return kIOError;
+    }
+
+    file->open  = true;
+    file->path  = path;
+    file->level = readByte(kLevel);
+    file->mark  = 0;
+    file->newline_mask = 0;
+    file->newline_char = 0;
+
+    writeByte(params + 5, kFirstRefNum + (file - files));
+
+    return kNoError;
+}
+
+int ProDOS8HLE::newline(const uint16_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 3, file)) return err;
+
+    file->newline_mask = readByte(params + 2);
+    file->newline_char = readByte(params + 3);
+
+    return kNoError;
+}
+
+int ProDOS8HLE::readFile(const uint16_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 4, file)) return err;
+
+    const uint16_t buffer  = readWord(params + 2);
+    const uint16_t request = readWord(params + 4);
+
+    writeWord(params + 6, 0);
+
+    if (!isPlainBuffer(buffer, request)) return kBadBuffer;
+
+    vector<char> data(request);
+
+    file->stream.clear();
+    file->stream.seekg(file->mark);
+    file->stream.read(data.data(), request);
+
+    if (file->stream.bad()) return kIOError;
+
+    unsigned int count = file->stream.gcount();
+
+    // In newline mode the read stops after the first newline character
+    if (file->newline_mask) {
+        for (unsigned int i = 0 ; i < count ; ++i) {
+            if ((data[i] & file->newline_mask) == file->newline_char) {
+                count = i + 1;
+
+                break;
+            }
+        }
+    }
+
+    if (request && !count) return kEndOfFile;
+
+    for (unsigned int i = 0 ; i < count ; ++i) {
+        writeByte(buffer + i, data[i]);
+    }
+
+    file->mark += count;
+
+    writeWord(params + 6, count);
+
+    return kNoError;
+}
+
+int ProDOS8HLE::writeFile(const uint16_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 4, file)) return err;
+
+    const uint16_t buffer  = readWord(params + 2);
+    const uint16_t request = readWord(params + 4);
+
+    writeWord(params + 6, 0);
+
+    if (!file->writable) return kAccessError;
+
+    if (!isPlainBuffer(buffer, request)) return kBadBuffer;
+
+    vector<char> data(request);
+
+    for (unsigned int i = 0 ; i < request ; ++i) {
+        data[i] = readByte(buffer + i);
+    }
+
+    file->stream.clear();
+    file->stream.seekp(file->mark);
+    file->stream.write(data.data(), request);
+
+    if (file->stream.fail()) return kIOError;
+
+    file->mark += request;
+
+    writeWord(params + 6, request);
+
+    return kNoError;
+}
+
+int ProDOS8HLE::close(const uint16_t params)
+{
+    // Closing everything at or above the current level closes our files
+    // too, but ProDOS still has to close its own.
+    if (!readByte(params + 1)) {
+        const uint8_t level = readByte(kLevel);
+
+        for (OpenFile& file : files) {
+            if (file.open && (file.level >= level)) closeFile(file);
+        }
+
+        return kNotMine;
+    }
+
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 1, file)) return err;
+
+    closeFile(*file);
+
+    return kNoError;
+}
+
+int ProDOS8HLE::flush(const uint16_t params)
+{
+    if (!readByte(params + 1)) {
+        for (OpenFile& file : files) {
+            if (file.open) file.stream.flush();
+        }
+
+        return kNotMine;
+    }
+
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 1, file)) return err;
+
+    file->stream.flush();
+
+    return file->stream.fail()? kIOError : kNoError;
+}
+
+int ProDOS8HLE::setMark(const uint16_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 2, file)) return err;
+
+    const uint32_t mark = (readLong(params + 2) & 0xFFFFFF);
+
+    if (mark > fileEOF(*file)) return kOutOfRange;
+
+    file->mark = mark;
+
+    return kNoError;
+}
+
+int ProDOS8HLE::getMark(const uint16_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 2, file)) return err;
+
+    writeWord(params + 2, file->mark);
+    writeByte(params + 4, file->mark >> 16);
+
+    return kNoError;
+}
+
+int ProDOS8HLE::setEOF(const uint16_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 2, file)) return err;
+
+    if (!file->writable) return kAccessError;
+
+    const uint32_t eof = (readLong(params + 2) & 0xFFFFFF);
+    std::error_code ec;
+
+    file->stream.flush();
+
+    fs::resize_file(file->path, eof, ec);
+
+    if (ec) return kIOError;
+
+    file->mark = std::min(file->mark, eof);
+
+    return kNoError;
+}
+
+int ProDOS8HLE::getEOF(const uint16_t params)
+{
+    OpenFile *file;
+
+    if (const int err = checkRef(params, 2, file)) return err;
+
+    const uint32_t eof = fileEOF(*file);
+
+    writeWord(params + 2, eof);
+    writeByte(params + 4, eof >> 16);
+
+    return kNoError;
+}
+
+bool ProDOS8HLE::mliCall(const uint16_t addr)
+{
+    M65816::Processor *cpu = system->cpu;
+
+    // Nothing to do unless ProDOS 8's global page is in place
+    if (readByte(System::kMLIEntry) != 0x4C) return false;
+
+    const uint16_t params = readWord(addr + 1);
+    int error;
+
+    switch (readByte(addr)) {
+        case kGetFileInfo: error = getFileInfo(params); break;
+        case kOnLine:      error = onLine(params);      break;
+        case kSetPrefix:   error = setPrefix(params);   break;
+        case kGetPrefix:   error = getPrefix(params);   break;
+        case kOpen:        error = openFile(params);    break;
+        case kNewline:     error = newline(params);     break;
+        case kRead:        error = readFile(params);    break;
+        case kWrite:       error = writeFile(params);   break;
+        case kClose:       error = close(params);       break;
+        case kFlush:       error = flush(params);       break;
+        case kSetMark:     error = setMark(params);     break;
+        case kGetMark:     error = getMark(params);     break;
+        case kSetEOF:      error = setEOF(params);      break;
+        case kGetEOF:      error = getEOF(params);      break;
+        default:           return false;
+    }
+
+    if (error == kNotMine) return false;
+
+    cpu->A.B.L = error;
+    cpu->SR.C  = error != kNoError;
+    cpu->SR.setN(false);
+    cpu->SR.setZ(error == kNoError);
+
+    // Carry on after the command byte and parameter list pointer
+    cpu->PC = addr + 3;
+
+    ++calls_handled;
+
+    return true;
+}
@@ -0,0 +1,138 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef PRODOS8_H_
+#define PRODOS8_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "HLEDevice.h"
+
+/**
+ * Serves ProDOS 8 MLI calls for one volume straight from a directory on
+ * the host, instead of having ProDOS walk a disk image block by block.
+ * Calls for anything else are left to ProDOS.
+ */
+class ProDOS8HLE : public HLEDevice {
+    private:
+        // MLI calls
+        static constexpr uint8_t kGetFileInfo = 0xC4;
+        static constexpr uint8_t kOnLine      = 0xC5;
+        static constexpr uint8_t kSetPrefix   = 0xC6;
+        static constexpr uint8_t kGetPrefix   = 0xC7;
+        static constexpr uint8_t kOpen        = 0xC8;
+        static constexpr uint8_t kNewline     = 0xC9;
+        static constexpr uint8_t kRead        = 0xCA;
+        static constexpr uint8_t kWrite       = 0xCB;
+        static constexpr uint8_t kClose       = 0xCC;
+        static constexpr uint8_t kFlush       = 0xCD;
+        static constexpr uint8_t kSetMark     = 0xCE;
+        static constexpr uint8_t kGetMark     = 0xCF;
+        static constexpr uint8_t kSetEOF      = 0xD0;
+        static constexpr uint8_t kGetEOF      = 0xD1;
+
+        // MLI error codes
+        static constexpr int kNoError       = 0x00;
+        static constexpr int kBadParamCount = 0x04;
+        static constexpr int kIOError       = 0x27;
+        static constexpr int kInvalidPath   = 0x40;
+        static constexpr int kFCBFull       = 0x42;
+        static constexpr int kBadRefNum     = 0x43;
+        static constexpr int kPathNotFound  = 0x44;
+        static constexpr int kFileNotFound  = 0x46;
+        static constexpr int kBadStorage    = 0x4B;
+        static constexpr int kEndOfFile     = 0x4C;
+        static constexpr int kOutOfRange    = 0x4D;
+        static constexpr int kAccessError   = 0x4E;
+        static constexpr int kFileBusy      = 0x50;
+        static constexpr int kBadBuffer     = 0x56;
+
+        // Returned by the call handlers when a call is for ProDOS
+        static constexpr int kNotMine = -1;
+
+        // Unit number ON_LINE reports the volume under (slot 4, drive 1,
+        // where the IIgs has its mouse rather than a disk)
+        static constexpr uint8_t kHostUnit = 0x40;
+
+        // Reference numbers for host files, clear of ProDOS's own (1-8)
+        static constexpr uint8_t kFirstRefNum = 0xF8;
+        static constexpr unsigned int kMaxFiles = 8;
+
+        // The current file level, in the global page
+        static constexpr uint16_t kLevel = 0xBF94;
+
+        struct OpenFile {
+            bool         open = false;
+            std::string  path;
+            std::fstream stream;
+            bool         writable;
+            uint8_t      level;
+            uint32_t     mark;
+            uint8_t      newline_mask;
+            uint8_t      newline_char;
+        };
+
+        const std::string host_dir;
+        const std::string volume;
+
+        OpenFile files[kMaxFiles];
+
+        // The prefix, if it has been set to somewhere on the host volume
+        bool prefix_on_host = false;
+        std::vector<std::string> prefix;
+
+        unsigned long calls_handled = 0;
+
+        bool isPlainBuffer(const uint16_t, const unsigned int);
+
+        bool resolve(const uint16_t, std::vector<std::string>&);
+        int  hostPath(const std::vector<std::string>&, std::string&);
+
+        int checkRef(const uint16_t, const unsigned int, OpenFile *&);
+        void closeFile(OpenFile&);
+        uint32_t fileEOF(OpenFile&);
+
+        int getFileInfo(const uint16_t);
+        int onLine(const uint16_t);
+        int setPrefix(const uint16_t);
+        int getPrefix(const uint16_t);
+        int openFile(const uint16_t);
+        int newline(const uint16_t);
+        int readFile(const uint16_t);
+        int writeFile(const uint16_t);
+        int close(const uint16_t);
+        int flush(const uint16_t);
+        int setMark(const uint16_t);
+        int getMark(const uint16_t);
+        int setEOF(const uint16_t);
+        int getEOF(const uint16_t);
+
+    public:
+        ProDOS8HLE(const std::string& dir, const std::string& volume_name) : host_dir(dir), volume(volume_name) {}
+        ~ProDOS8HLE() = default;
+
+        void reset();
+
+        void attach(System *theSystem);
+
+        bool mliCall(const uint16_t);
+
+        unsigned long getCallsHandled() const { return calls_handled; }
+
+        // True if name is a valid ProDOS file or volume name
+        static bool isValidName(const std::string&);
+
+        // The ProDOS name a host file is known by
+        static std::string prodosName(const std::string&);
+};
+
+#endif // PRODOS8_H_
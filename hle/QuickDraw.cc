@@ -0,0 +1,495 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+/*
+ * This class implements high-level emulation of QuickDraw II calls.
+ *
+ * PaintPixels is done natively, since it is the workhorse behind
+ * scrolling and window updates and works purely from the records passed
+ * to it. It is handled for the four plain transfer modes (copy, OR, XOR,
+ * BIC) between images of the same pixel size, when both rectangles lie
+ * within their image bounds and the mask is a rectangular region. Source
+ * and destination may only overlap for a copy within one image
+ * (scrolling), which is done as though through a buffer; anything else
+ * goes to the ROM. Calls left to the ROM are counted as fallbacks in the
+ * stats.
+ *
+ * PaintRect and EraseRect draw with the current GrafPort, which QuickDraw
+ * II keeps in its own direct page. The slot holding it is found by
+ * watching SetPort: the offsets that hold the new port after each call
+ * are narrowed down until two different ports have been set, and the
+ * port is only trusted while every remaining offset agrees on it. The
+ * rectangle is then filled natively when the pen (or background, for
+ * EraseRect) pattern is one solid color, the pen mode is one of the four
+ * plain ones, the clip and visible regions are rectangular, and nothing
+ * is recording or redirecting the drawing (pictures, regions, polygons or
+ * custom grafProcs). A hidden pen or a pen mask goes to the ROM.
+ *
+ * Drawing on the screen is only done natively while the cursor is known
+ * to be hidden, going by the HideCursor, ShowCursor and InitCursor calls
+ * seen, since the ROM takes the cursor off the screen around drawing that
+ * touches it.
+ *
+ * The native path is only used between a successful QDStartUp and the
+ * matching QDShutDown, and only for as long as the tool set's entry for
+ * the call is the one that was there at startup, so that a patched
+ * QuickDraw is left alone.
+ */
+
+#include <algorithm>
+
+#include "QuickDraw.h"
+
+#include "emulator/System.h"
+#include "M65816/Processor.h"
+
+void QuickDrawHLE::reset()
+{
+    ToolSetHLE::reset();
+
+    started = false;
+    start_entries.clear();
+    direct_page = 0;
+    port_offsets.clear();
+    last_port = 0;
+    ports_seen = 0;
+    cursor_level = 0;
+}
+
+QuickDrawHLE::Rect QuickDrawHLE::readRect(const uint32_t ea)
+{
+    return {
+        static_cast<int16_t>(readWord(ea)),
+        static_cast<int16_t>(readWord(ea + 2)),
+        static_cast<int16_t>(readWord(ea + 4)),
+        static_cast<int16_t>(readWord(ea + 6))
+    };
+}
+
+QuickDrawHLE::LocInfo QuickDrawHLE::readLocInfo(const uint32_t ea)
+{
+    return { readWord(ea), readLong(ea + 2) & 0xFFFFFF, readWord(ea + 6), readRect(ea + 8) };
+}
+
+/**
+ * True if the tool set's entry for a function is still the one it had
+ * when QuickDraw II was started.
+ */
+bool QuickDrawHLE::isFromStartUp(const uint16_t function)
+{
+    const auto it = start_entries.find(function);
+
+    return (it != start_entries.end()) && (functionEntry(function) == it->second);
+}
+
+/**
+ * The current GrafPort, or 0 if where QuickDraw II keeps it isn't known
+ * for certain.
+ */
+uint32_t QuickDrawHLE::currentPort()
+{
+    if ((ports_seen < 2) || port_offsets.empty()) return 0;
+
+    const uint32_t port = readLong(direct_page + port_offsets[0]) & 0xFFFFFF;
+
+    for (const uint16_t offset : port_offsets) {
+        if ((readLong(direct_page + offset) & 0xFFFFFF) != port) return 0;
+    }
+
+    return port;
+}
+
+/**
+ * Get the bounding box of a region from its handle. Returns false unless
+ * the region is a plain rectangle.
+ */
+bool QuickDrawHLE::regionRect(const uint32_t handle, Rect& rect)
+{
+    const uint32_t region = handle? readLong(handle) & 0xFFFFFF : 0;
+
+    if (!region || (readWord(region) != 10)) return false;
+
+    rect = readRect(region + 2);
+
+    return true;
+}
+
+/**
+ * True if the bytes from first to last can be drawn without going
+ * through the ROM. The ROM takes the cursor off the screen around
+ * drawing that touches it, so drawing on the screen (or its shadow in
+ * bank $01) is only done while the cursor is hidden.
+ */
+bool QuickDrawHLE::mayDraw(const uint32_t first, const uint32_t last)
+{
+    if (!isPlainMemory(first, last - first + 1)) return false;
+
+    if (cursor_level < 0) return true;
+
+    for (const uint32_t screen : { 0xE12000, 0x012000 }) {
+        if ((first <= screen + 0x7FFF) && (screen <= last)) return false;
+    }
+
+    return true;
+}
+
+/**
+ * Narrow down the offsets in QuickDraw II's direct page that hold the
+ * current port, once a SetPort has returned.
+ */
+void QuickDrawHLE::learnPort()
+{
+    if (system->cpu->SR.C || (direct_page + kDirectPageSize > 0x10000)) return;
+
+    const Span dp = readSpan(direct_page, kDirectPageSize);
+
+    const auto holds_port = [&](const uint16_t offset) {
+        const uint32_t value = dp.bytes[offset] | (dp.bytes[offset + 1] << 8) | (dp.bytes[offset + 2] << 16);
+
+        return value == new_port;
+    };
+
+    if (!ports_seen) {
+        for (unsigned int offset = 0 ; offset + 4 <= kDirectPageSize ; ++offset) {
+            if (holds_port(offset)) port_offsets.push_back(offset);
+        }
+    }
+    else {
+        port_offsets.erase(std::remove_if(port_offsets.begin(), port_offsets.end(),
+                                          [&](const uint16_t offset) { return !holds_port(offset); }),
+                           port_offsets.end());
+    }
+
+    if (!ports_seen || (new_port != last_port)) {
+        ++ports_seen;
+
+        last_port = new_port;
+    }
+}
+
+/**
+ * Work out the result of a PaintPixels call, as the new contents of the
+ * part of the destination image it touches. Returns false if the call
+ * isn't one that can be done natively.
+ */
+bool QuickDrawHLE::paintPixels(const uint32_t params, Span& result)
+{
+    const LocInfo src = readLocInfo(readLong(params) & 0xFFFFFF);
+    const LocInfo dst = readLocInfo(readLong(params + 4) & 0xFFFFFF);
+    const Rect src_rect = readRect(readLong(params + 8) & 0xFFFFFF);
+    const uint32_t dst_point = readLong(params + 12) & 0xFFFFFF;
+    const uint16_t mode = readWord(params + 16);
+    const uint32_t mask = readLong(params + 18) & 0xFFFFFF;
+
+    // Only the plain transfer modes, between images of the same pixel size
+    if ((mode > 3) || ((src.scb ^ dst.scb) & 0x80) || !src.width || !dst.width) return false;
+
+    if (src_rect.isEmpty() || !src.bounds.contains(src_rect)) return false;
+
+    const int dv = static_cast<int16_t>(readWord(dst_point));
+    const int dh = static_cast<int16_t>(readWord(dst_point + 2));
+    const int height = src_rect.v2 - src_rect.v1;
+    const int width  = src_rect.h2 - src_rect.h1;
+
+    if ((dv + height > 0x7FFF) || (dh + width > 0x7FFF)) return false;
+
+    const Rect dst_rect = {
+        static_cast<int16_t>(dv), static_cast<int16_t>(dh),
+        static_cast<int16_t>(dv + height), static_cast<int16_t>(dh + width)
+    };
+
+    if (!dst.bounds.contains(dst_rect)) return false;
+
+    // The mask has to be a rectangular region
+    const uint32_t region = mask? readLong(mask) & 0xFFFFFF : 0;
+
+    if (!region || (readWord(region) != 10)) return false;
+
+    const Rect clip = dst_rect.intersect(readRect(region + 2));
+
+    result = Span();
+
+    if (clip.isEmpty()) return true;
+
+    // Where the clipped rectangle comes from in the source
+    const int sv1 = src_rect.v1 + (clip.v1 - dst_rect.v1);
+    const int sh1 = src_rect.h1 + (clip.h1 - dst_rect.h1);
+    const int sv2 = sv1 + (clip.v2 - clip.v1);
+    const int sh2 = sh1 + (clip.h2 - clip.h1);
+
+    const uint32_t src_first = src.image + src.offsetOf(sh1, sv1);
+    const uint32_t src_last  = src.image + src.offsetOf(sh2 - 1, sv2 - 1);
+    const uint32_t dst_first = dst.image + dst.offsetOf(clip.h1, clip.v1);
+    const uint32_t dst_last  = dst.image + dst.offsetOf(clip.h2 - 1, clip.v2 - 1);
+
+    if (!isPlainMemory(src_first, src_last - src_first + 1) || !mayDraw(dst_first, dst_last)) return false;
+
+    // A copy within one image, such as a scroll, comes out as though the
+    // source had been copied to a buffer first, which is what reading it
+    // all up front gives. How other overlapping transfers come out is up
+    // to the ROM.
+    if ((src_first <= dst_last) && (dst_first <= src_last)) {
+        if ((mode != 0) || (src.image != dst.image) || (src.width != dst.width)) return false;
+    }
+
+    const Span source = readSpan(src_first, src_last - src_first + 1);
+
+    result = readSpan(dst_first, dst_last - dst_first + 1);
+
+    const unsigned int ppb  = src.pixelsPerByte();
+    const unsigned int bits = 8 / ppb;
+    const unsigned int pixel_mask = (1 << bits) - 1;
+
+    for (int v = clip.v1 ; v < clip.v2 ; ++v) {
+        const int sv = sv1 + (v - clip.v1);
+
+        for (int h = clip.h1 ; h < clip.h2 ; ++h) {
+            const int sh = sh1 + (h - clip.h1);
+
+            // The leftmost pixel of a byte is in its high bits
+            const unsigned int src_shift = (ppb - 1 - (sh - src.bounds.h1) % ppb) * bits;
+            const unsigned int dst_shift = (ppb - 1 - (h - dst.bounds.h1) % ppb) * bits;
+
+            const unsigned int pixel = (source.bytes[src.image + src.offsetOf(sh, sv) - src_first] >> src_shift) & pixel_mask;
+            uint8_t& out = result.bytes[dst.image + dst.offsetOf(h, v) - dst_first];
+            const unsigned int old = (out >> dst_shift) & pixel_mask;
+            unsigned int val;
+
+            switch (mode) {
+                case 0:  val = pixel;        break;  // modeCopy
+                case 1:  val = old | pixel;  break;  // modeOR
+                case 2:  val = old ^ pixel;  break;  // modeXOR
+                default: val = old & ~pixel; break;  // modeBIC
+            }
+
+            out = (out & ~(pixel_mask << dst_shift)) | ((val & pixel_mask) << dst_shift);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Work out the result of a PaintRect call, or an EraseRect call if erase
+ * is set, as the new contents of the part of the port's image it
+ * touches. Returns false if the call isn't one that can be done natively.
+ */
+bool QuickDrawHLE::fillRect(const uint32_t rect_ptr, const bool erase, Span& result)
+{
+    const uint32_t port = currentPort();
+
+    if (!port) return false;
+
+    // Pictures, regions and polygons being recorded, or drawing routed
+    // through custom procedures, are all up to the ROM
+    if (readLong(port + kGrafProcs) || readLong(port + kPicSave) || readLong(port + kRgnSave) || readLong(port + kPolySave)) {
+        return false;
+    }
+
+    if (static_cast<int16_t>(readWord(port + kPnVis)) < 0) return false;
+
+    for (unsigned int i = 0 ; i < 8 ; ++i) {
+        if (readByte(port + kPnMask + i) != 0xFF) return false;
+    }
+
+    const uint16_t mode = erase? 0 : readWord(port + kPnMode);
+
+    if (mode > 3) return false;
+
+    const LocInfo info = readLocInfo(port + kPortInfo);
+
+    if (!info.width) return false;
+
+    // The pattern has to be a single color all over
+    const Span pattern = readSpan(port + (erase? kBkPat : kPnPat), 32);
+    const uint8_t b = pattern.bytes[0];
+
+    if (std::count(pattern.bytes.begin(), pattern.bytes.end(), b) != 32) return false;
+
+    if ((info.pixelsPerByte() == 2)? ((b >> 4) != (b & 0x0F)) : (b != (b & 0x03) * 0x55)) return false;
+
+    Rect clip_box, vis_box;
+
+    if (!regionRect(readLong(port + kClipRgn) & 0xFFFFFF, clip_box) || !regionRect(readLong(port + kVisRgn) & 0xFFFFFF, vis_box)) {
+        return false;
+    }
+
+    const Rect clip = readRect(rect_ptr).intersect(readRect(port + kPortRect)).intersect(clip_box).intersect(vis_box).intersect(info.bounds);
+
+    result = Span();
+
+    if (clip.isEmpty()) return true;
+
+    const uint32_t first = info.image + info.offsetOf(clip.h1, clip.v1);
+    const uint32_t last  = info.image + info.offsetOf(clip.h2 - 1, clip.v2 - 1);
+
+    if (!mayDraw(first, last)) return false;
+
+    result = readSpan(first, last - first + 1);
+
+    const unsigned int ppb  = info.pixelsPerByte();
+    const unsigned int bits = 8 / ppb;
+    const unsigned int pixel_mask = (1 << bits) - 1;
+    const unsigned int pixel = b & pixel_mask;
+
+    for (int v = clip.v1 ; v < clip.v2 ; ++v) {
+        for (int h = clip.h1 ; h < clip.h2 ; ++h) {
+            const unsigned int shift = (ppb - 1 - (h - info.bounds.h1) % ppb) * bits;
+
+            uint8_t& out = result.bytes[info.image + info.offsetOf(h, v) - first];
+            const unsigned int old = (out >> shift) & pixel_mask;
+            unsigned int val;
+
+            switch (mode) {
+                case 0:  val = pixel;        break;  // modeCopy
+                case 1:  val = old | pixel;  break;  // modeOR
+                case 2:  val = old ^ pixel;  break;  // modeXOR
+                default: val = old & ~pixel; break;  // modeBIC
+            }
+
+            out = (out & ~(pixel_mask << shift)) | ((val & pixel_mask) << shift);
+        }
+    }
+
+    return true;
+}
+
+bool QuickDrawHLE::toolCall(const uint16_t function, const uint32_t return_ea)
+{
+    M65816::Processor *cpu = system->cpu;
+
+    switch (function) {
+        case kQDStartUp:
+            // See whether it worked once it returns (it takes 8 bytes of
+            // parameters); if that can't be watched, stay out of the way.
+            started = false;
+            direct_page = readWord(stackAddress(7));
+
+            system->watchToolReturn(this, function, return_ea, cpu->S.W + 8);
+
+            return false;
+
+        case kQDShutDown:
+            started = false;
+
+            return false;
+
+        case kSetPort:
+            // Look for where the port ended up once it returns
+            if (started) {
+                new_port = readLong(stackAddress(1)) & 0xFFFFFF;
+
+                system->watchToolReturn(this, function, return_ea, cpu->S.W + 4);
+            }
+
+            return false;
+
+        case kHideCursor:
+            // A patched HideCursor might not hide it
+            if (functionEntry(function) >= kROMStart) --cursor_level;
+
+            return false;
+
+        case kShowCursor:
+            if ((functionEntry(function) >= kROMStart) && (cursor_level < 0)) {
+                ++cursor_level;
+            }
+            else {
+                cursor_level = 0;
+            }
+
+            return false;
+
+        case kInitCursor:
+            cursor_level = 0;
+
+            return false;
+
+        case kPaintRect:
+        case kEraseRect:
+        case kPaintPixels:
+            break;
+
+        default:
+            ++calls_unhandled;
+
+            return false;
+    }
+
+    // The only parameter is a pointer to the PaintParam record or the
+    // rectangle
+    const uint32_t params = readLong(stackAddress(1)) & 0xFFFFFF;
+    Span result;
+    bool native = started && isFromStartUp(function);
+
+    if (native) {
+        native = (function == kPaintPixels)? paintPixels(params, result) : fillRect(params, function == kEraseRect, result);
+    }
+
+    if (!native) {
+        ++rom_fallbacks;
+
+        return false;
+    }
+
+    if (compare) {
+        watchResult(function, return_ea, 4, { result });
+
+        return false;
+    }
+
+    writeSpan(result);
+    returnNoError(4);
+
+    return true;
+}
+
+void QuickDrawHLE::toolReturn(const uint16_t function)
+{
+    M65816::Processor *cpu = system->cpu;
+
+    switch (function) {
+        case kQDStartUp:
+            started = !cpu->SR.C;
+
+            start_entries.clear();
+            port_offsets.clear();
+            last_port = 0;
+            ports_seen = 0;
+            cursor_level = 0;
+
+            if (started) {
+                for (const uint16_t native : { kPaintRect, kEraseRect, kPaintPixels }) {
+                    start_entries[native] = functionEntry(native);
+                }
+            }
+
+            break;
+
+        case kSetPort:
+            learnPort();
+
+            break;
+
+        case kPaintRect:
+            checkExpected("PaintRect");
+
+            break;
+
+        case kEraseRect:
+            checkExpected("EraseRect");
+
+            break;
+
+        default:
+            checkExpected("PaintPixels");
+
+            break;
+    }
+}
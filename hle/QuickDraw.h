@@ -0,0 +1,136 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef QUICKDRAW_H_
+#define QUICKDRAW_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "ToolSet.h"
+
+/**
+ * High-level emulation of selected QuickDraw II calls.
+ */
+class QuickDrawHLE : public ToolSetHLE {
+    private:
+        static constexpr unsigned int kToolSet = 0x04;
+
+        static constexpr uint16_t kQDStartUp    = 0x0204;
+        static constexpr uint16_t kQDShutDown   = 0x0304;
+        static constexpr uint16_t kSetPort      = 0x1B04;
+        static constexpr uint16_t kPaintRect    = 0x5404;
+        static constexpr uint16_t kEraseRect    = 0x5504;
+        static constexpr uint16_t kPaintPixels  = 0x7F04;
+        static constexpr uint16_t kHideCursor   = 0x9004;
+        static constexpr uint16_t kShowCursor   = 0x9104;
+        static constexpr uint16_t kInitCursor   = 0xCA04;
+
+        // Size of QuickDraw II's direct page
+        static constexpr unsigned int kDirectPageSize = 0x300;
+
+        // Offsets of the GrafPort fields used here
+        static constexpr unsigned int kPortInfo  = 0x00;
+        static constexpr unsigned int kPortRect  = 0x10;
+        static constexpr unsigned int kClipRgn   = 0x18;
+        static constexpr unsigned int kVisRgn    = 0x1C;
+        static constexpr unsigned int kBkPat     = 0x20;
+        static constexpr unsigned int kPnMode    = 0x48;
+        static constexpr unsigned int kPnPat     = 0x4A;
+        static constexpr unsigned int kPnMask    = 0x6A;
+        static constexpr unsigned int kPnVis     = 0x72;
+        static constexpr unsigned int kPicSave   = 0x90;
+        static constexpr unsigned int kRgnSave   = 0x94;
+        static constexpr unsigned int kPolySave  = 0x98;
+        static constexpr unsigned int kGrafProcs = 0x9C;
+
+        struct Rect {
+            int16_t v1, h1, v2, h2;
+
+            bool isEmpty() const { return (v2 <= v1) || (h2 <= h1); }
+
+            bool contains(const Rect& r) const
+            {
+                return (r.v1 >= v1) && (r.h1 >= h1) && (r.v2 <= v2) && (r.h2 <= h2);
+            }
+
+            Rect intersect(const Rect& r) const
+            {
+                return {
+                    std::max(v1, r.v1), std::max(h1, r.h1),
+                    std::min(v2, r.v2), std::min(h2, r.h2)
+                };
+            }
+        };
+
+        struct LocInfo {
+            uint16_t scb;
+            uint32_t image;
+            uint16_t width;
+            Rect     bounds;
+
+            unsigned int pixelsPerByte() const { return (scb & 0x80)? 4 : 2; }
+
+            // Offset into the image of the byte holding pixel h,v
+            uint32_t offsetOf(const int h, const int v) const
+            {
+                return (v - bounds.v1) * width + (h - bounds.h1) / pixelsPerByte();
+            }
+        };
+
+        // True between a successful QDStartUp and QDShutDown
+        bool started = false;
+
+        // Entries in QuickDraw II's function pointer table for the calls
+        // done natively when it was started, so that patches can be
+        // detected
+        std::map<uint16_t, uint32_t> start_entries;
+
+        // QuickDraw II's direct page, as passed to QDStartUp
+        uint16_t direct_page = 0;
+
+        // Offsets in the direct page that have held the current port after
+        // every SetPort so far, and how many different ports that was
+        std::vector<uint16_t> port_offsets;
+        uint32_t last_port = 0;
+        unsigned int ports_seen = 0;
+
+        // The port a watched SetPort is setting
+        uint32_t new_port = 0;
+
+        // Cursor level (as kept by HideCursor and ShowCursor) as far as
+        // the calls seen go; the cursor is taken to be showing unless
+        // this is negative.
+        int cursor_level = 0;
+
+        Rect     readRect(const uint32_t);
+        LocInfo  readLocInfo(const uint32_t);
+
+        bool isFromStartUp(const uint16_t);
+        uint32_t currentPort();
+        bool regionRect(const uint32_t, Rect&);
+        bool mayDraw(const uint32_t, const uint32_t);
+        void learnPort();
+
+        bool paintPixels(const uint32_t, Span&);
+        bool fillRect(const uint32_t, const bool, Span&);
+
+    public:
+        QuickDrawHLE(const bool compare_mode) : ToolSetHLE("QuickDraw HLE", kToolSet, compare_mode) {}
+        ~QuickDrawHLE() = default;
+
+        void reset();
+
+        bool toolCall(const uint16_t, const uint32_t);
+        void toolReturn(const uint16_t);
+};
+
+#endif // QUICKDRAW_H_
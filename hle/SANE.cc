@@ -0,0 +1,589 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+/*
+ * This class implements high-level emulation of SANE.
+ *
+ * Every SANE operation that rounds or raises an exception has to leave
+ * the exception flags in SANE's environment word exactly as the ROM
+ * would, and has to honor the rounding direction and precision set there.
+ * That word lives in SANE's own direct page, whose layout isn't
+ * documented, so what's done natively is limited to the FP816 operations
+ * that never depend on or change the environment:
+ *
+ * - FOZ2X, converting integer, comp, single, double, and extended values
+ *   to extended. These are always exact, except for NaNs (which can
+ *   signal) and single and double denormals, which go to the ROM.
+ * - FONEG and FOABS, which only touch the sign of an extended value.
+ * - FOADD, FOSUB, FOMUL, and FODIV of finite values whose exact result
+ *   fits in a single. No rounding direction or precision can change such
+ *   a result, and it can't be inexact, overflow, or underflow. The rest
+ *   go to the ROM, as do sums that come out to zero (whose sign depends
+ *   on the rounding direction) and division by zero.
+ * - FOCMP of finite values, which never raises an exception. FP816
+ *   returns the outcome in the registers, so the first comparison with
+ *   each outcome is left to the ROM and the registers it comes back with
+ *   are recorded; later comparisons with the same outcome return those.
+ *
+ * Loads and simple arithmetic on integral values start nearly every
+ * calculation, so they make up a good share of the calls a SANE-heavy
+ * program makes. They are only done between a successful SANEStartUp and
+ * the matching SANEShutDown, and only while FP816 is the ROM's.
+ */
+
+#include <algorithm>
+
+#include "SANE.h"
+
+#include "emulator/System.h"
+#include "M65816/Processor.h"
+
+static constexpr uint64_t kIntegerBit = 0x8000000000000000ULL;
+
+static constexpr uint16_t kExponentBias = 16383;
+
+void SANEHLE::reset()
+{
+    ToolSetHLE::reset();
+
+    started  = false;
+    learning = kNoRelation;
+}
+
+/**
+ * Convert a nonzero integer of magnitude m to extended.
+ */
+static void normalize(const bool negative, uint64_t m, uint64_t& significand, uint16_t& sign_exponent)
+{
+    unsigned int exponent = kExponentBias + 63;
+
+    while (!(m & kIntegerBit)) {
+        m <<= 1;
+
+        --exponent;
+    }
+
+    significand   = m;
+    sign_exponent = (negative? 0x8000 : 0) | exponent;
+}
+
+/**
+ * Read a value of the given format at addr, converted to extended.
+ * Returns false if the conversion isn't one that's always exact.
+ */
+bool SANEHLE::toExtended(const uint32_t addr, const unsigned int format, Extended& value)
+{
+    switch (format) {
+        case kInteger: {
+            if (!isPlainMemory(addr, 2)) return false;
+
+            const int16_t i = readWord(addr);
+
+            if (!i) {
+                value = { 0, 0 };
+            }
+            else {
+                normalize(i < 0, (i < 0)? -static_cast<int32_t>(i) : i, value.significand, value.sign_exponent);
+            }
+
+            return true;
+        }
+
+        case kComp: {
+            if (!isPlainMemory(addr, 8)) return false;
+
+            const int64_t c = readLong(addr) | (static_cast<uint64_t>(readLong(addr + 4)) << 32);
+
+            // The most negative comp is its NaN
+            if (c == INT64_MIN) return false;
+
+            if (!c) {
+                value = { 0, 0 };
+            }
+            else {
+                normalize(c < 0, (c < 0)? -c : c, value.significand, value.sign_exponent);
+            }
+
+            return true;
+        }
+
+        case kSingle:
+        case kDouble: {
+            // Field sizes for single and double
+            const bool         is_double = format == kDouble;
+            const unsigned int size      = is_double? 8 : 4;
+            const unsigned int frac_bits = is_double? 52 : 23;
+            const unsigned int max_exp   = is_double? 0x7FF : 0xFF;
+            const unsigned int bias      = is_double? 1023 : 127;
+
+            if (!isPlainMemory(addr, size)) return false;
+
+            const uint64_t bits = is_double? (readLong(addr) | (static_cast<uint64_t>(readLong(addr + 4)) << 32)) : readLong(addr);
+            const bool     sign = (bits >> (size * 8 - 1)) & 1;
+            const unsigned int exponent = (bits >> frac_bits) & max_exp;
+            const uint64_t fraction = bits & ((static_cast<uint64_t>(1) << frac_bits) - 1);
+            const uint16_t sign_bit = sign? 0x8000 : 0;
+
+            if (!exponent) {
+                // Denormals are left to the ROM
+                if (fraction) return false;
+
+                value = { 0, sign_bit };
+            }
+            else if (exponent == max_exp) {
+                // As are NaNs
+                if (fraction) return false;
+
+                value = { kIntegerBit, static_cast<uint16_t>(sign_bit | 0x7FFF) };
+            }
+            else {
+                value.significand   = kIntegerBit | (fraction << (63 - frac_bits));
+                value.sign_exponent = sign_bit | (exponent - bias + kExponentBias);
+            }
+
+            return true;
+        }
+
+        case kExtended: {
+            if (!isPlainMemory(addr, 10)) return false;
+
+            value.significand   = readLong(addr) | (static_cast<uint64_t>(readLong(addr + 4)) << 32);
+            value.sign_exponent = readWord(addr + 8);
+
+            const uint16_t exponent = value.sign_exponent & 0x7FFF;
+
+            // NaNs, and unnormals that may get normalized on the way
+            if ((exponent == 0x7FFF) && (value.significand & ~kIntegerBit)) return false;
+            if (exponent && !(value.significand & kIntegerBit)) return false;
+
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * A finite value as (-1)^negative * m * 2^exponent, with m odd unless the
+ * value is zero.
+ */
+struct Exact {
+    bool     negative;
+    uint64_t m;
+    int      exponent;
+};
+
+static unsigned int bitLength(uint64_t m)
+{
+    unsigned int bits = 0;
+
+    while (m) {
+        m >>= 1;
+
+        ++bits;
+    }
+
+    return bits;
+}
+
+// Shift the trailing zero bits of a nonzero value into its exponent
+static void trim(Exact& e)
+{
+    while (!(e.m & 1)) {
+        e.m >>= 1;
+
+        ++e.exponent;
+    }
+}
+
+static Exact toExact(const uint64_t significand, const uint16_t sign_exponent)
+{
+    const int biased = sign_exponent & 0x7FFF;
+    Exact e;
+
+    // Denormals share the exponent of the smallest normal
+    e.negative = sign_exponent & 0x8000;
+    e.m        = significand;
+    e.exponent = (biased? biased : 1) - kExponentBias - 63;
+
+    if (e.m) trim(e);
+
+    return e;
+}
+
+/**
+ * Convert an exact result to extended. Returns false unless it fits in a
+ * single, so that no rounding precision or direction could change it.
+ */
+static bool fromExact(const Exact& e, uint64_t& significand, uint16_t& sign_exponent)
+{
+    const uint16_t sign_bit = e.negative? 0x8000 : 0;
+
+    if (!e.m) {
+        significand   = 0;
+        sign_exponent = sign_bit;
+
+        return true;
+    }
+
+    // The power of two of the leading bit, which has to be in the range
+    // of a normal single
+    const unsigned int bits = bitLength(e.m);
+    const int leading = e.exponent + static_cast<int>(bits) - 1;
+
+    if ((bits > 24) || (leading < -126) || (leading > 127)) return false;
+
+    significand   = e.m << (64 - bits);
+    sign_exponent = sign_bit | (leading + kExponentBias);
+
+    return true;
+}
+
+/**
+ * Work out dst + src, dst - src, dst * src, or dst / src. Returns false if
+ * either operand isn't finite or the result can't be done exactly.
+ */
+bool SANEHLE::arithmetic(const uint8_t op, const Extended& dst, const Extended& src, Extended& result)
+{
+    if (((dst.sign_exponent & 0x7FFF) == 0x7FFF) || ((src.sign_exponent & 0x7FFF) == 0x7FFF)) return false;
+
+    const Exact a = toExact(dst.significand, dst.sign_exponent);
+    Exact b = toExact(src.significand, src.sign_exponent);
+    Exact r;
+
+    switch (op) {
+        case kFOSUB:
+            b.negative = !b.negative;
+
+            // fall through
+        case kFOADD:
+            if (!b.m) {
+                // Zeros of opposite signs add up to +0, or -0 when
+                // rounding down
+                if (!a.m && (a.negative != b.negative)) return false;
+
+                r = a;
+            }
+            else if (!a.m) {
+                r = b;
+            }
+            else {
+                // Line both up with the lower exponent. If either takes
+                // more than 62 bits the sum can't fit in a single anyway.
+                const int low = std::min(a.exponent, b.exponent);
+                const unsigned int a_shift = a.exponent - low;
+                const unsigned int b_shift = b.exponent - low;
+
+                if ((bitLength(a.m) + a_shift > 62) || (bitLength(b.m) + b_shift > 62)) return false;
+
+                const int64_t a_value = static_cast<int64_t>(a.m << a_shift);
+                const int64_t b_value = static_cast<int64_t>(b.m << b_shift);
+                const int64_t sum = (a.negative? -a_value : a_value) + (b.negative? -b_value : b_value);
+
+                // The sign of a zero sum depends on the rounding direction
+                if (!sum) return false;
+
+                r.negative = sum < 0;
+                r.m        = (sum < 0)? -sum : sum;
+                r.exponent = low;
+
+                trim(r);
+            }
+
+            break;
+
+        case kFOMUL:
+            r.negative = a.negative != b.negative;
+            r.m        = 0;
+            r.exponent = 0;
+
+            if (a.m && b.m) {
+                if (bitLength(a.m) + bitLength(b.m) > 64) return false;
+
+                // The product of two odd numbers is odd
+                r.m        = a.m * b.m;
+                r.exponent = a.exponent + b.exponent;
+            }
+
+            break;
+
+        case kFODIV:
+            // Division by zero raises an exception
+            if (!b.m) return false;
+
+            r.negative = a.negative != b.negative;
+            r.m        = 0;
+            r.exponent = 0;
+
+            if (a.m) {
+                if (a.m % b.m) return false;
+
+                r.m        = a.m / b.m;
+                r.exponent = a.exponent - b.exponent;
+            }
+
+            break;
+
+        default:
+            return false;
+    }
+
+    return fromExact(r, result.significand, result.sign_exponent);
+}
+
+/**
+ * Compare two non-NaN extended values, returning a negative number, zero,
+ * or a positive number as a is less than, equal to, or greater than b.
+ */
+static int compareExtended(const uint64_t a_significand, const uint16_t a_sign_exponent, const uint64_t b_significand, const uint16_t b_sign_exponent)
+{
+    const bool a_negative = a_sign_exponent & 0x8000;
+    const bool b_negative = b_sign_exponent & 0x8000;
+
+    // +0 and -0 are equal
+    if (!a_significand && !b_significand) return 0;
+
+    if (a_negative != b_negative) return a_negative? -1 : 1;
+
+    // Magnitudes order the same way as exponent then significand, since
+    // unnormals have been ruled out
+    const uint16_t a_exponent = a_sign_exponent & 0x7FFF;
+    const uint16_t b_exponent = b_sign_exponent & 0x7FFF;
+    int magnitude = 0;
+
+    if (a_exponent != b_exponent) {
+        magnitude = (a_exponent < b_exponent)? -1 : 1;
+    }
+    else if (a_significand != b_significand) {
+        magnitude = (a_significand < b_significand)? -1 : 1;
+    }
+
+    return a_negative? -magnitude : magnitude;
+}
+
+SANEHLE::Span SANEHLE::extendedSpan(const uint32_t addr, const Extended& value)
+{
+    Span span = valueSpan(addr, value.significand, 8);
+
+    span.bytes.push_back(value.sign_exponent);
+    span.bytes.push_back(value.sign_exponent >> 8);
+
+    return span;
+}
+
+/**
+ * Work out what an FP816 call would leave in memory, and how many bytes
+ * of parameters it pulls off the stack. For FOCMP, relation is set to
+ * the outcome. Returns false if the operation isn't one that can be done
+ * natively.
+ */
+bool SANEHLE::perform(std::vector<Span>& result, unsigned int& param_bytes, int& relation)
+{
+    // The opword is pushed last, after the destination operand's address
+    // and (for two-operand operations) the source's
+    const uint16_t opword = readWord(stackAddress(1));
+    const uint32_t dst    = readLong(stackAddress(3)) & 0xFFFFFF;
+
+    if ((opword & 0xF800) || !isPlainMemory(dst, 10)) return false;
+
+    switch (opword & 0xFF) {
+        case kFOZ2X: {
+            Extended value;
+
+            if (!toExtended(readLong(stackAddress(7)) & 0xFFFFFF, opword >> 8, value)) return false;
+
+            result.push_back(extendedSpan(dst, value));
+            param_bytes = 10;
+
+            return true;
+        }
+
+        case kFOADD:
+        case kFOSUB:
+        case kFOMUL:
+        case kFODIV: {
+            Extended a, b, value;
+
+            if (!toExtended(dst, kExtended, a) || !toExtended(readLong(stackAddress(7)) & 0xFFFFFF, opword >> 8, b)) return false;
+            if (!arithmetic(opword & 0xFF, a, b, value)) return false;
+
+            result.push_back(extendedSpan(dst, value));
+            param_bytes = 10;
+
+            return true;
+        }
+
+        case kFOCMP: {
+            Extended a, b;
+
+            if (!toExtended(dst, kExtended, a) || !toExtended(readLong(stackAddress(7)) & 0xFFFFFF, opword >> 8, b)) return false;
+            if (((a.sign_exponent & 0x7FFF) == 0x7FFF) || ((b.sign_exponent & 0x7FFF) == 0x7FFF)) return false;
+
+            const int order = compareExtended(a.significand, a.sign_exponent, b.significand, b.sign_exponent);
+
+            relation    = (order < 0)? kLess : (order > 0)? kGreater : kEqual;
+            param_bytes = 10;
+
+            return true;
+        }
+
+        case kFONEG:
+        case kFOABS: {
+            if (opword & 0xFF00) return false;
+
+            const uint16_t sign_exponent = readWord(dst + 8);
+
+            result.push_back(valueSpan(dst + 8, ((opword & 0xFF) == kFONEG)? (sign_exponent ^ 0x8000) : (sign_exponent & 0x7FFF), 2));
+            param_bytes = 6;
+
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * Work out the registers FOCMP returns with for an outcome that has been
+ * learned, given the ones it was called with.
+ */
+void SANEHLE::comparisonRegisters(const int relation, uint16_t& a, uint16_t& x, uint16_t& y, uint8_t& p) const
+{
+    const Comparison& c = comparisons[relation];
+
+    a = c.a;
+
+    if (!c.x_kept) x = c.x;
+    if (!c.y_kept) y = c.y;
+
+    p = (p & ~kComparisonFlags) | c.flags;
+}
+
+bool SANEHLE::toolCall(const uint16_t function, const uint32_t return_ea)
+{
+    M65816::Processor *cpu = system->cpu;
+
+    switch (function) {
+        case kSANEStartUp:
+            // See whether it worked once it returns (it takes the direct
+            // page address as its only parameter)
+            started = false;
+
+            system->watchToolReturn(this, function, return_ea, cpu->S.W + 2);
+
+            return false;
+
+        case kSANEShutDown:
+            started = false;
+
+            return false;
+
+        case kFP816:
+            break;
+
+        default:
+            ++calls_unhandled;
+
+            return false;
+    }
+
+    std::vector<Span> result;
+    unsigned int param_bytes;
+    int relation = kNoRelation;
+
+    if (!started || ((functionEntry(function) & 0xFFFFFF) < kROMStart) || !perform(result, param_bytes, relation)) {
+        ++rom_fallbacks;
+
+        return false;
+    }
+
+    // Let the ROM show which registers this outcome of FOCMP comes back
+    // with
+    if ((relation != kNoRelation) && !comparisons[relation].learned) {
+        if (system->watchToolReturn(this, function, return_ea, cpu->S.W + param_bytes)) {
+            learning   = relation;
+            learning_x = cpu->X.W;
+            learning_y = cpu->Y.W;
+            learning_p = cpu->SR;
+        }
+
+        ++rom_fallbacks;
+
+        return false;
+    }
+
+    if (compare) {
+        if (watchResult(function, return_ea, param_bytes, std::move(result)) && (relation != kNoRelation)) {
+            expected_registers.p = cpu->SR;
+
+            comparisonRegisters(relation, expected_registers.a, expected_registers.x, expected_registers.y, expected_registers.p);
+        }
+
+        return false;
+    }
+
+    for (const Span& span : result) {
+        writeSpan(span);
+    }
+
+    if (relation == kNoRelation) {
+        returnNoError(param_bytes);
+    }
+    else {
+        uint16_t a, x = cpu->X.W, y = cpu->Y.W;
+        uint8_t  p = cpu->SR;
+
+        comparisonRegisters(relation, a, x, y, p);
+
+        cpu->S.W += param_bytes;
+        cpu->A.W  = a;
+        cpu->X.W  = x;
+        cpu->Y.W  = y;
+        cpu->SR   = p;
+
+        ++calls_handled;
+    }
+
+    return true;
+}
+
+void SANEHLE::toolReturn(const uint16_t function)
+{
+    M65816::Processor *cpu = system->cpu;
+
+    if (function == kSANEStartUp) {
+        started = !cpu->SR.C;
+
+        return;
+    }
+
+    if (learning != kNoRelation) {
+        Comparison& c = comparisons[learning];
+        const uint8_t p = cpu->SR;
+
+        // Only trust a return that left the mode bits alone
+        if ((p & ~kComparisonFlags) == (learning_p & ~kComparisonFlags)) {
+            c.learned = true;
+            c.a       = cpu->A.W;
+            c.x       = cpu->X.W;
+            c.y       = cpu->Y.W;
+            c.x_kept  = cpu->X.W == learning_x;
+            c.y_kept  = cpu->Y.W == learning_y;
+            c.flags   = p & kComparisonFlags;
+        }
+
+        learning = kNoRelation;
+
+        return;
+    }
+
+    checkExpected("FP816");
+}
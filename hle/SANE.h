@@ -0,0 +1,108 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef SANE_H_
+#define SANE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "ToolSet.h"
+
+/**
+ * High-level emulation of the SANE operations that can be done without
+ * raising floating point exceptions or depending on the environment.
+ */
+class SANEHLE : public ToolSetHLE {
+    private:
+        static constexpr unsigned int kToolSet = 0x0A;
+
+        static constexpr uint16_t kSANEStartUp  = 0x020A;
+        static constexpr uint16_t kSANEShutDown = 0x030A;
+        static constexpr uint16_t kFP816        = 0x090A;
+
+        // FP816 operation codes, in the low byte of the opword
+        static constexpr uint8_t kFOADD = 0x00;
+        static constexpr uint8_t kFOSUB = 0x02;
+        static constexpr uint8_t kFOMUL = 0x04;
+        static constexpr uint8_t kFODIV = 0x06;
+        static constexpr uint8_t kFOCMP = 0x08;
+        static constexpr uint8_t kFOZ2X = 0x0E;
+        static constexpr uint8_t kFONEG = 0x0D;
+        static constexpr uint8_t kFOABS = 0x0F;
+
+        // The flags FOCMP can return its result in (N, V, Z and C)
+        static constexpr uint8_t kComparisonFlags = 0xC3;
+
+        // Source operand formats, in bits 8-10 of the opword
+        enum Format {
+            kExtended = 0,
+            kDouble   = 1,
+            kSingle   = 2,
+            kInteger  = 4,
+            kComp     = 5
+        };
+
+        // An extended (80-bit) value, as SANE stores it
+        struct Extended {
+            uint64_t significand;
+            uint16_t sign_exponent;
+        };
+
+        // Outcomes of FOCMP
+        enum Relation {
+            kNoRelation = -1,
+            kLess       = 0,
+            kEqual      = 1,
+            kGreater    = 2
+        };
+
+        // The registers the ROM's FP816 returned for one outcome of FOCMP,
+        // and whether X and Y came back as they went in
+        struct Comparison {
+            bool     learned = false;
+            uint16_t a;
+            uint16_t x;
+            uint16_t y;
+            bool     x_kept;
+            bool     y_kept;
+            uint8_t  flags;
+        };
+
+        Comparison comparisons[3];
+
+        // The FOCMP outcome the ROM is being watched for, and the
+        // registers it was called with
+        int learning = kNoRelation;
+        uint16_t learning_x;
+        uint16_t learning_y;
+        uint8_t  learning_p;
+
+        // True between a successful SANEStartUp and SANEShutDown
+        bool started = false;
+
+        bool toExtended(const uint32_t, const unsigned int, Extended&);
+        Span extendedSpan(const uint32_t, const Extended&);
+
+        bool arithmetic(const uint8_t, const Extended&, const Extended&, Extended&);
+        bool perform(std::vector<Span>&, unsigned int&, int&);
+
+        void comparisonRegisters(const int, uint16_t&, uint16_t&, uint16_t&, uint8_t&) const;
+
+    public:
+        SANEHLE(const bool compare_mode) : ToolSetHLE("SANE HLE", kToolSet, compare_mode) {}
+        ~SANEHLE() = default;
+
+        void reset();
+
+        bool toolCall(const uint16_t, const uint32_t);
+        void toolReturn(const uint16_t);
+};
+
+#endif // SANE_H_
@@ -0,0 +1,156 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#include <iostream>
+
+#include <boost/format.hpp>
+
+#include "ToolSet.h"
+
+#include "emulator/System.h"
+#include "M65816/Processor.h"
+
+using std::cerr;
+using boost::format;
+
+void ToolSetHLE::reset()
+{
+    expected.clear();
+}
+
+void ToolSetHLE::attach(System *theSystem)
+{
+    Device::attach(theSystem);
+
+    system->setToolHandler(toolset, this);
+}
+
+uint32_t ToolSetHLE::stackAddress(const unsigned int offset)
+{
+    // The stack is always in bank 0
+    return static_cast<uint16_t>(system->cpu->S.W + offset);
+}
+
+/**
+ * Returns the entry for one of the tool set's functions in the system
+ * tool pointer table, or 0 if there isn't one.
+ */
+uint32_t ToolSetHLE::functionEntry(const uint16_t function)
+{
+    const uint32_t tpt = readLong(kSystemTPT) & 0xFFFFFF;
+
+    if (!tpt || (readLong(tpt) < toolset)) return 0;
+
+    const uint32_t fpt = readLong(tpt + toolset * 4) & 0xFFFFFF;
+    const unsigned int number = function >> 8;
+
+    if (!fpt || (readLong(fpt) < number)) return 0;
+
+    return readLong(fpt + number * 4);
+}
+
+ToolSetHLE::Span ToolSetHLE::valueSpan(const uint32_t start, const uint64_t value, const unsigned int size)
+{
+    Span span;
+
+    span.start = start;
+
+    for (unsigned int i = 0 ; i < size ; ++i) {
+        span.bytes.push_back(value >> (i * 8));
+    }
+
+    return span;
+}
+
+void ToolSetHLE::returnNoError(const unsigned int param_bytes)
+{
+    M65816::Processor *cpu = system->cpu;
+
+    cpu->S.W += param_bytes;
+    cpu->A.W  = 0;
+    cpu->SR.C = false;
+    cpu->SR.setN(false);
+    cpu->SR.setZ(true);
+
+    ++calls_handled;
+}
+
+bool ToolSetHLE::watchResult(const uint16_t function, const uint32_t return_ea, const unsigned int param_bytes, std::vector<Span>&& result)
+{
+    M65816::Processor *cpu = system->cpu;
+
+    if (!system->watchToolReturn(this, function, return_ea, cpu->S.W + param_bytes)) return false;
+
+    expected = std::move(result);
+
+    // As returnNoError() would leave them: A = 0, with N and C clear and
+    // Z set
+    expected_registers.a = 0;
+    expected_registers.x = cpu->X.W;
+    expected_registers.y = cpu->Y.W;
+    expected_registers.p = (static_cast<uint8_t>(cpu->SR) & ~0x81) | 0x02;
+
+    return true;
+}
+
+void ToolSetHLE::checkExpected(const char *call)
+{
+    M65816::Processor *cpu = system->cpu;
+    const uint8_t p = cpu->SR;
+
+    ++calls_compared;
+
+    // C is how tool calls report errors, unless the call is expected to
+    // return a result in it
+    if (cpu->SR.C && !(expected_registers.p & 0x01)) {
+        cerr << format("%s: ROM %s failed with error $%04X\n") % name % call % cpu->A.W;
+
+        ++mismatches;
+    }
+    else if ((cpu->A.W != expected_registers.a) || (cpu->X.W != expected_registers.x) || (cpu->Y.W != expected_registers.y) || (p != expected_registers.p)) {
+        cerr << format("%s: %s returned A=%04X X=%04X Y=%04X P=%02X from ROM, HLE A=%04X X=%04X Y=%04X P=%02X\n")
+                    % name % call % cpu->A.W % cpu->X.W % cpu->Y.W % (unsigned int) p
+                    % expected_registers.a % expected_registers.x % expected_registers.y % (unsigned int) expected_registers.p;
+
+        ++mismatches;
+    }
+    else {
+        for (const Span& span : expected) {
+            const Span actual = readSpan(span.start, span.bytes.size());
+            uint32_t i = 0;
+
+            while ((i < span.bytes.size()) && (actual.bytes[i] == span.bytes[i])) ++i;
+
+            if (i < span.bytes.size()) {
+                const uint32_t ea = span.start + i;
+
+                cerr << format("%s: %s differs from ROM at %02X/%04X (ROM $%02X, HLE $%02X)\n")
+                            % name % call % (ea >> 16) % (ea & 0xFFFF) % (unsigned int) actual.bytes[i] % (unsigned int) span.bytes[i];
+
+                ++mismatches;
+
+                break;
+            }
+        }
+    }
+
+    expected.clear();
+}
+
+void ToolSetHLE::writeStats(std::ostream& out) const
+{
+    if (compare) {
+        out << format("%s: compared %d calls, %d mismatches") % name % calls_compared % mismatches;
+    }
+    else {
+        out << format("%s: handled %d calls") % name % calls_handled;
+    }
+
+    out << format(", %d fell back to the ROM, %d not handled\n") % rom_fallbacks % calls_unhandled;
+}
@@ -0,0 +1,112 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+#ifndef TOOLSET_H_
+#define TOOLSET_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "HLEDevice.h"
+
+/**
+ * Base class for devices doing high-level emulation of a tool set. The
+ * CPU offers the device every call to its tool set made through the tool
+ * dispatcher (see System::setToolHandler()), and calls that can be done
+ * natively are performed directly on memory instead of running the ROM
+ * code.
+ *
+ * In compare mode nothing is done natively; instead a subclass works out
+ * the memory the call should leave behind as a list of spans, lets the
+ * ROM do the call (see watchResult()), and checks the two against each
+ * other with checkExpected() when the call returns. The registers the ROM
+ * returns with are checked against the ones returnNoError() would leave
+ * as well.
+ */
+class ToolSetHLE : public HLEDevice {
+    protected:
+        // Location of the pointer to the system tool pointer table
+        static constexpr uint32_t kSystemTPT = 0xE103C0;
+
+        // The built-in tool sets live in the ROM banks unless patched
+        static constexpr uint32_t kROMStart = 0xFC0000;
+
+        // Name used in messages
+        const std::string name;
+
+        const unsigned int toolset;
+
+        bool compare;
+
+        // What the call being compared against the ROM should leave in
+        // memory
+        std::vector<Span> expected;
+
+        // And the registers it should return with (which a subclass can
+        // change after watchResult() for calls that return results in
+        // them)
+        struct {
+            uint16_t a;
+            uint16_t x;
+            uint16_t y;
+            uint8_t  p;
+        } expected_registers;
+
+        unsigned long calls_handled = 0;
+        unsigned long calls_compared = 0;
+        unsigned long mismatches = 0;
+
+        // Calls to functions this device can do that were left to the ROM
+        // anyway (patched entries, or parameters it couldn't vouch for)
+        unsigned long rom_fallbacks = 0;
+
+        // Calls to functions this device never does natively
+        unsigned long calls_unhandled = 0;
+
+        // Address of a parameter on the stack of a call, counting
+        // offset bytes up from the top of the stack
+        uint32_t stackAddress(const unsigned int offset);
+
+        uint32_t functionEntry(const uint16_t);
+
+        // A span holding a little-endian value of size bytes
+        static Span valueSpan(const uint32_t, const uint64_t, const unsigned int);
+
+        // Finish a call done natively, pulling its parameters
+        void returnNoError(const unsigned int);
+
+        // Let the ROM do a call that would have been done natively, and
+        // have checkExpected() called when it returns. Returns false if
+        // the return can't be watched.
+        bool watchResult(const uint16_t, const uint32_t, const unsigned int, std::vector<Span>&&);
+
+        // Check the memory left by the ROM against expected
+        void checkExpected(const char *);
+
+    public:
+        ToolSetHLE(const std::string& hle_name, const unsigned int hle_toolset, const bool compare_mode)
+            : name(hle_name), toolset(hle_toolset), compare(compare_mode) {}
+        virtual ~ToolSetHLE() = default;
+
+        virtual void reset();
+
+        void attach(System *theSystem);
+
+        unsigned long getCallsHandled() const { return calls_handled; }
+        unsigned long getCallsCompared() const { return calls_compared; }
+        unsigned long getMismatches() const { return mismatches; }
+        unsigned long getROMFallbacks() const { return rom_fallbacks; }
+        unsigned long getCallsUnhandled() const { return calls_unhandled; }
+
+        void writeStats(std::ostream&) const;
+};
+
+#endif // TOOLSET_H_
@@ -83,6 +83,13 @@ class Mega2 : public Device {
             return locs;
         }
 
+        std::vector<unsigned int>& ioPollList()
+        {
+            static std::vector<unsigned int> locs = { 0x19 };
+
+            return locs;
+        }
+
     public:
         bool sw_fastmode;
 
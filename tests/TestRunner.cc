@@ -71,35 +71,64 @@ bool TestRunner::setup(const int argc, const char** argv)
     sys->installMemory(ram, 0, ram_pages, FAST);
     sys->installMemory(ram + 0xFF00, 0xFFFF, 1, FAST); // hack until we fix the forcing of vector reads to page FFFF
     sys->installDebugger(dbg);
+
+    for (unsigned int page = 0 ; bank && (page < 256) ; ++page) {
+        sys->mapRead((bank << 8) | page, page);
+        sys->mapWrite((bank << 8) | page, page);
+    }
+
     sys->reset();
 
+    cpu->setCore((cpu_core == "threaded")? M65816::THREADED : M65816::INTERPRETER);
+
     return true;
 }
 
-void TestRunner::run()
+bool TestRunner::run()
 {
-    cpu->PBR = start_address >> 16;
+    cpu->PBR = bank;
+    cpu->DBR = bank;
     cpu->PC  = start_address & 0xFFFF;
 
     while (true) {
-        uint8_t last_PBR = cpu->PBR;
-        uint16_t last_PC = cpu->PC;
+        cpu->runUntil(kSliceCycles);
+
+        // A trap is an instruction that branches or jumps to itself, so
+        // stepping it changes nothing. The registers are checked as well
+        // as the PC, since a fused loop like DEX; BNE can also come back
+        // to where it started in a single step.
+        const uint8_t  last_PBR = cpu->PBR;
+        const uint16_t last_PC  = cpu->PC;
+        const uint16_t last_A   = cpu->A.W;
+        const uint16_t last_X   = cpu->X.W;
+        const uint16_t last_Y   = cpu->Y.W;
+        const uint8_t  last_P   = cpu->SR;
+
+        cpu->runUntil(1);
+
+        if ((cpu->PBR == last_PBR) && (cpu->PC == last_PC) && (cpu->A.W == last_A)
+                && (cpu->X.W == last_X) && (cpu->Y.W == last_Y) && (static_cast<uint8_t>(cpu->SR) == last_P)) {
+            break;
+        }
+    }
 
-        unsigned int num_cycles = cpu->runUntil(1);
+    const uint32_t trap_address = (cpu->PBR << 16) | cpu->PC;
 
-        sys->cycle_count += num_cycles;
-        sys->vbl_count++;
+    cerr << "\nTest suite trap encountered:\n\n";
 
-        if ((cpu->PBR == last_PBR) && (cpu->PC == last_PC)) {
-            cerr << "\nTest suite trap encountered:\n\n";
+    dbg->enableTrace();
+    cpu->runUntil(1);
+    cpu->runUntil(1); // give debugger a chance to show that last instruction
 
-            dbg->enableTrace();
-            cpu->runUntil(1);
-            cpu->runUntil(1); // give debugger a chance to show that last instruction
+    if (!check_success) return true;
 
-            break;
-        }
-    }
+    // Only the address within the bank counts, since the test may leave
+    // the bank it was started in through the vectors in bank 0
+    const bool passed = (trap_address & 0xFFFF) == (success_address & 0xFFFF);
+
+    cerr << format("\nTrap at %02X/%04X: %s\n") % (trap_address >> 16) % (trap_address & 0xFFFF) % (passed? "passed" : "FAILED");
+
+    return passed;
 }
 
 /**
@@ -121,6 +150,7 @@ bool TestRunner::loadConfig(const int argc, const char **argv)
 {
     string bin_file;
     string bin_origin;
+    string success;
     unsigned int ram_size;
 
     po::options_description cli_options("Test Suite Options");
@@ -129,6 +159,9 @@ bool TestRunner::loadConfig(const int argc, const char **argv)
         ("version,v", "Print version string")
         ("file,f",   po::value<string>(&bin_file)->default_value("testsuite.bin"),  "Name of binary file to load")
         ("origin,o", po::value<string>(&bin_origin)->default_value("0x400"),        "Origin address of binary file")
+        ("success,s", po::value<string>(&success),                                  "Address of the trap that marks a successful run")
+        ("core",     po::value<string>(&cpu_core)->default_value("interp"),         "CPU core to use (interp or threaded)")
+        ("bank",     po::value<unsigned int>(&bank)->default_value(0),              "Bank to run in, mapped onto bank 0")
         ("ram",      po::value<unsigned int>(&ram_size)->default_value(64),         "Set RAM size in KB");
 
     po::variables_map vm; 
@@ -145,15 +178,23 @@ bool TestRunner::loadConfig(const int argc, const char **argv)
             po::notify(vm);
         } 
 
+        if ((cpu_core != "interp") && (cpu_core != "threaded")) {
+            throw std::runtime_error("Unknown CPU core \"" + cpu_core + "\"");
+        }
+
+        if ((bank > 0xFF) || (bank && (ram_size < 64))) {
+            throw std::runtime_error("Can't run in bank " + std::to_string(bank));
+        }
+
         ram = new uint8_t[ram_size * 1024];
         ram_pages = ram_size << 2;
 
-/*
-        std::stringstream ss;
-        ss << std::hex << bin_origin;
-        ss >> start_address;
-*/
-        start_address = 0x400;
+        start_address = std::stoul(bin_origin, nullptr, 0);
+
+        if (vm.count("success")) {
+            success_address = std::stoul(success, nullptr, 0);
+            check_success   = true;
+        }
 
         // load test suite machine code file
         unsigned int bytes = loadFile(bin_file, 65536, ram);
@@ -14,13 +14,16 @@ namespace M65816 {
 
 const unsigned int kTickRate = 60;
 
+// Cycles to run between checks for a trap
+const unsigned int kSliceCycles = 10000;
+
 class TestRunner {
     public:
         TestRunner();
         ~TestRunner();
 
         bool setup(const int, const char **);
-        void run();
+        bool run();
 
         M65816::Processor* getCpu() { return cpu; }
         System* getSys() { return sys; }
@@ -35,6 +38,17 @@ class TestRunner {
 
         uint32_t start_address;
 
+        // Address of the trap that marks a successful run, if any
+        uint32_t success_address = 0;
+        bool check_success = false;
+
+        // Bank the test runs in. Anything other than 0 is mapped onto
+        // bank 0, so the same image runs without the bank zero engine.
+        unsigned int bank = 0;
+
+        // CPU core to run the test on ("interp" or "threaded")
+        std::string cpu_core;
+
         float target_speed = 1.0;
 
         // The timer we use for scheduling
@@ -0,0 +1,1663 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+/*
+ * Focused checks of the parts of the CPU cores and HLE devices that the
+ * functional test suite doesn't reach: native mode decimal arithmetic,
+ * the block cache, superinstructions, block moves, tool call comparison,
+ * the native Memory Manager, SANE and QuickDraw II calls, the host
+ * directory volume, and taking an IRQ once I is cleared. Each check is run by name, eg.
+ *
+ * checks816 decimal
+ *
+ * and the program exits with a non-zero status if it fails.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "emulator/System.h"
+#include "hle/HostVolume.h"
+#include "hle/IntegerMath.h"
+#include "hle/MemoryManager.h"
+#include "hle/QuickDraw.h"
+#include "hle/SANE.h"
+#include "M65816/DecimalTables.h"
+#include "M65816/Processor.h"
+
+using std::cerr;
+using std::string;
+using boost::format;
+
+// Cycles to run between checks for the trap that ends a test program
+const unsigned int kSliceCycles = 10000;
+
+// Give up on a test program that hasn't trapped after this many cycles
+const unsigned long kMaxCycles = 100000000;
+
+/**
+ * A machine with RAM in every bank and nothing else, which runs a test
+ * program until it reaches a BRA * trap.
+ */
+class TestMachine {
+    public:
+        System *sys;
+        M65816::Processor *cpu;
+        uint8_t *ram;
+
+        // Devices installed with installDevice(), deleted with the machine
+        std::vector<Device *> devices;
+
+        TestMachine(const M65816::cpu_core_t core)
+        {
+            ram = new uint8_t[256 * 65536]();
+            cpu = new M65816::Processor();
+            sys = new System(false);
+
+            sys->installProcessor(cpu);
+            sys->installMemory(ram, 0, 65536, FAST);
+            sys->debugger = nullptr;
+            sys->reset();
+
+            cpu->setCore(core);
+        }
+
+        ~TestMachine()
+        {
+            delete sys;
+
+            for (Device *d : devices) delete d;
+
+            delete cpu;
+            delete [] ram;
+        }
+
+        void installDevice(const string& name, Device *d)
+        {
+            sys->installDevice(name, d);
+
+            devices.push_back(d);
+        }
+
+        void load(const uint32_t address, const std::vector<uint8_t>& code)
+        {
+            std::memcpy(ram + address, code.data(), code.size());
+        }
+
+        uint16_t word(const uint32_t address) const
+        {
+            return ram[address] | (ram[address + 1] << 8);
+        }
+
+        bool runToTrap(const uint32_t address)
+        {
+            unsigned long cycles = 0;
+
+            cpu->PBR = address >> 16;
+            cpu->PC  = address & 0xFFFF;
+
+            while (cycles < kMaxCycles) {
+                cycles += cpu->runUntil(kSliceCycles);
+
+                const uint32_t pc = (cpu->PBR << 16) | cpu->PC;
+
+                if ((ram[pc] == 0x80) && (ram[pc + 1] == 0xFE)) return true;
+            }
+
+            cerr << format("program at %06X never trapped, PC=%02X/%04X\n") % address % (unsigned int) cpu->PBR % cpu->PC;
+
+            return false;
+        }
+};
+
+/**
+ * Assembles a test program a few bytes at a time.
+ */
+class Code {
+    public:
+        std::vector<uint8_t> bytes;
+
+        Code& operator()(std::initializer_list<uint8_t> b)
+        {
+            bytes.insert(bytes.end(), b);
+
+            return *this;
+        }
+
+        // A 16-bit immediate or absolute operand
+        Code& word(const uint16_t w)
+        {
+            return (*this)({ static_cast<uint8_t>(w), static_cast<uint8_t>(w >> 8) });
+        }
+
+        unsigned int here() const { return bytes.size(); }
+
+        // Code assembled separately
+        Code& append(const Code& code)
+        {
+            bytes.insert(bytes.end(), code.bytes.begin(), code.bytes.end());
+
+            return *this;
+        }
+
+        // A branch to an offset already assembled
+        Code& branchTo(const uint8_t opcode, const unsigned int target)
+        {
+            return (*this)({ opcode, static_cast<uint8_t>(target - (here() + 2)) });
+        }
+
+        Code& trap() { return (*this)({ 0x80, 0xFE }); }
+};
+
+static const M65816::cpu_core_t kCores[] = { M65816::INTERPRETER, M65816::THREADED };
+
+static const char *coreName(const M65816::cpu_core_t core)
+{
+    return (core == M65816::THREADED)? "threaded" : "interp";
+}
+
+/**
+ * Decimal mode ADC and SBC worked out a nibble at a time, as the engines
+ * did before they used lookup tables.
+ */
+static unsigned int nibbleArithmetic(const bool subtract, const unsigned int a, const unsigned int b, bool& carry, bool& overflow, const unsigned int nibbles)
+{
+    const unsigned int n_bit = 1 << (nibbles * 4 - 1);
+    int tempA = a, tempB = b, tempC = carry;
+    unsigned int result = 0;
+
+    for (unsigned int i = 0 ; i < nibbles ; ++i) {
+        int digit;
+
+        if (subtract) {
+            digit = (tempA & 0x0F) - (tempB & 0x0F) + tempC - 1;
+
+            if (digit < 0) {
+                digit = (digit - 0x06) & 0x0F;
+                tempC = 0;
+            }
+            else {
+                tempC = 1;
+            }
+        }
+        else {
+            digit = (tempA & 0x0F) + (tempB & 0x0F) + tempC;
+
+            if (digit >= 0x0A) {
+                digit = (digit + 0x06) & 0x0F;
+                tempC = 1;
+            }
+            else {
+                tempC = 0;
+            }
+        }
+
+        result |= digit << (4 * i);
+
+        tempA >>= 4;
+        tempB >>= 4;
+    }
+
+    carry    = tempC;
+    overflow = subtract? ((a ^ result) & (~b ^ result) & n_bit) : ((a ^ result) & (b ^ result) & n_bit);
+
+    return result;
+}
+
+/**
+ * Check the decimal tables against the nibble arithmetic for every 8-bit
+ * input, then run a batch of 8- and 16-bit ADCs and SBCs through each
+ * core and check the results and the N, V, Z, and C flags.
+ */
+static bool checkDecimal()
+{
+    bool ok = true;
+
+    M65816::initDecimalTables();
+
+    for (unsigned int c = 0 ; c < 2 ; ++c) {
+        for (unsigned int a = 0 ; a < 256 ; ++a) {
+            for (unsigned int b = 0 ; b < 256 ; ++b) {
+                for (const bool subtract : { false, true }) {
+                    const uint16_t entry = (subtract? M65816::decimal_sbc_table : M65816::decimal_adc_table)[(c << 16) | (a << 8) | b];
+                    bool carry = c, overflow;
+                    const unsigned int result = nibbleArithmetic(subtract, a, b, carry, overflow, 2);
+
+                    if (((entry & 0xFF) != result) || (!!(entry & M65816::kDecimalCarry) != carry) || (!!(entry & M65816::kDecimalOverflow) != overflow)) {
+                        cerr << format("decimal %s table: %02X %02X C=%d gives %03X, expected %02X C=%d V=%d\n")
+                                    % (subtract? "SBC" : "ADC") % a % b % c % entry % result % carry % overflow;
+
+                        ok = false;
+                    }
+                }
+            }
+        }
+    }
+
+    // Each case is 16 bytes in bank 1: the two operands and the carry in,
+    // followed by the result and the flags the program stores.
+    const unsigned int kCases = 4096;
+
+    for (const M65816::cpu_core_t core : kCores) {
+        for (const bool wide : { false, true }) {
+            for (const bool subtract : { false, true }) {
+                TestMachine m(core);
+                Code code;
+                uint32_t seed = 12345;
+
+                code({ 0x18, 0xFB, 0xC2, 0x30 })            // CLC; XCE; REP #$30
+                    ({ 0xF4, 0x01, 0x01, 0xAB, 0xAB })      // PEA $0101; PLB; PLB
+                    ({ 0xA2, 0x00, 0x00 });                 // LDX #$0000
+
+                const unsigned int loop = code.here();
+
+                if (!wide) code({ 0xE2, 0x20 });            // SEP #$20
+
+                code({ 0xBD, 0x04, 0x00, 0x4A })            // LDA $0004,X; LSR
+                    ({ 0xBD, 0x00, 0x00, 0xF8 })            // LDA $0000,X; SED
+                    ({ static_cast<uint8_t>(subtract? 0xFD : 0x7D), 0x02, 0x00 }) // ADC/SBC $0002,X
+                    ({ 0xD8, 0x9D, 0x06, 0x00, 0x08 })      // CLD; STA $0006,X; PHP
+                    ({ 0xE2, 0x20, 0x68, 0x9D, 0x08, 0x00 })// SEP #$20; PLA; STA $0008,X
+                    ({ 0xC2, 0x20, 0x8A, 0x18, 0x69 }).word(16) // REP #$20; TXA; CLC; ADC #16
+                    ({ 0xAA, 0xE0 }).word(kCases * 16 & 0xFFFF) // TAX; CPX #0 (X wraps)
+                    .branchTo(0xD0, loop)                   // BNE loop
+                    .trap();
+
+                m.load(0x1000, code.bytes);
+
+                for (unsigned int i = 0 ; i < kCases ; ++i) {
+                    const uint32_t rec = 0x10000 + i * 16;
+
+                    uint32_t a = 0, b = 0;
+
+                    // Mostly valid BCD, with some of everything else
+                    for (unsigned int digit = 0 ; digit < 4 ; ++digit) {
+                        seed = seed * 1103515245 + 12345;
+
+                        const unsigned int r = seed >> 16;
+
+                        a |= ((i & 3)? (r % 10) : (r & 0x0F)) << (digit * 4);
+                        b |= ((i & 3)? ((r >> 8) % 10) : ((r >> 8) & 0x0F)) << (digit * 4);
+                    }
+
+                    m.ram[rec]     = a;
+                    m.ram[rec + 1] = a >> 8;
+                    m.ram[rec + 2] = b;
+                    m.ram[rec + 3] = b >> 8;
+                    m.ram[rec + 4] = (seed >> 30) & 1;
+                }
+
+                if (!m.runToTrap(0x1000)) return false;
+
+                for (unsigned int i = 0 ; i < kCases ; ++i) {
+                    const uint32_t rec = 0x10000 + i * 16;
+                    const unsigned int mask = wide? 0xFFFF : 0xFF;
+                    const unsigned int a = m.word(rec) & mask;
+                    const unsigned int b = m.word(rec + 2) & mask;
+                    bool carry = m.ram[rec + 4], overflow;
+                    const unsigned int expected = nibbleArithmetic(subtract, a, b, carry, overflow, wide? 4 : 2);
+                    const unsigned int result = m.word(rec + 6) & mask;
+                    const uint8_t p = m.ram[rec + 8];
+                    const bool n = expected & (wide? 0x8000 : 0x80);
+
+                    if ((result != expected) || (!!(p & 0x01) != carry) || (!!(p & 0x40) != overflow)
+                            || (!!(p & 0x80) != n) || (!!(p & 0x02) != !expected)) {
+                        cerr << format("%s: %d-bit decimal %s of %04X %04X C=%d gave %04X P=%02X, expected %04X C=%d V=%d\n")
+                                    % coreName(core) % (wide? 16 : 8) % (subtract? "SBC" : "ADC") % a % b % (unsigned int) m.ram[rec + 4]
+                                    % result % (unsigned int) p % expected % carry % overflow;
+
+                        ok = false;
+
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Programs that patch their own code, once the block holding that code
+ * has been cached and bound: from inside the same block, from another
+ * block, and through another bank mapped onto the same memory.
+ */
+static bool checkBlockCache()
+{
+    bool ok = true;
+
+    for (const M65816::cpu_core_t core : kCores) {
+        // Patches the immediate operand of an instruction further on in
+        // its own block with the iteration count, and sums the operands
+        {
+            TestMachine m(core);
+            Code code;
+
+            code({ 0xE6, 0x11, 0xA5, 0x11 })                // INC $11; LDA $11
+                ({ 0x8D, 0x08, 0x04 })                      // STA $0408
+                ({ 0xA9, 0x00 })                            // LDA #$00 (patched)
+                ({ 0x18, 0x65, 0x10, 0x85, 0x10 })          // CLC; ADC $10; STA $10
+                ({ 0xA5, 0x11, 0xC9, 0x80 })                // LDA $11; CMP #$80
+                .branchTo(0xD0, 0)                          // BNE $0400
+                .trap();
+
+            m.load(0x0400, code.bytes);
+
+            if (!m.runToTrap(0x0400)) return false;
+
+            // 1 + 2 + ... + 128
+            if (m.ram[0x10] != (8256 & 0xFF)) {
+                cerr << format("%s: code patched in its own block summed to %02X\n") % coreName(core) % (unsigned int) m.ram[0x10];
+
+                ok = false;
+            }
+        }
+
+        // Adds 1 for 64 iterations, then patches the first block from
+        // another one to add $40 for the next 64, the second time through
+        // a mirror of bank 0 in bank 1
+        for (const uint8_t bank : { 0, 1 }) {
+            TestMachine m(core);
+            Code code;
+
+            if (bank) {
+                for (unsigned int page = 0 ; page < 256 ; ++page) {
+                    m.sys->mapRead(0x100 | page, page);
+                    m.sys->mapWrite(0x100 | page, page);
+                }
+            }
+
+            code({ 0xA9, 0x01 })                            // LDA #$01 (patched)
+                ({ 0x18, 0x65, 0x10, 0x85, 0x10 })          // CLC; ADC $10; STA $10
+                ({ 0xE6, 0x11, 0xA5, 0x11, 0xC9, 0x40 })    // INC $11; LDA $11; CMP #$40
+                ({ 0xD0, 0x06 })                            // BNE skip
+                ({ 0xA9, 0x40, 0x8F, 0x01, 0x04, bank })    // LDA #$40; STA $bb0401
+                ({ 0xA5, 0x11, 0xC9, 0x80 })                // skip: LDA $11; CMP #$80
+                .branchTo(0xD0, 0)                          // BNE $0400
+                .trap();
+
+            m.load(0x0400, code.bytes);
+
+            if (!m.runToTrap(0x0400)) return false;
+
+            if (m.ram[0x10] != ((64 + 64 * 0x40) & 0xFF)) {
+                cerr << format("%s: code patched from another block through bank %d summed to %02X\n")
+                            % coreName(core) % (unsigned int) bank % (unsigned int) m.ram[0x10];
+
+                ok = false;
+            }
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * A soft switch that maps page $04 onto page $0104 the 50th time it's
+ * read, and returns the number of times it's been read.
+ */
+class RemapSwitch : public Device {
+    public:
+        unsigned int reads = 0;
+
+        std::vector<unsigned int>& ioReadList()
+        {
+            static std::vector<unsigned int> locs = { 0x80 };
+
+            return locs;
+        }
+
+        std::vector<unsigned int>& ioWriteList()
+        {
+            static std::vector<unsigned int> locs;
+
+            return locs;
+        }
+
+        void reset() {}
+
+        uint8_t read(const unsigned int&)
+        {
+            if (++reads == 50) system->mapRead(0x04, 0x104);
+
+            return reads;
+        }
+
+        void write(const unsigned int&, const uint8_t&) {}
+};
+
+// How a program is run for checkFused()
+enum fuse_run_t {
+    kPlain,         // interpreter with the block cache off
+    kCached,        // interpreter running fused blocks from the block cache
+    kThreaded
+};
+
+/**
+ * Run a program and return the contents of bank 0 and the registers it
+ * leaves behind.
+ */
+static std::vector<uint8_t> fusedRun(const fuse_run_t run, const std::vector<uint8_t>& code, const std::vector<uint8_t>& remapped)
+{
+    TestMachine m((run == kThreaded)? M65816::THREADED : M65816::INTERPRETER);
+
+    // The counting profiler keeps the interpreter off the block cache
+    if (run == kPlain) {
+        m.cpu->profiler.enabled = true;
+        m.cpu->profiler.mode = M65816::COUNTING;
+    }
+
+    if (remapped.size()) {
+        m.sys->mapIO(0xC0);
+        m.installDevice("remap", new RemapSwitch());
+        m.load(0x10400, remapped);
+    }
+
+    m.load(0x0400, code);
+
+    std::vector<uint8_t> result;
+
+    if (m.runToTrap(0x0400)) {
+        result.assign(m.ram, m.ram + 0x10000);
+
+        for (const uint16_t r : { m.cpu->A.W, m.cpu->X.W, m.cpu->Y.W, m.cpu->S.W }) {
+            result.push_back(r);
+            result.push_back(r >> 8);
+        }
+
+        result.push_back(static_cast<uint8_t>(m.cpu->SR));
+    }
+
+    return result;
+}
+
+/**
+ * Run programs made up of the sequences the block cache fuses, with and
+ * without fusing them, and check that they leave the same memory and
+ * registers behind. This includes a load from a soft switch that remaps
+ * the code in between the load and the store it's fused with.
+ */
+static bool checkFused()
+{
+    bool ok = true;
+    std::vector<std::pair<string, std::pair<std::vector<uint8_t>, std::vector<uint8_t>>>> programs;
+
+    for (const bool native : { false, true }) {
+        Code code;
+
+        // Immediate operands of A, X, and Y
+        auto imm = [&](const uint8_t opcode, const uint16_t v) -> Code& {
+            return native? code({ opcode }).word(v) : code({ opcode, static_cast<uint8_t>(v) });
+        };
+
+        if (native) code({ 0x18, 0xFB, 0xC2, 0x30 });   // CLC; XCE; REP #$30
+
+        code({ 0xA9, 0x28 });                           // LDA #$28
+        if (native) code({ 0x00 });
+        code({ 0x85, 0x30 });                           // STA $30
+
+        const unsigned int outer = code.here();
+
+        imm(0xA2, 0x10);                                // LDX #$10
+
+        const unsigned int loop = code.here();
+
+        imm(0xA9, 0x1234);                              // LDA #$1234
+        code({ 0x95, 0x40 })                            // STA $40,X
+            ({ 0x18, 0x65, 0x20 })                      // CLC; ADC $20
+            ({ 0x9D, 0x00, 0x03 })                      // STA $0300,X
+            ({ 0x38 });                                 // SEC
+        imm(0xE9, 0x0111);                              // SBC #$0111
+        code({ 0x85, 0x22, 0xA5, 0x22, 0x85, 0x20 })    // STA $22; LDA $22; STA $20
+            ({ 0xBD, 0x00, 0x03, 0x99, 0x00, 0x05 })    // LDA $0300,X; STA $0500,Y
+            ({ 0xB9, 0x40, 0x00, 0x8D, 0x24, 0x00 })    // LDA $0040,Y; STA $0024
+            ({ 0x18, 0x7D, 0x00, 0x05 })                // CLC; ADC $0500,X
+            ({ 0x38, 0xF9, 0x00, 0x03, 0x85, 0x26 })    // SEC; SBC $0300,Y; STA $26
+            ({ 0xC8, 0xCA })                            // INY; DEX
+            .branchTo(0xD0, loop);                      // BNE loop
+        imm(0xA0, 0x08);                                // LDY #$08
+
+        const unsigned int inner = code.here();
+
+        code({ 0xC8 });                                 // INY
+        imm(0xC0, 0x20);                                // CPY #$20
+        code.branchTo(0xD0, inner)                      // BNE inner
+            ({ 0xC6, 0x30 })                            // DEC $30
+            .branchTo(0xD0, outer)                      // BNE outer
+            .trap();
+
+        programs.push_back({ native? "native" : "emulation", { code.bytes, {} } });
+    }
+
+    // The same code at $0400 in banks 0 and 1, differing only in where
+    // they store and count
+    for (const uint8_t offset : { 0, 1 }) {
+        Code code;
+
+        code({ 0xAD, 0x80, 0xC0 })                      // LDA $C080
+            ({ 0x85, static_cast<uint8_t>(0x10 + offset * 0x10) }) // STA $10 or $20
+            ({ 0xE6, static_cast<uint8_t>(0x30 + offset) })  // INC $30 or $31
+            ({ 0xA5, static_cast<uint8_t>(0x30 + offset), 0xC9, 0x60 }) // LDA $30 or $31; CMP #$60
+            .branchTo(0xD0, 0)                          // BNE $0400
+            .trap();
+
+        if (!offset) {
+            programs.push_back({ "remap", { code.bytes, {} } });
+        }
+        else {
+            programs.back().second.second = code.bytes;
+        }
+    }
+
+    for (const auto& program : programs) {
+        const std::vector<uint8_t> reference = fusedRun(kPlain, program.second.first, program.second.second);
+
+        if (reference.empty()) return false;
+
+        for (const fuse_run_t run : { kCached, kThreaded }) {
+            const std::vector<uint8_t> result = fusedRun(run, program.second.first, program.second.second);
+
+            if (result.empty()) return false;
+
+            for (unsigned int i = 0 ; i < reference.size() ; ++i) {
+                if (result[i] != reference[i]) {
+                    cerr << format("%s program on the %s core: byte %X is %02X, expected %02X\n")
+                                % program.first % ((run == kThreaded)? "threaded" : "interp")
+                                % i % (unsigned int) result[i] % (unsigned int) reference[i];
+
+                    ok = false;
+
+                    break;
+                }
+            }
+        }
+
+        // The load that remaps the code is the 50th, so the store after
+        // it must come from the new code
+        if ((program.first == "remap") && (reference[0x10] != 49)) {
+            cerr << format("remap program stored %02X from the old code\n") % (unsigned int) reference[0x10];
+
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Run MVN and MVP with source and destination addresses that wrap around
+ * the end of their banks, and with overlapping ranges, and compare the
+ * memory they leave to a byte at a time model of the move.
+ */
+static bool checkBlockMove()
+{
+    struct Move {
+        bool     mvp;
+        bool     short_index;
+        uint8_t  src_bank;
+        uint16_t src;
+        uint8_t  dst_bank;
+        uint16_t dst;
+        uint16_t count;
+    };
+
+    static const Move moves[] = {
+        { false, false, 1, 0xFFF0, 2, 0x2000, 0x0020 },
+        { false, false, 1, 0x1000, 2, 0xFFF8, 0x0020 },
+        { true,  false, 1, 0x0008, 2, 0x3000, 0x0020 },
+        { true,  false, 1, 0x4000, 2, 0x0004, 0x0020 },
+        { false, false, 1, 0x10F0, 1, 0x10F1, 0x0300 },
+        { true,  false, 1, 0x2200, 1, 0x21FF, 0x0300 },
+        { false, true,  1, 0x00F0, 2, 0x0040, 0x0020 },
+        { true,  true,  1, 0x0008, 2, 0x00F0, 0x0020 },
+    };
+
+    bool ok = true;
+
+    for (const M65816::cpu_core_t core : kCores) {
+        for (const Move& move : moves) {
+            TestMachine m(core);
+            Code code;
+
+            code({ 0x18, 0xFB, 0xC2, 0x30 });           // CLC; XCE; REP #$30
+            if (move.short_index) code({ 0xE2, 0x10 }); // SEP #$10
+            code({ 0xA9 }).word(move.count - 1);        // LDA #count-1
+
+            if (move.short_index) {
+                code({ 0xA2, static_cast<uint8_t>(move.src), 0xA0, static_cast<uint8_t>(move.dst) });
+            }
+            else {
+                code({ 0xA2 }).word(move.src)({ 0xA0 }).word(move.dst);
+            }
+
+            code({ static_cast<uint8_t>(move.mvp? 0x44 : 0x54), move.dst_bank, move.src_bank })
+                .trap();
+
+            m.load(0x1000, code.bytes);
+
+            for (uint32_t i = 0x10000 ; i < 0x30000 ; ++i) {
+                m.ram[i] = (i * 7) ^ (i >> 8);
+            }
+
+            std::vector<uint8_t> expected(m.ram, m.ram + 0x30000);
+            const unsigned int mask = move.short_index? 0xFF : 0xFFFF;
+            unsigned int x = move.src, y = move.dst, a = move.count - 1;
+
+            do {
+                expected[(move.dst_bank << 16) | y] = expected[(move.src_bank << 16) | x];
+
+                x = (x + (move.mvp? -1 : 1)) & mask;
+                y = (y + (move.mvp? -1 : 1)) & mask;
+                a = (a - 1) & 0xFFFF;
+            } while (a != 0xFFFF);
+
+            if (!m.runToTrap(0x1000)) return false;
+
+            const char *name = move.mvp? "MVP" : "MVN";
+
+            if ((m.cpu->A.W != 0xFFFF) || (m.cpu->X.W != x) || (m.cpu->Y.W != y) || (m.cpu->DBR != move.dst_bank)) {
+                cerr << format("%s: %s %02X/%04X to %02X/%04X left A=%04X X=%04X Y=%04X DBR=%02X, expected X=%04X Y=%04X\n")
+                            % coreName(core) % name % (unsigned int) move.src_bank % move.src % (unsigned int) move.dst_bank % move.dst
+                            % m.cpu->A.W % m.cpu->X.W % m.cpu->Y.W % (unsigned int) m.cpu->DBR % x % y;
+
+                ok = false;
+            }
+
+            for (uint32_t i = 0x10000 ; i < 0x30000 ; ++i) {
+                if (m.ram[i] != expected[i]) {
+                    cerr << format("%s: %s %02X/%04X to %02X/%04X left %02X at %02X/%04X, expected %02X\n")
+                                % coreName(core) % name % (unsigned int) move.src_bank % move.src % (unsigned int) move.dst_bank % move.dst
+                                % (unsigned int) m.ram[i] % (i >> 16) % (i & 0xFFFF) % (unsigned int) expected[i];
+
+                    ok = false;
+
+                    break;
+                }
+            }
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Make Integer Math calls through a stand-in for the ROM that always does
+ * LoWord, and check that the HLE does HiWord itself, falls back to the
+ * ROM when the tool set is patched, and in compare mode catches the ROM
+ * leaving the wrong result in memory or the wrong registers.
+ */
+static bool checkToolCompare()
+{
+    struct Call {
+        bool     compare;
+        bool     patched;        // tool set entry points into RAM
+        bool     clobber_y;      // stand-in changes Y
+        uint16_t function;
+        uint16_t result;
+        unsigned long handled;
+        unsigned long compared;
+        unsigned long mismatches;
+        unsigned long fallbacks;
+    };
+
+    static const Call calls[] = {
+        { true,  false, false, 0x190B, 0x5678, 0, 1, 0, 0 },   // LoWord, ROM agrees
+        { true,  false, false, 0x180B, 0x5678, 0, 1, 1, 0 },   // HiWord, ROM result differs
+        { true,  false, true,  0x190B, 0x5678, 0, 1, 1, 0 },   // LoWord, ROM changes Y
+        { false, false, false, 0x180B, 0x1234, 1, 0, 0, 0 },   // HiWord done natively
+        { false, true,  false, 0x180B, 0x5678, 0, 0, 0, 1 },   // HiWord, patched
+    };
+
+    bool ok = true;
+
+    for (const M65816::cpu_core_t core : kCores) {
+        for (const Call& call : calls) {
+            TestMachine m(core);
+            IntegerMathHLE *im = new IntegerMathHLE(call.compare);
+            Code caller, rom;
+
+            m.installDevice("imhle", im);
+
+            // System tool pointer table at $6000, with the Integer Math
+            // function pointer table at $6100
+            const uint32_t entry = call.patched? 0x7000 : 0xFE0000;
+
+            m.ram[0xE103C0] = 0x00;
+            m.ram[0xE103C1] = 0x60;
+            m.ram[0x6000]   = 0x20;
+            m.ram[0x6000 + 0x0B * 4 + 1] = 0x61;
+            m.ram[0x6100]   = 0x30;
+
+            for (const unsigned int number : { 0x18, 0x19 }) {
+                m.ram[0x6100 + number * 4]     = entry;
+                m.ram[0x6100 + number * 4 + 1] = entry >> 8;
+                m.ram[0x6100 + number * 4 + 2] = entry >> 16;
+            }
+
+            m.ram[0x20] = call.clobber_y;
+
+            rom({ 0xAF, 0x20, 0x00, 0x00, 0xF0, 0x03 })     // LDA $000020; BEQ +3
+               ({ 0xA0, 0xFF, 0xFF })                       // LDY #$FFFF
+               ({ 0xA3, 0x04, 0x83, 0x08 })                 // LDA 4,S; STA 8,S
+               ({ 0xA3, 0x02, 0x83, 0x06 })                 // LDA 2,S; STA 6,S
+               ({ 0xA3, 0x01, 0x83, 0x05, 0x68, 0x68 })     // LDA 1,S; STA 5,S; PLA; PLA
+               ({ 0xA9, 0x00, 0x00, 0x18, 0x6B });          // LDA #$0000; CLC; RTL
+
+            caller({ 0x18, 0xFB, 0xC2, 0x30 })              // CLC; XCE; REP #$30
+                  ({ 0xF4, 0x00, 0x00 })                    // PEA $0000
+                  ({ 0xF4, 0x34, 0x12, 0xF4, 0x78, 0x56 })  // PEA $1234; PEA $5678
+                  ({ 0xA2 }).word(call.function)            // LDX #function
+                  ({ 0x22, 0x00, 0x00, 0xE1 })              // JSL $E10000
+                  ({ 0x68, 0x85, 0x10 })                    // PLA; STA $10
+                  .trap();
+
+            m.load(System::kToolDispatcher, rom.bytes);
+            m.load(0x1000, caller.bytes);
+
+            if (!m.runToTrap(0x1000)) return false;
+
+            if ((m.word(0x10) != call.result) || (im->getCallsHandled() != call.handled) || (im->getCallsCompared() != call.compared)
+                    || (im->getMismatches() != call.mismatches) || (im->getROMFallbacks() != call.fallbacks)) {
+                cerr << format("%s: call %04X%s%s returned %04X, handled %d compared %d mismatches %d fallbacks %d\n")
+                            % coreName(core) % call.function % (call.compare? " compared" : "") % (call.patched? " patched" : "")
+                            % m.word(0x10) % im->getCallsHandled() % im->getCallsCompared() % im->getMismatches() % im->getROMFallbacks();
+
+                ok = false;
+            }
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Check the Memory Manager calls done natively against a stand-in ROM
+ * that does them too, in both modes, and that allocation is always left
+ * to the ROM.
+ */
+static bool checkMemoryManager()
+{
+    static const uint32_t kHandle = 0x7000;
+
+    bool ok = true;
+
+    for (const auto core : kCores) {
+        for (const bool compare : { false, true }) {
+            TestMachine m(core);
+            MemoryManagerHLE *mm = new MemoryManagerHLE(compare);
+            Code caller, rom, lock, size, new_handle;
+
+            m.installDevice("mmhle", mm);
+
+            // System tool pointer table at $6000, with the Memory Manager
+            // function pointer table at $6200 pointing into the "ROM"
+            m.ram[0xE103C0] = 0x00;
+            m.ram[0xE103C1] = 0x60;
+            m.ram[0x6000]   = 0x20;
+            m.ram[0x6000 + 0x02 * 4 + 1] = 0x62;
+            m.ram[0x6200]   = 0x30;
+
+            for (unsigned int number = 1 ; number < 0x30 ; ++number) m.ram[0x6200 + number * 4 + 2] = 0xFE;
+
+            // A $100 byte block at $8000 owned by $1001
+            m.ram[kHandle + 0x01] = 0x80;
+            m.ram[kHandle + 0x06] = 0x01;
+            m.ram[kHandle + 0x07] = 0x10;
+            m.ram[kHandle + 0x09] = 0x01;
+
+            // The stand-in HLock and GetHandleSize work through the handle,
+            // copied to $00, keeping Y in $04; everything else just pulls
+            // its parameters
+            const auto pull = [](const uint8_t bytes) {
+                return Code()({ 0xA3, 0x02, 0x83, static_cast<uint8_t>(bytes + 2) })    // LDA 2,S; STA bytes+2,S
+                             ({ 0xA3, 0x01, 0x83, static_cast<uint8_t>(bytes + 1) })    // LDA 1,S; STA bytes+1,S
+                             ({ 0x3B, 0x18, 0x69, bytes, 0x00, 0x1B })                  // TSC; CLC; ADC #bytes; TCS
+                             ({ 0xA9, 0x00, 0x00, 0x18, 0x6B });                        // LDA #$0000; CLC; RTL
+            };
+
+            lock({ 0xA0, 0x04, 0x00, 0xB7, 0x00 })          // LDY #4; LDA [$00],Y
+                ({ 0x09, 0x00, 0x80, 0x97, 0x00 })          // ORA #$8000; STA [$00],Y
+                ({ 0xA4, 0x04 })                            // LDY $04
+                .append(pull(4));
+            size({ 0xA0, 0x08, 0x00, 0xB7, 0x00, 0x83, 0x08 })     // LDY #8; LDA [$00],Y; STA 8,S
+                ({ 0xA0, 0x0A, 0x00, 0xB7, 0x00, 0x83, 0x0A })     // LDY #10; LDA [$00],Y; STA 10,S
+                ({ 0xA4, 0x04 })                                   // LDY $04
+                .append(pull(4));
+            new_handle.append(pull(12));
+
+            rom({ 0xA3, 0x04, 0x85, 0x00, 0xA3, 0x06, 0x85, 0x02 })   // LDA 4,S; STA $00; LDA 6,S; STA $02
+               ({ 0x84, 0x04 })                                         // STY $04
+               ({ 0xE0 }).word(0x2002)({ 0xD0, static_cast<uint8_t>(lock.here()) }).append(lock)    // CPX #HLock
+               ({ 0xE0 }).word(0x1802)({ 0xD0, static_cast<uint8_t>(size.here()) }).append(size)    // CPX #GetHandleSize
+               ({ 0xE0 }).word(0x0902)({ 0xD0, static_cast<uint8_t>(new_handle.here()) }).append(new_handle)   // CPX #NewHandle
+               .append(pull(4));
+
+            caller({ 0x18, 0xFB, 0xC2, 0x30 })              // CLC; XCE; REP #$30
+                  ({ 0xF4, 0x00, 0x00, 0xF4, 0x00, 0x00 })  // PEA 0; PEA 0 (result)
+                  ({ 0xF4, 0x00, 0x00, 0xF4 }).word(kHandle)    // PEA ^handle; PEA handle
+                  ({ 0xA2 }).word(0x1802)                   // LDX #$1802 (GetHandleSize)
+                  ({ 0x22, 0x00, 0x00, 0xE1 })              // JSL $E10000
+                  ({ 0x68, 0x85, 0x10, 0x68, 0x85, 0x12 })  // PLA; STA $10; PLA; STA $12
+                  ({ 0xF4, 0x00, 0x00, 0xF4 }).word(kHandle)    // PEA ^handle; PEA handle
+                  ({ 0xA2 }).word(0x2002)                   // LDX #$2002 (HLock)
+                  ({ 0x22, 0x00, 0x00, 0xE1 })              // JSL $E10000
+                  ({ 0xF4, 0x00, 0x00, 0xF4, 0x00, 0x00 })  // PEA 0; PEA 0 (result)
+                  ({ 0xF4, 0x00, 0x00, 0xF4, 0x00, 0x01 })  // PEA ^$100; PEA $100 (size)
+                  ({ 0xF4, 0x01, 0x10, 0xF4, 0x00, 0xC0 })  // PEA $1001 (userID); PEA $C000 (attributes)
+                  ({ 0xF4, 0x00, 0x00, 0xF4, 0x00, 0x00 })  // PEA 0; PEA 0 (location)
+                  ({ 0xA2 }).word(0x0902)                   // LDX #$0902 (NewHandle)
+                  ({ 0x22, 0x00, 0x00, 0xE1, 0x68, 0x68 })  // JSL $E10000; PLA; PLA
+                  ({ 0xF4, 0x00, 0x00, 0xF4 }).word(kHandle)    // PEA ^handle; PEA handle
+                  ({ 0xA2 }).word(0x1002)                   // LDX #$1002 (DisposeHandle)
+                  ({ 0x22, 0x00, 0x00, 0xE1 })              // JSL $E10000
+                  .trap();
+
+            m.load(System::kToolDispatcher, rom.bytes);
+            m.load(0x1000, caller.bytes);
+
+            if (!m.runToTrap(0x1000)) return false;
+
+            if ((mm->getCallsHandled() != (compare? 0 : 2)) || (mm->getCallsCompared() != (compare? 2 : 0)) || mm->getMismatches()
+                    || mm->getROMFallbacks() || (mm->getCallsUnhandled() != 2)) {
+                cerr << format("%s%s: handled %d compared %d mismatches %d fallbacks %d unhandled %d\n")
+                            % coreName(core) % (compare? " compared" : "") % mm->getCallsHandled() % mm->getCallsCompared()
+                            % mm->getMismatches() % mm->getROMFallbacks() % mm->getCallsUnhandled();
+
+                ok = false;
+            }
+
+            if ((m.word(0x10) != 0x0100) || m.word(0x12) || (m.word(kHandle + 0x04) != 0x8000)) {
+                cerr << format("%s%s: size %04X%04X, attributes %04X\n") % coreName(core) % (compare? " compared" : "")
+                            % m.word(0x12) % m.word(0x10) % m.word(kHandle + 0x04);
+
+                ok = false;
+            }
+        }
+    }
+
+    return ok;
+}
+
+// Store a double as a SANE extended
+static void putExtended(uint8_t *p, const double v)
+{
+    int exponent;
+    const double   fraction      = std::frexp(std::fabs(v), &exponent);
+    const uint64_t significand   = v? static_cast<uint64_t>(std::ldexp(fraction, 64)) : 0;
+    const uint16_t sign_exponent = (std::signbit(v)? 0x8000 : 0) | (v? exponent - 1 + 16383 : 0);
+
+    for (unsigned int i = 0 ; i < 8 ; ++i) p[i] = significand >> (i * 8);
+
+    p[8] = sign_exponent;
+    p[9] = sign_exponent >> 8;
+}
+
+/**
+ * Check which FP816 calls SANEHLE does natively, and what it leaves
+ * behind, against a stand-in FP816 that returns with X = $1111 and V and C
+ * set without touching its operands.
+ */
+static bool checkSANE()
+{
+    static const unsigned int kExtendedFormat = 0;
+    static const unsigned int kIntegerFormat  = 4;
+
+    struct Operation {
+        uint8_t      op;
+        unsigned int format;
+        double       dst;
+        double       src;
+        bool         native;
+        double       result;
+    };
+
+    static const Operation operations[] = {
+        { 0x00, kExtendedFormat, 3,        5,    true,  8 },     // FOADD
+        { 0x02, kExtendedFormat, 2.5,      0.25, true,  2.25 },  // FOSUB
+        { 0x04, kExtendedFormat, 1.5,      -2,   true,  -3 },    // FOMUL
+        { 0x06, kExtendedFormat, 10,       4,    true,  2.5 },   // FODIV
+        { 0x06, kExtendedFormat, 1,        3,    false, 0 },     // inexact
+        { 0x00, kExtendedFormat, 16777216, 1,    false, 0 },     // too long for a single
+        { 0x02, kExtendedFormat, 7,        7,    false, 0 },     // zero sum
+        { 0x04, kExtendedFormat, 0,        -2,   true,  -0.0 },
+        { 0x06, kExtendedFormat, 5,        0,    false, 0 },     // division by zero
+        { 0x00, kIntegerFormat,  2,        -5,   true,  -3 },    // integer source
+        { 0x08, kExtendedFormat, 1,        2,    false, 0 },     // FOCMP: less, learned
+        { 0x08, kExtendedFormat, 3,        4,    true,  0 },     // less again
+        { 0x08, kExtendedFormat, 4,        3,    false, 0 },     // greater, learned
+    };
+
+    const unsigned int count = sizeof(operations) / sizeof(operations[0]);
+
+    // Where each operation's operands go, and the A, X, Y and P it
+    // returns with
+    const auto dst_addr    = [](unsigned int i) { return 0x3000 + i * 16; };
+    const auto src_addr    = [](unsigned int i) { return 0x3800 + i * 16; };
+    const auto record_addr = [](unsigned int i) { return 0x4000 + i * 8; };
+
+    bool ok = true;
+
+    for (const auto core : kCores) {
+        for (const bool compare : { false, true }) {
+            TestMachine m(core);
+            SANEHLE *sane = new SANEHLE(compare);
+            Code caller, rom, startup;
+            unsigned long natives = 0, fallbacks = 0;
+
+            m.installDevice("sanehle", sane);
+
+            // System tool pointer table at $6000, with the SANE function
+            // pointer table at $6200 and FP816 in the "ROM"
+            m.ram[0xE103C0] = 0x00;
+            m.ram[0xE103C1] = 0x60;
+            m.ram[0x6000]   = 0x20;
+            m.ram[0x6000 + 0x0A * 4 + 1] = 0x62;
+            m.ram[0x6200]   = 0x10;
+            m.ram[0x6200 + 9 * 4 + 2] = 0xFE;
+
+            startup({ 0xA3, 0x02, 0x83, 0x04 })             // LDA 2,S; STA 4,S
+                   ({ 0xA3, 0x01, 0x83, 0x03, 0x68 })       // LDA 1,S; STA 3,S; PLA
+                   ({ 0xA9, 0x00, 0x00, 0x18, 0x6B });      // LDA #$0000; CLC; RTL
+
+            rom({ 0xE0 }).word(0x020A)                      // CPX #$020A
+               ({ 0xD0, static_cast<uint8_t>(startup.here()) })   // BNE fp816
+               .append(startup);
+
+            rom({ 0xA3, 0x02, 0x83, 0x0C })                 // fp816: LDA 2,S; STA 12,S
+               ({ 0xA3, 0x01, 0x83, 0x0B })                 // LDA 1,S; STA 11,S
+               ({ 0x3B, 0x18, 0x69, 0x0A, 0x00, 0x1B })     // TSC; CLC; ADC #10; TCS
+               ({ 0xA9, 0x00, 0x00 })                       // LDA #$0000
+               ({ 0xA2, 0x11, 0x11, 0xE2, 0x41, 0x6B });    // LDX #$1111; SEP #$41; RTL
+
+            caller({ 0x18, 0xFB, 0xC2, 0x30 })              // CLC; XCE; REP #$30
+                  ({ 0xF4, 0x00, 0x03 })                    // PEA $0300
+                  ({ 0xA2 }).word(0x020A)                   // LDX #$020A (SANEStartUp)
+                  ({ 0x22, 0x00, 0x00, 0xE1 });             // JSL $E10000
+
+            for (unsigned int i = 0 ; i < count ; ++i) {
+                const Operation& op = operations[i];
+
+                putExtended(m.ram + dst_addr(i), op.dst);
+
+                if (op.format == kIntegerFormat) {
+                    m.ram[src_addr(i)]     = static_cast<int16_t>(op.src);
+                    m.ram[src_addr(i) + 1] = static_cast<int16_t>(op.src) >> 8;
+                }
+                else {
+                    putExtended(m.ram + src_addr(i), op.src);
+                }
+
+                caller({ 0xF4, 0x00, 0x00, 0xF4 }).word(src_addr(i))        // PEA ^src; PEA src
+                      ({ 0xF4, 0x00, 0x00, 0xF4 }).word(dst_addr(i))        // PEA ^dst; PEA dst
+                      ({ 0xF4 }).word((op.format << 8) | op.op)             // PEA opword
+                      ({ 0xA0 }).word(0x2222)                               // LDY #$2222
+                      ({ 0xA2 }).word(0x090A)                               // LDX #$090A (FP816)
+                      ({ 0x22, 0x00, 0x00, 0xE1 })                          // JSL $E10000
+                      ({ 0x08, 0x8D }).word(record_addr(i))                 // PHP; STA record
+                      ({ 0x8E }).word(record_addr(i) + 2)                   // STX record+2
+                      ({ 0x8C }).word(record_addr(i) + 4)                   // STY record+4
+                      ({ 0xE2, 0x20, 0x68, 0x8D }).word(record_addr(i) + 6) // SEP #$20; PLA; STA record+6
+                      ({ 0xC2, 0x20 });                                     // REP #$20
+
+                if (op.native) {
+                    ++natives;
+                }
+                else {
+                    ++fallbacks;
+                }
+            }
+
+            caller.trap();
+
+            m.load(System::kToolDispatcher, rom.bytes);
+            m.load(0x1000, caller.bytes);
+
+            if (!m.runToTrap(0x1000)) return false;
+
+            const unsigned long handled    = compare? 0 : natives;
+            const unsigned long compared   = compare? natives : 0;
+
+            // Every arithmetic call compared gets C set back from the
+            // stand-in, which counts as an error
+            const unsigned long mismatches = compare? natives - 1 : 0;
+
+            if ((sane->getCallsHandled() != handled) || (sane->getCallsCompared() != compared)
+                    || (sane->getMismatches() != mismatches) || (sane->getROMFallbacks() != fallbacks)) {
+                cerr << format("%s%s: handled %d compared %d mismatches %d fallbacks %d\n") % coreName(core) % (compare? " compared" : "")
+                            % sane->getCallsHandled() % sane->getCallsCompared() % sane->getMismatches() % sane->getROMFallbacks();
+
+                ok = false;
+            }
+
+            if (compare) continue;
+
+            // The record of the comparison that was learned
+            const uint32_t learned = record_addr(10);
+
+            for (unsigned int i = 0 ; i < count ; ++i) {
+                const Operation& op = operations[i];
+                const uint32_t record = record_addr(i);
+                uint8_t expected[10];
+                bool good;
+
+                putExtended(expected, (op.native && (op.op != 0x08))? op.result : op.dst);
+
+                if (std::memcmp(m.ram + dst_addr(i), expected, 10)) {
+                    good = false;
+                }
+                else if (!op.native) {
+                    good = (m.word(record + 2) == 0x1111) && ((m.ram[record + 6] & 0xC3) == 0x41);
+                }
+                else if (op.op == 0x08) {
+                    good = !std::memcmp(m.ram + record, m.ram + learned, 8);
+                }
+                else {
+                    good = !m.word(record) && (m.word(record + 2) == 0x090A) && (m.word(record + 4) == 0x2222) && ((m.ram[record + 6] & 0x83) == 0x02);
+                }
+
+                if (!good) {
+                    cerr << format("%s: operation %d returned A=%04X X=%04X Y=%04X P=%02X\n") % coreName(core) % i
+                                % m.word(record) % m.word(record + 2) % m.word(record + 4) % (unsigned int) m.ram[record + 6];
+
+                    ok = false;
+                }
+            }
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Check which PaintRect and EraseRect calls QuickDrawHLE does natively,
+ * and what they draw, against a stand-in QuickDraw II that keeps the
+ * current port in its direct page and otherwise does nothing.
+ */
+static bool checkQuickDraw()
+{
+    static const uint16_t kDirectPage = 0x0300;
+    static const uint32_t kImage      = 0x020000;
+    static const uint32_t kScreen     = 0xE12000;
+
+    // Ports, region handles (with the regions after them) and rectangles
+    static const uint32_t kClipHandle = 0x5A00;
+    static const uint32_t kVisHandle  = 0x5A04;
+    static const uint32_t kRects      = 0x5C00;
+
+    struct Port {
+        uint32_t address;
+        uint32_t image;
+        uint16_t width;
+        int16_t  bottom, right;
+        uint16_t mode;
+        uint8_t  pattern;       // every byte of the pen pattern
+    };
+
+    static const Port ports[] = {
+        { 0x5000, kImage,  16,  16,  32,  0, 0x33 },  // A
+        { 0x5200, kImage,  16,  16,  32,  0, 0x33 },  // B
+        { 0x5400, kImage,  16,  16,  32,  2, 0xFF },  // C: XOR
+        { 0x5600, kImage,  16,  16,  32,  0, 0x12 },  // D: two colors
+        { 0x5800, kScreen, 160, 200, 320, 0, 0x77 },  // E: screen
+    };
+
+    struct Call {
+        uint16_t function;      // 0 for SetPort
+        unsigned int port;      // or rectangle
+        bool     native;
+    };
+
+    static const int16_t rects[][4] = {
+        { 0, 4, 8, 12 },
+        { 4, 5, 6, 9 },
+        { 1, 0, 15, 7 },
+        { 4, 4, 6, 8 },
+    };
+
+    static const Call calls[] = {
+        { 0,      0, false },
+        { 0x5404, 0, false },   // only one port seen so far
+        { 0,      1, false },
+        { 0x5404, 0, true },
+        { 0x5504, 1, true },
+        { 0,      2, false },
+        { 0x5404, 2, true },
+        { 0,      3, false },
+        { 0x5404, 0, false },   // pattern isn't solid
+        { 0,      4, false },
+        { 0x5404, 3, false },   // cursor showing
+        { 0x9004, 0, false },
+        { 0x5404, 3, true },
+    };
+
+    // The clip region; the visible region covers the whole image
+    const int16_t clip[4] = { 2, 2, 14, 30 };
+
+    const auto put_word = [](uint8_t *p, const uint16_t w) { p[0] = w; p[1] = w >> 8; };
+    const auto put_rect = [&](uint8_t *p, const int16_t *r) { for (unsigned int i = 0 ; i < 4 ; ++i) put_word(p + i * 2, r[i]); };
+
+    bool ok = true;
+
+    for (const auto core : kCores) {
+        TestMachine m(core);
+        QuickDrawHLE *qd = new QuickDrawHLE(false);
+        Code caller, rom, startup, set_port, hide_cursor;
+        unsigned long natives = 0, fallbacks = 0;
+
+        m.installDevice("qdhle", qd);
+
+        // System tool pointer table at $6000, with the QuickDraw II function
+        // pointer table at $6400 pointing into the "ROM"
+        m.ram[0xE103C0] = 0x00;
+        m.ram[0xE103C1] = 0x60;
+        m.ram[0x6000]   = 0x20;
+        m.ram[0x6000 + 0x04 * 4 + 1] = 0x64;
+        m.ram[0x6400]   = 0xD0;
+
+        for (unsigned int number = 1 ; number < 0xD0 ; ++number) m.ram[0x6400 + number * 4 + 2] = 0xFE;
+
+        for (const Port& port : ports) {
+            uint8_t *p = m.ram + port.address;
+            const int16_t bounds[4] = { 0, 0, port.bottom, port.right };
+
+            put_word(p, 0x00);
+            put_word(p + 2, port.image);
+            p[4] = port.image >> 16;
+            put_word(p + 6, port.width);
+            put_rect(p + 8, bounds);
+            put_rect(p + 0x10, bounds);
+            put_word(p + 0x18, kClipHandle);
+            put_word(p + 0x1C, kVisHandle);
+            put_word(p + 0x48, port.mode);
+            std::memset(p + 0x4A, port.pattern, 32);
+            std::memset(p + 0x6A, 0xFF, 8);
+        }
+
+        const int16_t image_bounds[4] = { 0, 0, 16, 32 };
+
+        put_word(m.ram + kClipHandle, kClipHandle + 0x10);
+        put_word(m.ram + kVisHandle, kClipHandle + 0x20);
+        put_word(m.ram + kClipHandle + 0x10, 10);
+        put_rect(m.ram + kClipHandle + 0x12, clip);
+        put_word(m.ram + kClipHandle + 0x20, 10);
+        put_rect(m.ram + kClipHandle + 0x22, image_bounds);
+
+        for (unsigned int i = 0 ; i < 4 ; ++i) put_rect(m.ram + kRects + i * 8, rects[i]);
+
+        // The stand-in pulls the parameters of the call (8 bytes for
+        // QDStartUp, none for HideCursor and 4 for everything else), and
+        // SetPort keeps the port at offset $40 in the direct page.
+        const auto pull = [](const uint8_t bytes) {
+            Code code;
+
+            if (bytes) {
+                code({ 0xA3, 0x02, 0x83, static_cast<uint8_t>(bytes + 2) })    // LDA 2,S; STA bytes+2,S
+                    ({ 0xA3, 0x01, 0x83, static_cast<uint8_t>(bytes + 1) })    // LDA 1,S; STA bytes+1,S
+                    ({ 0x3B, 0x18, 0x69, bytes, 0x00, 0x1B });                 // TSC; CLC; ADC #bytes; TCS
+            }
+
+            return code({ 0xA9, 0x00, 0x00, 0x18, 0x6B });                     // LDA #$0000; CLC; RTL
+        };
+
+        startup.append(pull(8));
+        set_port({ 0xA3, 0x04, 0x8D }).word(kDirectPage + 0x40)               // LDA 4,S; STA dp+$40
+                ({ 0xA3, 0x06, 0x8D }).word(kDirectPage + 0x42)               // LDA 6,S; STA dp+$42
+                .append(pull(4));
+        hide_cursor.append(pull(0));
+
+        rom({ 0xE0 }).word(0x0204)({ 0xD0, static_cast<uint8_t>(startup.here()) }).append(startup)           // CPX #QDStartUp
+           ({ 0xE0 }).word(0x1B04)({ 0xD0, static_cast<uint8_t>(set_port.here()) }).append(set_port)         // CPX #SetPort
+           ({ 0xE0 }).word(0x9004)({ 0xD0, static_cast<uint8_t>(hide_cursor.here()) }).append(hide_cursor)   // CPX #HideCursor
+           .append(pull(4));
+
+        caller({ 0x18, 0xFB, 0xC2, 0x30 })                  // CLC; XCE; REP #$30
+              ({ 0xF4 }).word(kDirectPage)                  // PEA dp
+              ({ 0xF4, 0x00, 0x00, 0xF4, 0xA0, 0x00 })      // PEA masterSCB; PEA maxWidth
+              ({ 0xF4, 0x00, 0x00 })                        // PEA userID
+              ({ 0xA2 }).word(0x0204)                       // LDX #$0204 (QDStartUp)
+              ({ 0x22, 0x00, 0x00, 0xE1 });                 // JSL $E10000
+
+        // What the image and screen should end up as
+        std::vector<uint8_t> image(16 * 16), screen(0x8000);
+        const Port *current = nullptr;
+
+        for (const Call& call : calls) {
+            if (!call.function) {
+                current = &ports[call.port];
+
+                caller({ 0xF4, 0x00, 0x00, 0xF4 }).word(current->address)   // PEA ^port; PEA port
+                      ({ 0xA2 }).word(0x1B04);                              // LDX #$1B04 (SetPort)
+            }
+            else if (call.function == 0x9004) {
+                caller({ 0xA2 }).word(0x9004);                              // LDX #$9004 (HideCursor)
+            }
+            else {
+                caller({ 0xF4, 0x00, 0x00, 0xF4 }).word(kRects + call.port * 8)   // PEA ^rect; PEA rect
+                      ({ 0xA2 }).word(call.function);                             // LDX #function
+            }
+
+            caller({ 0x22, 0x00, 0x00, 0xE1 });            // JSL $E10000
+
+            if ((call.function != 0x5404) && (call.function != 0x5504)) continue;
+
+            if (!call.native) {
+                ++fallbacks;
+
+                continue;
+            }
+
+            ++natives;
+
+            // Fill the rectangle clipped to the clip region, a pixel at a
+            // time
+            const bool erase = (call.function == 0x5504);
+            const int16_t *r = rects[call.port];
+            std::vector<uint8_t>& out = (current->image == kImage)? image : screen;
+
+            for (int v = std::max(r[0], clip[0]) ; v < std::min(r[2], clip[2]) ; ++v) {
+                for (int h = std::max(r[1], clip[1]) ; h < std::min(r[3], clip[3]) ; ++h) {
+                    uint8_t& b = out[v * current->width + h / 2];
+                    const unsigned int shift = (h & 1)? 0 : 4;
+                    const unsigned int pixel = erase? 0 : current->pattern & 0x0F;
+                    const unsigned int old = (b >> shift) & 0x0F;
+                    const unsigned int val = (current->mode == 2)? old ^ pixel : pixel;
+
+                    b = (b & ~(0x0F << shift)) | (val << shift);
+                }
+            }
+        }
+
+        caller.trap();
+
+        m.load(System::kToolDispatcher, rom.bytes);
+        m.load(0x1000, caller.bytes);
+
+        if (!m.runToTrap(0x1000)) return false;
+
+        if ((qd->getCallsHandled() != natives) || (qd->getROMFallbacks() != fallbacks) || qd->getCallsUnhandled()) {
+            cerr << format("%s: handled %d fallbacks %d unhandled %d\n") % coreName(core)
+                        % qd->getCallsHandled() % qd->getROMFallbacks() % qd->getCallsUnhandled();
+
+            ok = false;
+        }
+
+        for (const auto& area : { std::make_pair(kImage, &image), std::make_pair(kScreen, &screen) }) {
+            const std::vector<uint8_t>& expected = *area.second;
+
+            for (uint32_t i = 0 ; i < expected.size() ; ++i) {
+                if (m.ram[area.first + i] != expected[i]) {
+                    cerr << format("%s: %06X is $%02X, expected $%02X\n") % coreName(core) % (area.first + i)
+                                % (unsigned int) m.ram[area.first + i] % (unsigned int) expected[i];
+
+                    ok = false;
+
+                    break;
+                }
+            }
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * Reads files back from a ProDOS volume image the way ProDOS would.
+ */
+class ProDOSReader {
+    public:
+        VirtualDisk& disk;
+
+        explicit ProDOSReader(VirtualDisk& d) : disk(d) {}
+
+        std::vector<uint8_t> block(const unsigned int b)
+        {
+            std::vector<uint8_t> data(512);
+
+            disk.read(data.data(), b, 1);
+
+            return data;
+        }
+
+        static unsigned int word(const std::vector<uint8_t>& data, const unsigned int offset)
+        {
+            return data[offset] | (data[offset + 1] << 8);
+        }
+
+        // The entries of the directory starting at key, header first, as
+        // their block numbers and offsets
+        std::vector<std::pair<unsigned int, unsigned int>> entries(unsigned int key)
+        {
+            std::vector<std::pair<unsigned int, unsigned int>> result;
+
+            while (key) {
+                const std::vector<uint8_t> data = block(key);
+
+                for (unsigned int offset = 4 ; offset + 0x27 <= 512 ; offset += 0x27) {
+                    if (data[offset]) result.push_back({ key, offset });
+                }
+
+                key = word(data, 2);
+            }
+
+            return result;
+        }
+
+        std::vector<uint8_t> entry(const std::pair<unsigned int, unsigned int>& e)
+        {
+            const std::vector<uint8_t> data = block(e.first);
+
+            return std::vector<uint8_t>(data.begin() + e.second, data.begin() + e.second + 0x27);
+        }
+
+        static string name(const std::vector<uint8_t>& e)
+        {
+            return string(e.begin() + 1, e.begin() + 1 + (e[0] & 0x0F));
+        }
+
+        std::vector<uint8_t> fork(const unsigned int storage_type, const unsigned int key, const uint32_t eof)
+        {
+            std::vector<uint8_t> data;
+
+            const auto indexed = [&](const unsigned int index) {
+                const std::vector<uint8_t> ib = block(index);
+
+                for (unsigned int i = 0 ; (i < 256) && (data.size() < eof) ; ++i) {
+                    const std::vector<uint8_t> b = block(ib[i] | (ib[i + 256] << 8));
+
+                    data.insert(data.end(), b.begin(), b.end());
+                }
+            };
+
+            if (storage_type == 1) {
+                data = block(key);
+            }
+            else if (storage_type == 2) {
+                indexed(key);
+            }
+            else {
+                const std::vector<uint8_t> master = block(key);
+
+                for (unsigned int i = 0 ; (i < 256) && (data.size() < eof) ; ++i) indexed(master[i] | (master[i + 256] << 8));
+            }
+
+            data.resize(eof);
+
+            return data;
+        }
+};
+
+/**
+ * Check the ProDOS volume HostVolume builds from a host directory.
+ */
+static bool checkHostVolume()
+{
+    char dir_template[] = "/tmp/xgs-hostvolume-XXXXXX";
+    const char *dir = mkdtemp(dir_template);
+
+    if (!dir) {
+        cerr << "couldn't make a temporary directory\n";
+
+        return false;
+    }
+
+    const string root = dir;
+
+    // Host files and what each should hold
+    struct File {
+        string   path;
+        uint32_t size;
+    };
+
+    static const File files[] = {
+        { "ReadMe",     600 },      // sapling
+        { "Big",        140000 },   // tree
+        { "Empty",      0 },
+        { "App",        10 },
+        { "App#rsrc",   700 },
+        { "Sub/Tiny",   5 },
+        { "bad name",   10 },       // not a ProDOS name
+    };
+
+    const auto contents = [](const string& path, const uint32_t size) {
+        std::vector<uint8_t> data(size);
+
+        for (uint32_t i = 0 ; i < size ; ++i) data[i] = i * 7 + path.length();
+
+        return data;
+    };
+
+    std::filesystem::create_directory(root + "/Sub");
+
+    for (const File& f : files) {
+        const std::vector<uint8_t> data = contents(f.path, f.size);
+        std::ofstream out(root + "/" + f.path, std::ios::binary);
+
+        out.write(reinterpret_cast<const char *>(data.data()), data.size());
+    }
+
+    // Enough files in Sub for a second directory block
+    for (unsigned int i = 0 ; i < 20 ; ++i) std::ofstream(root + "/Sub/F" + std::to_string(i));
+
+    std::ofstream(root + "/App#info") << "filetype=$B3\nauxtype=$DB07\n";
+
+    HostVolume volume(root, "HOST");
+    ProDOSReader reader(volume);
+    bool ok = true;
+
+    const auto fail = [&](const string& what) {
+        cerr << what << "\n";
+
+        ok = false;
+    };
+
+    volume.open();
+
+    const std::vector<uint8_t> header = reader.entry(reader.entries(2)[0]);
+
+    if ((header[0] != 0xF4) || (reader.name(header) != "HOST") || (reader.word(header, 0x21) != 5)
+            || (reader.word(header, 0x25) != volume.num_chunks) || !volume.locked) {
+        fail("bad volume directory header");
+    }
+
+    std::vector<string> names;
+
+    for (const auto& e : reader.entries(2)) names.push_back(reader.name(reader.entry(e)));
+
+    if (names != std::vector<string>({ "HOST", "APP", "BIG", "EMPTY", "README", "SUB" })) fail("wrong files on the volume");
+
+    for (const auto& e : reader.entries(2)) {
+        const std::vector<uint8_t> entry = reader.entry(e);
+        const string name = reader.name(entry);
+        const unsigned int storage_type = entry[0] >> 4;
+        const unsigned int key = reader.word(entry, 0x11);
+        const uint32_t eof = reader.word(entry, 0x15) | (entry[0x17] << 16);
+
+        if (name == "HOST") continue;
+
+        if (reader.word(entry, 0x25) != 2) fail(name + " has the wrong header pointer");
+
+        if (name == "SUB") {
+            const auto sub = reader.entries(key);
+            const std::vector<uint8_t> sub_header = reader.entry(sub[0]);
+
+            if ((storage_type != 0x0D) || (sub.size() != 22) || (reader.word(entry, 0x13) != 2)
+                    || (reader.word(sub_header, 0x23) != e.first) || (sub_header[0x25] != (e.second - 4) / 0x27 + 1)) {
+                fail("bad subdirectory");
+            }
+
+            continue;
+        }
+
+        if (name == "APP") {
+            const std::vector<uint8_t> ext = reader.block(key);
+            const std::vector<uint8_t> data = reader.fork(ext[0], reader.word(ext, 1), reader.word(ext, 5) | (ext[7] << 16));
+            const std::vector<uint8_t> rsrc = reader.fork(ext[0x100], reader.word(ext, 0x101), reader.word(ext, 0x105) | (ext[0x107] << 16));
+
+            if ((storage_type != 0x05) || (entry[0x10] != 0xB3) || (reader.word(entry, 0x1F) != 0xDB07)
+                    || (data != contents("App", 10)) || (rsrc != contents("App#rsrc", 700))) {
+                fail("bad extended file");
+            }
+
+            continue;
+        }
+
+        const string path = (name == "BIG")? "Big" : (name == "EMPTY")? "Empty" : "ReadMe";
+        const uint32_t size = (name == "BIG")? 140000 : (name == "EMPTY")? 0 : 600;
+        const unsigned int expected_type = (size <= 512)? 1 : (size <= 131072)? 2 : 3;
+
+        if ((storage_type != expected_type) || (eof != size) || (reader.fork(storage_type, key, eof) != contents(path, size))) {
+            fail("bad file " + name);
+        }
+    }
+
+    uint8_t buffer[512];
+
+    try {
+        volume.write(buffer, 2, 1);
+
+        fail("host volume was written");
+    }
+    catch (std::runtime_error& e) {
+    }
+
+    volume.close();
+
+    std::error_code ec;
+
+    std::filesystem::remove_all(root, ec);
+
+    return ok;
+}
+
+/**
+ * Check that an IRQ which is waiting while I is set gets taken as soon as
+ * an instruction clears I, rather than at the end of the slice.
+ */
+static bool checkIRQ()
+{
+    enum { kCLI, kPLP, kRTI, kREP };
+
+    static const char *names[] = { "CLI", "PLP", "RTI", "REP #$04" };
+
+    // Where RTI returns to; it and the code after every other way of
+    // clearing I jump to a loop that counts in $10 until the IRQ is taken.
+    const uint16_t loop = 0x1100;
+
+    bool ok = true;
+
+    for (const auto core : kCores) {
+        for (const bool native : { false, true }) {
+            for (const int how : { kCLI, kPLP, kRTI, kREP }) {
+                TestMachine m(core);
+                Code code;
+                uint16_t resume = loop;
+
+                code({ 0x78, 0xA2, 0xFF, 0x9A });               // SEI; LDX #$FF; TXS
+                if (native) code({ 0x18, 0xFB });               // CLC; XCE
+
+                switch (how) {
+                    case kCLI:
+                        code({ 0x58 });                         // CLI
+                        break;
+                    case kPLP:
+                        code({ 0xA9, 0x30, 0x48, 0x28 });       // LDA #$30; PHA; PLP
+                        break;
+                    case kRTI:
+                        if (native) code({ 0xA9, 0x00, 0x48 }); // LDA #0; PHA
+                        code({ 0xA9, loop >> 8, 0x48 })         // LDA #>loop; PHA
+                            ({ 0xA9, loop & 0xFF, 0x48 })       // LDA #<loop; PHA
+                            ({ 0xA9, 0x30, 0x48, 0x40 });       // LDA #$30; PHA; RTI
+                        break;
+                    case kREP:
+                        code({ 0xC2, 0x04 });                   // REP #$04
+                        break;
+                }
+
+                if (how != kRTI) resume = 0x1000 + code.here();
+
+                code({ 0x4C }).word(loop);                      // JMP loop
+
+                m.load(0x1000, code.bytes);
+                m.load(loop, Code()({ 0xE6, 0x10, 0x80, 0xFC }).bytes);   // INC $10; BRA loop
+                m.load(0x2000, Code().trap().bytes);
+
+                // Vectors are fetched from bank $FF
+                m.ram[native? 0xFFFFEE : 0xFFFFFE] = 0x00;
+                m.ram[native? 0xFFFFEF : 0xFFFFFF] = 0x20;
+
+                m.cpu->setIRQ(true);
+
+                if (!m.runToTrap(0x1000)) return false;
+
+                // The IRQ pushed the return address below PBR in native mode
+                const uint16_t pushed = m.word(native? 0x01FD : 0x01FE);
+
+                if ((pushed != resume) || m.ram[0x10]) {
+                    cerr << format("%s: %s in %s mode: IRQ returns to %04X (expected %04X) after %d loops\n")
+                                % coreName(core) % names[how] % (native? "native" : "emulation")
+                                % pushed % resume % (unsigned int) m.ram[0x10];
+
+                    ok = false;
+                }
+            }
+        }
+    }
+
+    return ok;
+}
+
+int main(const int argc, const char **argv)
+{
+    static const struct {
+        const char *name;
+        bool (*check)();
+    } checks[] = {
+        { "decimal",    checkDecimal },
+        { "blockcache", checkBlockCache },
+        { "fused",      checkFused },
+        { "blockmove",  checkBlockMove },
+        { "toolcompare", checkToolCompare },
+        { "memorymanager", checkMemoryManager },
+        { "sane",       checkSANE },
+        { "quickdraw",  checkQuickDraw },
+        { "hostvolume", checkHostVolume },
+        { "irq",        checkIRQ },
+    };
+
+    if (argc != 2) {
+        cerr << "usage: checks816 <check>\n";
+
+        return 2;
+    }
+
+    for (const auto& c : checks) {
+        if (string(argv[1]) == c.name) {
+            const bool ok = c.check();
+
+            cerr << format("%s: %s\n") % c.name % (ok? "passed" : "FAILED");
+
+            return ok? 0 : 1;
+        }
+    }
+
+    cerr << format("unknown check \"%s\"\n") % argv[1];
+
+    return 2;
+}
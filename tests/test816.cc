@@ -18,7 +18,9 @@ int main (const int argc, const char **argv)
 {
     TestRunner *t = new TestRunner();
 
-    if (t->setup(argc, argv)) {
-        t->run();
+    if (!t->setup(argc, argv)) {
+        return 1;
     }
+
+    return t->run()? 0 : 1;
 }
@@ -0,0 +1,246 @@
+/**
+ * XGS: The Linux GS Emulator
+ * Written and Copyright (C) 1996 - 2016 by Joshua M. Thompson
+ *
+ * You are free to distribute this code for non-commercial purposes
+ * I ask only that you notify me of any changes you make to the code
+ * Commercial use is prohibited without my written permission
+ */
+
+/*
+ * covmap maps a coverage file written by xgs --coverage back onto the
+ * ROM image, or onto a binary loaded at a known address, and reports
+ * which parts of it were executed:
+ *
+ *   covmap [-m mode] [-l] <coverage file> rom <rom file>
+ *   covmap [-m mode] <coverage file> bin <file> <bank/address>
+ *
+ * -m restricts the report to one CPU mode (0 = m0x0, 1 = m0x1, 2 = m1x0,
+ * 3 = m1x1, 4 = emulation) if the coverage was recorded per mode.
+ *
+ * -l also counts code executed from $C100-$FFFF in banks $00, $01, $E0,
+ * and $E1 as running from the same addresses in bank $FF, which is where
+ * that code comes from when the internal ROM is switched in (it is not if
+ * the program was running from language card RAM).
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using std::cerr;
+using std::endl;
+using std::string;
+using std::uint8_t;
+using std::uint32_t;
+
+static const unsigned int kNumModes    = 5;
+static const unsigned int kBitmapBytes = (1 << 24) / 8;
+static const unsigned int kPageBytes   = 256 / 8;
+
+class CoverageMap {
+    public:
+        std::vector<uint8_t> bits = std::vector<uint8_t>(kBitmapBytes);
+
+        bool isSet(const uint32_t ea) const { return bits[ea >> 3] & (1 << (ea & 7)); }
+
+        void set(const uint32_t ea) { bits[ea >> 3] |= 1 << (ea & 7); }
+
+        // Load a coverage file, keeping only the given mode if it is
+        // not negative.
+        bool load(const string&, const int);
+};
+
+static unsigned int readWord(std::istream& in)
+{
+    unsigned int lo = in.get();
+
+    return lo | (in.get() << 8);
+}
+
+bool CoverageMap::load(const string& filename, const int mode)
+{
+    std::ifstream in(filename, std::ifstream::binary);
+    char magic[4];
+
+    if (!in.read(magic, 4) || std::memcmp(magic, "XCOV", 4)) {
+        cerr << filename << ": not a coverage file" << endl;
+
+        return false;
+    }
+
+    const unsigned int version     = in.get();
+    const unsigned int num_bitmaps = in.get();
+
+    readWord(in);
+
+    if (version != 1) {
+        cerr << filename << ": unsupported version " << version << endl;
+
+        return false;
+    }
+
+    if ((mode >= 0) && (num_bitmaps != kNumModes)) {
+        cerr << filename << ": coverage was not recorded per mode" << endl;
+
+        return false;
+    }
+
+    for (unsigned int i = 0 ; i < num_bitmaps ; ++i) {
+        const uint32_t num_pages = readWord(in) | (readWord(in) << 16);
+
+        for (uint32_t p = 0 ; p < num_pages ; ++p) {
+            const unsigned int page = readWord(in);
+            uint8_t page_bits[kPageBytes];
+
+            if (!in.read(reinterpret_cast<char *>(page_bits), kPageBytes)) {
+                cerr << filename << ": truncated" << endl;
+
+                return false;
+            }
+
+            if ((mode >= 0) && (static_cast<unsigned int>(mode) != i)) continue;
+
+            for (unsigned int j = 0 ; j < kPageBytes ; ++j) {
+                bits[page * kPageBytes + j] |= page_bits[j];
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Report which bytes of an image loaded at base were executed, as
+ * ranges of offsets into the image.
+ */
+static void report(const CoverageMap& cov, const string& name, const uint32_t base, const size_t size)
+{
+    size_t executed = 0;
+
+    for (size_t i = 0 ; i < size ; ++i) {
+        if (cov.isSet((base + i) & 0xFFFFFF)) ++executed;
+    }
+
+    std::printf("%s (%zu bytes at %02X/%04X): %zu bytes executed (%.2f%%)\n\n",
+        name.c_str(), size, base >> 16, base & 0xFFFF, executed, size? (100.0 * executed / size) : 0.0);
+
+    std::printf("  offset         address              bytes\n");
+
+    for (size_t i = 0 ; i < size ; ) {
+        if (!cov.isSet((base + i) & 0xFFFFFF)) {
+            ++i;
+
+            continue;
+        }
+
+        size_t end = i;
+
+        while ((end < size) && cov.isSet((base + end) & 0xFFFFFF)) ++end;
+
+        const uint32_t first = (base + i) & 0xFFFFFF;
+        const uint32_t last  = (base + end - 1) & 0xFFFFFF;
+
+        std::printf("  %06zX-%06zX  %02X/%04X-%02X/%04X  %8zu\n",
+            i, end - 1, first >> 16, first & 0xFFFF, last >> 16, last & 0xFFFF, end - i);
+
+        i = end;
+    }
+}
+
+static std::vector<uint8_t> loadFile(const string& filename)
+{
+    std::ifstream in(filename, std::ifstream::binary);
+
+    if (!in) {
+        cerr << filename << ": can't open" << endl;
+
+        std::exit(1);
+    }
+
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static void usage(const char *argv0)
+{
+    cerr << "Usage: " << argv0 << " [-m mode] [-l] <coverage file> rom <rom file>" << endl;
+    cerr << "       " << argv0 << " [-m mode] <coverage file> bin <file> <bank/address>" << endl;
+
+    std::exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    int mode = -1;
+    bool fold_lc = false;
+    int arg = 1;
+
+    for ( ; (arg < argc) && (argv[arg][0] == '-') ; ++arg) {
+        if (!std::strcmp(argv[arg], "-m") && (arg + 1 < argc)) {
+            mode = std::atoi(argv[++arg]);
+
+            if ((mode < 0) || (mode >= static_cast<int>(kNumModes))) usage(argv[0]);
+        }
+        else if (!std::strcmp(argv[arg], "-l")) {
+            fold_lc = true;
+        }
+        else {
+            usage(argv[0]);
+        }
+    }
+
+    if (argc - arg < 3) usage(argv[0]);
+
+    const string cov_file = argv[arg];
+    const string kind     = argv[arg + 1];
+    const string image    = argv[arg + 2];
+
+    CoverageMap cov;
+
+    if (!cov.load(cov_file, mode)) return 1;
+
+    const std::vector<uint8_t> contents = loadFile(image);
+
+    if (kind == "rom") {
+        if ((contents.size() != 131072) && (contents.size() != 262144)) {
+            cerr << image << ": not a ROM 01 or ROM 03 image" << endl;
+
+            return 1;
+        }
+
+        if (fold_lc) {
+            for (const uint32_t bank : { 0x00, 0x01, 0xE0, 0xE1 }) {
+                for (uint32_t addr = 0xC100 ; addr < 0x10000 ; ++addr) {
+                    if (cov.isSet((bank << 16) | addr)) cov.set(0xFF0000 | addr);
+                }
+            }
+        }
+
+        // The ROM occupies the top banks of the address space
+        report(cov, image, 0x1000000 - contents.size(), contents.size());
+    }
+    else if (kind == "bin") {
+        if (argc - arg < 4) usage(argv[0]);
+
+        unsigned int bank, addr;
+
+        if (std::sscanf(argv[arg + 3], "%x/%x", &bank, &addr) != 2) {
+            cerr << argv[arg + 3] << ": expected a load address like 06/2000" << endl;
+
+            return 1;
+        }
+
+        report(cov, image, ((bank & 0xFF) << 16) | (addr & 0xFFFF), contents.size());
+    }
+    else {
+        usage(argv[0]);
+    }
+
+    return 0;
+}
@@ -198,6 +198,13 @@ class VGC : public Device {
 
             return locs;
         }
+
+        std::vector<unsigned int>& ioPollList()
+        {
+            static std::vector<unsigned int> locs = { 0x2E };
+
+            return locs;
+        }
 };
 
 #endif // VGC_H_